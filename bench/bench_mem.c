@@ -0,0 +1,323 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#include "cfifo.h"
+#include "cfifo_mem.h"
+
+/*
+ * Buffer provisioning benchmark, see cfifo_mem_alloc().
+ *
+ * A large fifo is streamed through by one thread: a batch is written,
+ * then read back, so the positions sweep the whole buffer once per lap.
+ * The first lap touches every page for the first time, the second one runs
+ * on a warm buffer. For each lap the latency of a write plus read batch is
+ * reported as p50/p99/max, with the data TLB read misses per 1000 items
+ * from perf_event_open() (empty when the kernel does not allow it).
+ *
+ * Buffers:
+ *   malloc          plain malloc(), the usual hand made setup
+ *   mmap            cfifo_mem_alloc() without options
+ *   thp             transparent huge pages
+ *   hugetlb         explicit huge pages, needs vm.nr_hugepages
+ *   thp_prefault    transparent huge pages, locked and pre-faulted
+ *   hugetlb_prefault
+ *
+ * "granted" lists the CFIFO_MEM_* options that took effect, setup_ms the
+ * time spent in the allocation, pre-faulting included.
+ *
+ * Usage: bench_mem [-j] [-s size in MB] [-i item size]
+ */
+
+#define DEFAULT_MB      256
+#define DEFAULT_ITEM    64
+#define BATCH           64
+
+struct buffer_kind {
+    const char      *p_name;
+    int             use_malloc;
+    unsigned int    flags;
+};
+
+static const struct buffer_kind kinds[] = {
+    {"malloc", 1, 0},
+    {"mmap", 0, 0},
+    {"thp", 0, CFIFO_MEM_THP},
+    {"hugetlb", 0, CFIFO_MEM_HUGETLB},
+    {"thp_prefault", 0, CFIFO_MEM_THP | CFIFO_MEM_LOCK | CFIFO_MEM_PREFAULT},
+    {"hugetlb_prefault", 0, CFIFO_MEM_HUGETLB | CFIFO_MEM_LOCK | CFIFO_MEM_PREFAULT}
+};
+
+static int json;
+static int num_results;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+static int compare_u64(const void *p_a, const void *p_b)
+{
+    uint64_t a = *(const uint64_t *) p_a;
+    uint64_t b = *(const uint64_t *) p_b;
+
+    return (a > b) - (a < b);
+}
+
+static double percentile(const uint64_t *p_sorted, uint64_t num, double p)
+{
+    return (double) p_sorted[(uint64_t) ((double) (num - 1) * p)];
+}
+
+/* Data TLB read miss counter of this thread, -1 if not available. */
+static int dtlb_open(void)
+{
+#if defined(__linux__)
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    return -1;
+#endif
+}
+
+static void dtlb_start(int fd)
+{
+#if defined(__linux__)
+    if (fd >= 0)
+    {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#else
+    (void) fd;
+#endif
+}
+
+/* Misses since dtlb_start(), -1 if not available. */
+static double dtlb_stop(int fd)
+{
+#if defined(__linux__)
+    uint64_t count;
+
+    if (fd >= 0)
+    {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &count, sizeof(count)) == (ssize_t) sizeof(count))
+        {
+            return (double) count;
+        }
+    }
+#else
+    (void) fd;
+#endif
+    return -1;
+}
+
+static void print_value(double value)
+{
+    if (value < 0)
+    {
+        /* Empty in CSV. */
+        if (json)
+        {
+            printf("null");
+        }
+    }
+    else
+    {
+        printf("%.1f", value);
+    }
+}
+
+static void granted_names(unsigned int flags, char *p_out, size_t out_size)
+{
+    snprintf(p_out, out_size, "%s%s%s%s%s",
+             (flags & CFIFO_MEM_HUGETLB) ? "hugetlb+" : "",
+             (flags & CFIFO_MEM_THP) ? "thp+" : "",
+             (flags & CFIFO_MEM_LOCK) ? "lock+" : "",
+             (flags & CFIFO_MEM_PREFAULT) ? "prefault+" : "",
+             (0 == flags) ? "none+" : "");
+    /* Drop the trailing separator. */
+    p_out[strlen(p_out) - 1] = '\0';
+}
+
+static void print_result(const char *p_kind, const char *p_granted,
+                         size_t size_mb, double setup_ms, int lap,
+                         double p50_ns, double p99_ns, double max_ns,
+                         double dtlb_per_kitem)
+{
+    if (json)
+    {
+        printf("%s\n  {\"buffer\": \"%s\", \"granted\": \"%s\", \"size_mb\": %zu, "
+               "\"setup_ms\": %.1f, \"lap\": %d, \"p50_ns\": %.1f, "
+               "\"p99_ns\": %.1f, \"max_ns\": %.1f, \"dtlb_misses_per_kitem\": ",
+               (num_results > 0) ? "," : "[",
+               p_kind, p_granted, size_mb, setup_ms, lap, p50_ns, p99_ns, max_ns);
+        print_value(dtlb_per_kitem);
+        printf("}");
+    }
+    else
+    {
+        if (0 == num_results)
+        {
+            printf("buffer,granted,size_mb,setup_ms,lap,p50_ns,p99_ns,max_ns,"
+                   "dtlb_misses_per_kitem\n");
+        }
+        printf("%s,%s,%zu,%.1f,%d,%.1f,%.1f,%.1f,",
+               p_kind, p_granted, size_mb, setup_ms, lap, p50_ns, p99_ns, max_ns);
+        print_value(dtlb_per_kitem);
+        printf("\n");
+    }
+    num_results++;
+    fflush(stdout);
+}
+
+static void run_kind(const struct buffer_kind *p_kind, size_t size_mb,
+                     size_t item_size, uint8_t *p_items, uint64_t *p_lat)
+{
+    size_t capacity = size_mb * 1024 * 1024 / item_size;
+    size_t buf_size = capacity * item_size;
+    uint64_t num_batches = capacity / BATCH;
+    unsigned int flags = p_kind->flags;
+    struct cfifo_s fifo;
+    char granted[64];
+    uint8_t *p_buf;
+    double setup_ms;
+    double misses;
+    uint64_t start;
+    uint64_t b;
+    int fd = dtlb_open();
+    int lap;
+
+    start = now_ns();
+    if (p_kind->use_malloc)
+    {
+        p_buf = malloc(buf_size);
+    }
+    else if (cfifo_mem_alloc(&p_buf, buf_size, &flags) != CFIFO_SUCCESS)
+    {
+        p_buf = NULL;
+    }
+    setup_ms = (double) (now_ns() - start) / 1e6;
+    if (NULL == p_buf)
+    {
+        fprintf(stderr, "%s: out of memory\n", p_kind->p_name);
+        return;
+    }
+    granted_names(flags, granted, sizeof(granted));
+
+    (void) cfifo_init(&fifo, p_buf, capacity, item_size, buf_size);
+
+    for (lap = 1; lap <= 2; lap++)
+    {
+        dtlb_start(fd);
+        for (b = 0; b < num_batches; b++)
+        {
+            start = now_ns();
+            (void) cfifo_write_bulk(&fifo, p_items, BATCH);
+            (void) cfifo_read_bulk(&fifo, p_items, BATCH);
+            p_lat[b] = now_ns() - start;
+        }
+        misses = dtlb_stop(fd);
+
+        qsort(p_lat, num_batches, sizeof(uint64_t), compare_u64);
+        print_result(p_kind->p_name, granted, size_mb, setup_ms, lap,
+                     percentile(p_lat, num_batches, 0.50),
+                     percentile(p_lat, num_batches, 0.99),
+                     (double) p_lat[num_batches - 1],
+                     (misses < 0) ? -1 : misses * 1000.0 / ((double) num_batches * BATCH));
+    }
+
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+    if (p_kind->use_malloc)
+    {
+        free(p_buf);
+    }
+    else
+    {
+        cfifo_mem_free(p_buf, buf_size);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    size_t size_mb = DEFAULT_MB;
+    size_t item_size = DEFAULT_ITEM;
+    uint8_t *p_items;
+    uint64_t *p_lat;
+    size_t i;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "js:i:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'j':
+            json = 1;
+            break;
+        case 's':
+            size_mb = (size_t) atol(optarg);
+            break;
+        case 'i':
+            item_size = (size_t) atol(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-j] [-s size in MB] [-i item size]\n",
+                    argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (0 == size_mb || 0 == item_size ||
+        size_mb * 1024 * 1024 / item_size < BATCH)
+    {
+        fprintf(stderr, "buffer too small for a %d item batch\n", BATCH);
+        return EXIT_FAILURE;
+    }
+
+    p_items = calloc(BATCH, item_size);
+    p_lat = malloc((size_mb * 1024 * 1024 / item_size / BATCH) * sizeof(uint64_t));
+    if (NULL == p_items || NULL == p_lat)
+    {
+        return EXIT_FAILURE;
+    }
+
+    for (i = 0; i < sizeof(kinds) / sizeof(kinds[0]); i++)
+    {
+        run_kind(&kinds[i], size_mb, item_size, p_items, p_lat);
+    }
+
+    if (json)
+    {
+        printf("\n]\n");
+    }
+    free(p_items);
+    free(p_lat);
+
+    return 0;
+}
@@ -0,0 +1,203 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "cfifo.h"
+#include "cfifo_mpmc.h"
+
+/*
+ * MPMC scaling benchmark.
+ *
+ * For 1, 2, 4, ... 32 threads on each side, N producers put and N consumers
+ * get a fixed total number of items, once through a cfifo_mpmc_t and once
+ * through a cfifo_t protected by a mutex. Reports items per second.
+ *
+ * Usage: bench_mpmc [total items] [max threads per side]
+ */
+
+#define CAPACITY    1024
+#define SPIN_LIMIT  64
+
+enum bench_kind {
+    BENCH_MPMC,
+    BENCH_MUTEX
+};
+
+struct bench_ctx {
+    enum bench_kind     kind;
+    cfifo_mpmc_t        mpmc;
+    cfifo_t             fifo;
+    pthread_mutex_t     lock;
+    uint64_t            items_per_thread;
+    pthread_barrier_t   start;
+};
+
+struct thread_arg {
+    struct bench_ctx    *p_ctx;
+    int                 cpu;
+};
+
+static void pin_thread(int cpu)
+{
+    cpu_set_t set;
+    long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (num_cpus <= 0)
+    {
+        return;
+    }
+    CPU_ZERO(&set);
+    CPU_SET(cpu % num_cpus, &set);
+    (void) pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+static void backoff(unsigned int *p_spins)
+{
+    if (++(*p_spins) >= SPIN_LIMIT)
+    {
+        *p_spins = 0;
+        sched_yield();
+    }
+}
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static cfifo_ret_t bench_put(struct bench_ctx *p_ctx, const uint64_t *p_item)
+{
+    cfifo_ret_t ret;
+
+    if (BENCH_MPMC == p_ctx->kind)
+    {
+        return cfifo_mpmc_put(p_ctx->mpmc, p_item);
+    }
+    pthread_mutex_lock(&p_ctx->lock);
+    ret = cfifo_put(p_ctx->fifo, p_item);
+    pthread_mutex_unlock(&p_ctx->lock);
+    return ret;
+}
+
+static cfifo_ret_t bench_get(struct bench_ctx *p_ctx, uint64_t *p_item)
+{
+    cfifo_ret_t ret;
+
+    if (BENCH_MPMC == p_ctx->kind)
+    {
+        return cfifo_mpmc_get(p_ctx->mpmc, p_item);
+    }
+    pthread_mutex_lock(&p_ctx->lock);
+    ret = cfifo_get(p_ctx->fifo, p_item);
+    pthread_mutex_unlock(&p_ctx->lock);
+    return ret;
+}
+
+static void *producer(void *arg)
+{
+    struct thread_arg *p_arg = (struct thread_arg *) arg;
+    unsigned int spins = 0;
+    uint64_t i;
+
+    pin_thread(p_arg->cpu);
+    pthread_barrier_wait(&p_arg->p_ctx->start);
+    for (i = 0; i < p_arg->p_ctx->items_per_thread; i++)
+    {
+        while (bench_put(p_arg->p_ctx, &i) != CFIFO_SUCCESS)
+        {
+            backoff(&spins);
+        }
+    }
+    return NULL;
+}
+
+static void *consumer(void *arg)
+{
+    struct thread_arg *p_arg = (struct thread_arg *) arg;
+    unsigned int spins = 0;
+    uint64_t item;
+    uint64_t i;
+
+    pin_thread(p_arg->cpu);
+    pthread_barrier_wait(&p_arg->p_ctx->start);
+    for (i = 0; i < p_arg->p_ctx->items_per_thread; i++)
+    {
+        while (bench_get(p_arg->p_ctx, &item) != CFIFO_SUCCESS)
+        {
+            backoff(&spins);
+        }
+    }
+    return NULL;
+}
+
+static double run(struct bench_ctx *p_ctx, int num_threads, uint64_t total)
+{
+    pthread_t *p_threads = malloc(2 * num_threads * sizeof(pthread_t));
+    struct thread_arg *p_args = malloc(2 * num_threads * sizeof(struct thread_arg));
+    double start;
+    int i;
+
+    p_ctx->items_per_thread = total / num_threads;
+    pthread_barrier_init(&p_ctx->start, NULL, 2 * num_threads + 1);
+
+    for (i = 0; i < 2 * num_threads; i++)
+    {
+        p_args[i].p_ctx = p_ctx;
+        p_args[i].cpu = i;
+        pthread_create(&p_threads[i], NULL,
+                       (i & 1) ? consumer : producer, &p_args[i]);
+    }
+
+    pthread_barrier_wait(&p_ctx->start);
+    start = now_sec();
+    for (i = 0; i < 2 * num_threads; i++)
+    {
+        pthread_join(p_threads[i], NULL);
+    }
+    start = now_sec() - start;
+
+    pthread_barrier_destroy(&p_ctx->start);
+    free(p_threads);
+    free(p_args);
+
+    return (double) (p_ctx->items_per_thread * num_threads) / start;
+}
+
+int main(int argc, char *argv[])
+{
+    struct bench_ctx ctx;
+    uint64_t total = (argc > 1) ? strtoull(argv[1], NULL, 0) : 1000000;
+    int max_threads = (argc > 2) ? atoi(argv[2]) : 32;
+    int n;
+
+    CFIFO_MPMC_CREATE_STATIC(mpmc, uint64_t, CAPACITY);
+    CFIFO_CREATE_STATIC(fifo, uint64_t, CAPACITY);
+
+    ctx.mpmc = mpmc;
+    ctx.fifo = fifo;
+    pthread_mutex_init(&ctx.lock, NULL);
+
+    printf("threads_per_side,mpmc_items_per_s,mutex_items_per_s\n");
+    for (n = 1; n <= max_threads; n *= 2)
+    {
+        double mpmc_rate;
+        double mutex_rate;
+
+        ctx.kind = BENCH_MPMC;
+        mpmc_rate = run(&ctx, n, total);
+        ctx.kind = BENCH_MUTEX;
+        mutex_rate = run(&ctx, n, total);
+        printf("%d,%.0f,%.0f\n", n, mpmc_rate, mutex_rate);
+    }
+
+    pthread_mutex_destroy(&ctx.lock);
+
+    return 0;
+}
@@ -0,0 +1,186 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "cfifo.h"
+
+/*
+ * SPSC benchmark.
+ *
+ * ping-pong: two fifos, the first thread puts an item and waits for it to
+ *            come back on the second fifo. Reports round trips per second.
+ * stream:    the first thread puts items as fast as it can, the second one
+ *            gets them. Reports items per second.
+ *
+ * Usage: bench_spsc [iterations] [producer cpu] [consumer cpu]
+ */
+
+#define CAPACITY    1024
+#define SPIN_LIMIT  1024
+
+struct bench_ctx {
+    cfifo_t     to_consumer;
+    cfifo_t     to_producer;
+    uint64_t    iterations;
+    int         cpu;
+};
+
+static void pin_thread(int cpu)
+{
+    cpu_set_t set;
+
+    if (cpu < 0)
+    {
+        return;
+    }
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    /* Not fatal, e.g. fewer cores than requested. */
+    (void) pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+static void backoff(unsigned int *p_spins)
+{
+    if (++(*p_spins) >= SPIN_LIMIT)
+    {
+        *p_spins = 0;
+        sched_yield();
+    }
+}
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static void *pingpong_echo(void *arg)
+{
+    struct bench_ctx *p_ctx = (struct bench_ctx *) arg;
+    unsigned int spins = 0;
+    uint64_t item;
+    uint64_t i;
+
+    pin_thread(p_ctx->cpu);
+    for (i = 0; i < p_ctx->iterations; i++)
+    {
+        while (cfifo_get(p_ctx->to_consumer, &item) != CFIFO_SUCCESS)
+        {
+            backoff(&spins);
+        }
+        while (cfifo_put(p_ctx->to_producer, &item) != CFIFO_SUCCESS)
+        {
+            backoff(&spins);
+        }
+    }
+    return NULL;
+}
+
+static void *stream_consumer(void *arg)
+{
+    struct bench_ctx *p_ctx = (struct bench_ctx *) arg;
+    unsigned int spins = 0;
+    uint64_t item;
+    uint64_t i;
+
+    pin_thread(p_ctx->cpu);
+    for (i = 0; i < p_ctx->iterations; i++)
+    {
+        while (cfifo_get(p_ctx->to_consumer, &item) != CFIFO_SUCCESS)
+        {
+            backoff(&spins);
+        }
+        if (item != i)
+        {
+            fprintf(stderr, "stream: got %lu, expected %lu\n",
+                    (unsigned long) item, (unsigned long) i);
+            exit(EXIT_FAILURE);
+        }
+    }
+    return NULL;
+}
+
+static double run_pingpong(struct bench_ctx *p_ctx, int cpu)
+{
+    pthread_t thread;
+    unsigned int spins = 0;
+    uint64_t item;
+    uint64_t i;
+    double start;
+
+    pthread_create(&thread, NULL, pingpong_echo, p_ctx);
+    pin_thread(cpu);
+
+    start = now_sec();
+    for (i = 0; i < p_ctx->iterations; i++)
+    {
+        item = i;
+        while (cfifo_put(p_ctx->to_consumer, &item) != CFIFO_SUCCESS)
+        {
+            backoff(&spins);
+        }
+        while (cfifo_get(p_ctx->to_producer, &item) != CFIFO_SUCCESS)
+        {
+            backoff(&spins);
+        }
+    }
+    pthread_join(thread, NULL);
+
+    return (double) p_ctx->iterations / (now_sec() - start);
+}
+
+static double run_stream(struct bench_ctx *p_ctx, int cpu)
+{
+    pthread_t thread;
+    unsigned int spins = 0;
+    uint64_t item;
+    double start;
+
+    pthread_create(&thread, NULL, stream_consumer, p_ctx);
+    pin_thread(cpu);
+
+    start = now_sec();
+    for (item = 0; item < p_ctx->iterations; item++)
+    {
+        while (cfifo_put(p_ctx->to_consumer, &item) != CFIFO_SUCCESS)
+        {
+            backoff(&spins);
+        }
+    }
+    pthread_join(thread, NULL);
+
+    return (double) p_ctx->iterations / (now_sec() - start);
+}
+
+int main(int argc, char *argv[])
+{
+    struct bench_ctx ctx;
+    int producer_cpu = 0;
+
+    CFIFO_CREATE_STATIC(to_consumer, uint64_t, CAPACITY);
+    CFIFO_CREATE_STATIC(to_producer, uint64_t, CAPACITY);
+
+    ctx.to_consumer = to_consumer;
+    ctx.to_producer = to_producer;
+    ctx.iterations = (argc > 1) ? strtoull(argv[1], NULL, 0) : 1000000;
+    producer_cpu = (argc > 2) ? atoi(argv[2]) : 0;
+    ctx.cpu = (argc > 3) ? atoi(argv[3]) : 1;
+
+    printf("layout: %s, sizeof(struct cfifo_s): %lu\n",
+#ifdef CFIFO_SEPARATE_CACHE_LINES
+           "separate cache lines",
+#else
+           "packed",
+#endif
+           (unsigned long) sizeof(struct cfifo_s));
+    printf("ping-pong: %.0f round trips/s\n", run_pingpong(&ctx, producer_cpu));
+    printf("stream:    %.0f items/s\n", run_stream(&ctx, producer_cpu));
+
+    return 0;
+}
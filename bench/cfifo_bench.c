@@ -0,0 +1,736 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "cfifo.h"
+#include "cfifo_inline.h"
+#include "cfifo_mem.h"
+
+/*
+ * Benchmark suite, for comparing builds and commits.
+ *
+ * put_get:    single thread, cfifo_put a batch of items then cfifo_get them
+ *             back, for every item size and capacity. Reports puts plus
+ *             gets per second.
+ * write_read: the same with one cfifo_write/cfifo_read call per batch.
+ *             Reports items written plus items read per second.
+ * stream:     a producer thread puts items as fast as it can and a
+ *             consumer thread on another core gets them. Reports items
+ *             per second.
+ * pingpong:   an item goes to the other thread and back through two fifos.
+ *             Reports round trips per second and the round trip latency
+ *             percentiles.
+ *
+ * The calling thread stays on the producer cpu throughout.
+ *
+ * numa (-n, instead of the above): stream between a cpu of the producer
+ * node and a cpu of the consumer node, for every pair of nodes with cpus,
+ * with the fifo header and buffer bound to the producer's node and to the
+ * consumer's node. Reports items per second, and whether the binding took
+ * effect. A single node machine gives the same-node numbers only.
+ *
+ * Every benchmark runs against a plain cfifo_t ("cfifo"), against the same
+ * fifo through the inline calls of cfifo_inline.h ("inline") and against a
+ * cfifo_t whose calls are protected by a mutex ("mutex") as the baseline.
+ * Results are printed as CSV, or as JSON with -j.
+ *
+ * Usage: cfifo_bench [-j] [-q] [-n] [-p producer cpu] [-c consumer cpu]
+ *
+ *   -j  JSON instead of CSV
+ *   -q  quick run, 1/16 of the work per data point
+ *   -n  numa benchmark only
+ */
+
+#define MAX_ITEM_SIZE   4096
+#define MAX_CAPACITY    (1024 * 1024)
+/* Item size and capacity pairs with a larger buffer are skipped. */
+#define MAX_BUF_BYTES   (64 * 1024 * 1024)
+/* Items moved per batch in the single thread benchmarks. */
+#define MAX_BATCH       64
+/* Items moved per data point, fewer for large items. */
+#define WORK_ITEMS      (1024 * 1024)
+#define WORK_BYTES      (256 * 1024 * 1024)
+#define STREAM_CAPACITY 1024
+#define PINGPONG_ROUNDS 200000
+#define SPIN_LIMIT      1024
+/* Large enough that the buffer does not stay in the caches. */
+#define NUMA_CAPACITY   (64 * 1024)
+#define MAX_NODES       64
+
+enum impl {
+    IMPL_CFIFO,
+    IMPL_INLINE,
+    IMPL_MUTEX,
+    NUM_IMPLS
+};
+
+static const char * const impl_names[NUM_IMPLS] = {"cfifo", "inline", "mutex"};
+
+/* A fifo, optionally behind a lock or through the inline calls. */
+struct bench_fifo {
+    cfifo_t             fifo;
+    pthread_mutex_t     *p_lock;
+    int                 use_inline;
+};
+
+struct bench_result {
+    const char          *p_bench;
+    enum impl           impl;
+    size_t              item_size;
+    size_t              capacity;
+    double              ops_per_s;
+    /* Round trip percentiles in ns, negative if not measured. */
+    double              p50_ns;
+    double              p99_ns;
+    double              p999_ns;
+};
+
+struct thread_ctx {
+    struct bench_fifo   *p_to_consumer;
+    struct bench_fifo   *p_to_producer;
+    uint64_t            iterations;
+    int                 cpu;
+};
+
+static int json;
+static int num_results;
+static unsigned int work_shift;
+
+static void pin_thread(int cpu)
+{
+    cpu_set_t set;
+    long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (cpu < 0 || num_cpus <= 0)
+    {
+        return;
+    }
+    CPU_ZERO(&set);
+    CPU_SET(cpu % num_cpus, &set);
+    /* Not fatal, e.g. fewer cores than requested. */
+    (void) pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+static void backoff(unsigned int *p_spins)
+{
+    if (++(*p_spins) >= SPIN_LIMIT)
+    {
+        *p_spins = 0;
+        sched_yield();
+    }
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+static cfifo_ret_t bench_put(struct bench_fifo *p_bf, const void *p_item)
+{
+    cfifo_ret_t ret;
+
+    if (p_bf->use_inline)
+    {
+        return cfifo_put_inline(p_bf->fifo, p_item);
+    }
+    if (NULL == p_bf->p_lock)
+    {
+        return cfifo_put(p_bf->fifo, p_item);
+    }
+    pthread_mutex_lock(p_bf->p_lock);
+    ret = cfifo_put(p_bf->fifo, p_item);
+    pthread_mutex_unlock(p_bf->p_lock);
+    return ret;
+}
+
+static cfifo_ret_t bench_get(struct bench_fifo *p_bf, void *p_item)
+{
+    cfifo_ret_t ret;
+
+    if (p_bf->use_inline)
+    {
+        return cfifo_get_inline(p_bf->fifo, p_item);
+    }
+    if (NULL == p_bf->p_lock)
+    {
+        return cfifo_get(p_bf->fifo, p_item);
+    }
+    pthread_mutex_lock(p_bf->p_lock);
+    ret = cfifo_get(p_bf->fifo, p_item);
+    pthread_mutex_unlock(p_bf->p_lock);
+    return ret;
+}
+
+static cfifo_ret_t bench_write(struct bench_fifo *p_bf, const void *p_items, size_t *p_num)
+{
+    cfifo_ret_t ret;
+
+    if (p_bf->use_inline)
+    {
+        return cfifo_write_inline(p_bf->fifo, p_items, p_num);
+    }
+    if (NULL == p_bf->p_lock)
+    {
+        return cfifo_write(p_bf->fifo, p_items, p_num);
+    }
+    pthread_mutex_lock(p_bf->p_lock);
+    ret = cfifo_write(p_bf->fifo, p_items, p_num);
+    pthread_mutex_unlock(p_bf->p_lock);
+    return ret;
+}
+
+static cfifo_ret_t bench_read(struct bench_fifo *p_bf, void *p_items, size_t *p_num)
+{
+    cfifo_ret_t ret;
+
+    if (p_bf->use_inline)
+    {
+        return cfifo_read_inline(p_bf->fifo, p_items, p_num);
+    }
+    if (NULL == p_bf->p_lock)
+    {
+        return cfifo_read(p_bf->fifo, p_items, p_num);
+    }
+    pthread_mutex_lock(p_bf->p_lock);
+    ret = cfifo_read(p_bf->fifo, p_items, p_num);
+    pthread_mutex_unlock(p_bf->p_lock);
+    return ret;
+}
+
+static void print_value(double value)
+{
+    if (value < 0)
+    {
+        /* Empty in CSV. */
+        if (json)
+        {
+            printf("null");
+        }
+    }
+    else
+    {
+        printf("%.1f", value);
+    }
+}
+
+static void print_result(const struct bench_result *p_res)
+{
+    if (json)
+    {
+        printf("%s\n  {\"bench\": \"%s\", \"impl\": \"%s\", \"item_size\": %zu, "
+               "\"capacity\": %zu, \"ops_per_s\": %.0f, \"p50_ns\": ",
+               (num_results > 0) ? "," : "[",
+               p_res->p_bench, impl_names[p_res->impl],
+               p_res->item_size, p_res->capacity, p_res->ops_per_s);
+        print_value(p_res->p50_ns);
+        printf(", \"p99_ns\": ");
+        print_value(p_res->p99_ns);
+        printf(", \"p999_ns\": ");
+        print_value(p_res->p999_ns);
+        printf("}");
+    }
+    else
+    {
+        if (0 == num_results)
+        {
+            printf("bench,impl,item_size,capacity,ops_per_s,p50_ns,p99_ns,p999_ns\n");
+        }
+        printf("%s,%s,%zu,%zu,%.0f,",
+               p_res->p_bench, impl_names[p_res->impl],
+               p_res->item_size, p_res->capacity, p_res->ops_per_s);
+        print_value(p_res->p50_ns);
+        printf(",");
+        print_value(p_res->p99_ns);
+        printf(",");
+        print_value(p_res->p999_ns);
+        printf("\n");
+    }
+    num_results++;
+    fflush(stdout);
+}
+
+static void report(const char *p_bench,
+                   enum impl impl,
+                   size_t item_size,
+                   size_t capacity,
+                   double ops_per_s)
+{
+    struct bench_result res;
+
+    res.p_bench = p_bench;
+    res.impl = impl;
+    res.item_size = item_size;
+    res.capacity = capacity;
+    res.ops_per_s = ops_per_s;
+    res.p50_ns = -1;
+    res.p99_ns = -1;
+    res.p999_ns = -1;
+    print_result(&res);
+}
+
+static uint64_t work_items(size_t item_size)
+{
+    uint64_t items = WORK_BYTES / item_size;
+
+    return ((items > WORK_ITEMS) ? WORK_ITEMS : items) >> work_shift;
+}
+
+static double run_put_get(struct bench_fifo *p_bf, uint8_t *p_items,
+                          size_t item_size, size_t batch, uint64_t num_items)
+{
+    uint64_t start;
+    uint64_t done;
+    size_t i;
+
+    start = now_ns();
+    for (done = 0; done < num_items; done += batch)
+    {
+        for (i = 0; i < batch; i++)
+        {
+            (void) bench_put(p_bf, &p_items[i * item_size]);
+        }
+        for (i = 0; i < batch; i++)
+        {
+            (void) bench_get(p_bf, &p_items[i * item_size]);
+        }
+    }
+    return (double) (2 * done) * 1e9 / (double) (now_ns() - start);
+}
+
+static double run_write_read(struct bench_fifo *p_bf, uint8_t *p_items,
+                             size_t batch, uint64_t num_items)
+{
+    uint64_t start;
+    uint64_t done;
+    size_t num;
+
+    start = now_ns();
+    for (done = 0; done < num_items; done += batch)
+    {
+        num = batch;
+        (void) bench_write(p_bf, p_items, &num);
+        num = batch;
+        (void) bench_read(p_bf, p_items, &num);
+    }
+    return (double) (2 * done) * 1e9 / (double) (now_ns() - start);
+}
+
+static void single_thread_bench(pthread_mutex_t *p_lock)
+{
+    static uint8_t items[MAX_BATCH * MAX_ITEM_SIZE];
+    struct cfifo_s fifo;
+    struct bench_fifo bf;
+    size_t item_size;
+    size_t capacity;
+    size_t batch;
+    uint8_t *p_buf;
+    int impl;
+
+    memset(items, 0x5a, sizeof(items));
+    for (item_size = 1; item_size <= MAX_ITEM_SIZE; item_size *= 2)
+    {
+        for (capacity = 16; capacity <= MAX_CAPACITY; capacity *= 16)
+        {
+            if (item_size * capacity > MAX_BUF_BYTES)
+            {
+                continue;
+            }
+            p_buf = malloc(item_size * capacity);
+            if (NULL == p_buf ||
+                cfifo_init(&fifo, p_buf, capacity, item_size, item_size * capacity) != CFIFO_SUCCESS)
+            {
+                fprintf(stderr, "no memory for %zu x %zu\n", capacity, item_size);
+                free(p_buf);
+                continue;
+            }
+            /* Touch the buffer before timing. */
+            memset(p_buf, 0, item_size * capacity);
+            batch = (capacity < MAX_BATCH) ? capacity : MAX_BATCH;
+
+            for (impl = 0; impl < NUM_IMPLS; impl++)
+            {
+                bf.fifo = &fifo;
+                bf.p_lock = (IMPL_MUTEX == impl) ? p_lock : NULL;
+                bf.use_inline = (IMPL_INLINE == impl);
+                report("put_get", (enum impl) impl, item_size, capacity,
+                       run_put_get(&bf, items, item_size, batch, work_items(item_size)));
+                report("write_read", (enum impl) impl, item_size, capacity,
+                       run_write_read(&bf, items, batch, work_items(item_size)));
+            }
+            free(p_buf);
+        }
+    }
+}
+
+static void *stream_consumer(void *arg)
+{
+    struct thread_ctx *p_ctx = (struct thread_ctx *) arg;
+    uint8_t item[MAX_ITEM_SIZE];
+    unsigned int spins = 0;
+    uint64_t i;
+
+    pin_thread(p_ctx->cpu);
+    for (i = 0; i < p_ctx->iterations; i++)
+    {
+        while (bench_get(p_ctx->p_to_consumer, item) != CFIFO_SUCCESS)
+        {
+            backoff(&spins);
+        }
+    }
+    return NULL;
+}
+
+static void *pingpong_echo(void *arg)
+{
+    struct thread_ctx *p_ctx = (struct thread_ctx *) arg;
+    uint8_t item[MAX_ITEM_SIZE];
+    unsigned int spins = 0;
+    uint64_t i;
+
+    pin_thread(p_ctx->cpu);
+    for (i = 0; i < p_ctx->iterations; i++)
+    {
+        while (bench_get(p_ctx->p_to_consumer, item) != CFIFO_SUCCESS)
+        {
+            backoff(&spins);
+        }
+        while (bench_put(p_ctx->p_to_producer, item) != CFIFO_SUCCESS)
+        {
+            backoff(&spins);
+        }
+    }
+    return NULL;
+}
+
+static int compare_u64(const void *p_a, const void *p_b)
+{
+    uint64_t a = *(const uint64_t *) p_a;
+    uint64_t b = *(const uint64_t *) p_b;
+
+    return (a > b) - (a < b);
+}
+
+static double percentile(const uint64_t *p_sorted, uint64_t num, double p)
+{
+    return (double) p_sorted[(uint64_t) ((double) (num - 1) * p)];
+}
+
+static double run_stream(struct thread_ctx *p_ctx)
+{
+    uint8_t item[MAX_ITEM_SIZE];
+    unsigned int spins = 0;
+    pthread_t thread;
+    uint64_t start;
+    uint64_t i;
+
+    memset(item, 0x5a, sizeof(item));
+    start = now_ns();
+    pthread_create(&thread, NULL, stream_consumer, p_ctx);
+    for (i = 0; i < p_ctx->iterations; i++)
+    {
+        while (bench_put(p_ctx->p_to_consumer, item) != CFIFO_SUCCESS)
+        {
+            backoff(&spins);
+        }
+    }
+    pthread_join(thread, NULL);
+    return (double) p_ctx->iterations * 1e9 / (double) (now_ns() - start);
+}
+
+static void run_pingpong(struct thread_ctx *p_ctx,
+                         struct bench_result *p_res)
+{
+    uint8_t item[MAX_ITEM_SIZE];
+    uint64_t *p_rtt = malloc(p_ctx->iterations * sizeof(uint64_t));
+    unsigned int spins = 0;
+    pthread_t thread;
+    uint64_t start;
+    uint64_t t;
+    uint64_t i;
+
+    if (NULL == p_rtt)
+    {
+        fprintf(stderr, "no memory for %llu samples\n",
+                (unsigned long long) p_ctx->iterations);
+        exit(EXIT_FAILURE);
+    }
+
+    memset(item, 0x5a, sizeof(item));
+    pthread_create(&thread, NULL, pingpong_echo, p_ctx);
+    start = now_ns();
+    for (i = 0; i < p_ctx->iterations; i++)
+    {
+        t = now_ns();
+        while (bench_put(p_ctx->p_to_consumer, item) != CFIFO_SUCCESS)
+        {
+            backoff(&spins);
+        }
+        while (bench_get(p_ctx->p_to_producer, item) != CFIFO_SUCCESS)
+        {
+            backoff(&spins);
+        }
+        p_rtt[i] = now_ns() - t;
+    }
+    p_res->ops_per_s = (double) p_ctx->iterations * 1e9 / (double) (now_ns() - start);
+    pthread_join(thread, NULL);
+
+    qsort(p_rtt, p_ctx->iterations, sizeof(uint64_t), compare_u64);
+    p_res->p50_ns = percentile(p_rtt, p_ctx->iterations, 0.50);
+    p_res->p99_ns = percentile(p_rtt, p_ctx->iterations, 0.99);
+    p_res->p999_ns = percentile(p_rtt, p_ctx->iterations, 0.999);
+    free(p_rtt);
+}
+
+static void cross_core_bench(pthread_mutex_t *p_lock, int consumer_cpu)
+{
+    static const size_t item_sizes[] = {8, 64, 512};
+    static uint8_t buf_a[STREAM_CAPACITY * 512] CFIFO_CACHE_ALIGNED;
+    static uint8_t buf_b[STREAM_CAPACITY * 512] CFIFO_CACHE_ALIGNED;
+    /* Separate locks, the two directions are independent fifos. */
+    pthread_mutex_t lock_b = PTHREAD_MUTEX_INITIALIZER;
+    struct cfifo_s fifo_a;
+    struct cfifo_s fifo_b;
+    struct bench_fifo bf_a;
+    struct bench_fifo bf_b;
+    struct thread_ctx ctx;
+    struct bench_result res;
+    size_t s;
+    int impl;
+
+    for (s = 0; s < sizeof(item_sizes) / sizeof(item_sizes[0]); s++)
+    {
+        for (impl = 0; impl < NUM_IMPLS; impl++)
+        {
+            cfifo_init(&fifo_a, buf_a, STREAM_CAPACITY, item_sizes[s],
+                       STREAM_CAPACITY * item_sizes[s]);
+            cfifo_init(&fifo_b, buf_b, STREAM_CAPACITY, item_sizes[s],
+                       STREAM_CAPACITY * item_sizes[s]);
+            bf_a.fifo = &fifo_a;
+            bf_a.p_lock = (IMPL_MUTEX == impl) ? p_lock : NULL;
+            bf_a.use_inline = (IMPL_INLINE == impl);
+            bf_b.fifo = &fifo_b;
+            bf_b.p_lock = (IMPL_MUTEX == impl) ? &lock_b : NULL;
+            bf_b.use_inline = (IMPL_INLINE == impl);
+
+            ctx.p_to_consumer = &bf_a;
+            ctx.p_to_producer = &bf_b;
+            ctx.cpu = consumer_cpu;
+
+            ctx.iterations = work_items(item_sizes[s]);
+            report("stream", (enum impl) impl, item_sizes[s], STREAM_CAPACITY,
+                   run_stream(&ctx));
+
+            ctx.iterations = PINGPONG_ROUNDS >> work_shift;
+            res.p_bench = "pingpong";
+            res.impl = (enum impl) impl;
+            res.item_size = item_sizes[s];
+            res.capacity = STREAM_CAPACITY;
+            run_pingpong(&ctx, &res);
+            print_result(&res);
+        }
+    }
+    pthread_mutex_destroy(&lock_b);
+}
+
+static void print_numa_result(int producer_node, int consumer_node,
+                              int buffer_node, int bound, size_t item_size,
+                              double items_per_s)
+{
+    if (json)
+    {
+        printf("%s\n  {\"bench\": \"numa\", \"producer_node\": %d, "
+               "\"consumer_node\": %d, \"buffer_node\": %d, \"bound\": %s, "
+               "\"item_size\": %zu, \"ops_per_s\": %.0f}",
+               (num_results > 0) ? "," : "[",
+               producer_node, consumer_node, buffer_node,
+               bound ? "true" : "false", item_size, items_per_s);
+    }
+    else
+    {
+        if (0 == num_results)
+        {
+            printf("bench,producer_node,consumer_node,buffer_node,bound,"
+                   "item_size,ops_per_s\n");
+        }
+        printf("numa,%d,%d,%d,%d,%zu,%.0f\n",
+               producer_node, consumer_node, buffer_node, bound,
+               item_size, items_per_s);
+    }
+    num_results++;
+    fflush(stdout);
+}
+
+/* One stream run with header and buffer bound to buffer_node. */
+static void numa_stream(int producer_cpu, int consumer_cpu,
+                        int producer_node, int consumer_node,
+                        int buffer_node, size_t item_size)
+{
+    unsigned int header_flags = CFIFO_MEM_NODE(buffer_node) | CFIFO_MEM_PREFAULT;
+    unsigned int buf_flags = CFIFO_MEM_NODE(buffer_node) | CFIFO_MEM_PREFAULT;
+    struct bench_fifo bf;
+    struct thread_ctx ctx;
+    uint8_t *p_header;
+    double items_per_s;
+
+    /* The header gets pages of its own, so it can be placed as well. */
+    if (cfifo_mem_alloc(&p_header, sizeof(struct cfifo_s), &header_flags) != CFIFO_SUCCESS)
+    {
+        fprintf(stderr, "no memory for a fifo header\n");
+        exit(EXIT_FAILURE);
+    }
+    bf.fifo = (cfifo_t) (void *) p_header;
+    bf.p_lock = NULL;
+    bf.use_inline = 0;
+    if (cfifo_mem_create(bf.fifo, NUMA_CAPACITY, item_size, &buf_flags) != CFIFO_SUCCESS)
+    {
+        fprintf(stderr, "no memory for %d items of %zu bytes\n",
+                NUMA_CAPACITY, item_size);
+        exit(EXIT_FAILURE);
+    }
+
+    pin_thread(producer_cpu);
+    ctx.p_to_consumer = &bf;
+    ctx.p_to_producer = NULL;
+    ctx.iterations = work_items(item_size);
+    ctx.cpu = consumer_cpu;
+    items_per_s = run_stream(&ctx);
+
+    print_numa_result(producer_node, consumer_node, buffer_node,
+                      CFIFO_MEM_GET_NODE(header_flags & buf_flags) == buffer_node,
+                      item_size, items_per_s);
+
+    (void) cfifo_mem_destroy(bf.fifo);
+    cfifo_mem_free(p_header, sizeof(struct cfifo_s));
+}
+
+static void numa_bench(void)
+{
+    static const size_t item_sizes[] = {8, 64, 512};
+    /* First two cpus of each node, -1 if none. */
+    int node_cpus[MAX_NODES][2];
+    long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int num_nodes = cfifo_mem_num_nodes();
+    int cpu;
+    int node;
+    int pn;
+    int cn;
+    int side;
+    size_t s;
+
+    if (num_nodes > MAX_NODES)
+    {
+        num_nodes = MAX_NODES;
+    }
+    for (node = 0; node < num_nodes; node++)
+    {
+        node_cpus[node][0] = -1;
+        node_cpus[node][1] = -1;
+    }
+    for (cpu = 0; cpu < num_cpus; cpu++)
+    {
+        /* Without NUMA support in the kernel everything is node 0. */
+        node = cfifo_mem_cpu_node(cpu);
+        node = (node < 0) ? 0 : node;
+        if (node >= num_nodes)
+        {
+            continue;
+        }
+        if (node_cpus[node][0] < 0)
+        {
+            node_cpus[node][0] = cpu;
+        }
+        else if (node_cpus[node][1] < 0)
+        {
+            node_cpus[node][1] = cpu;
+        }
+    }
+    if (1 == num_nodes)
+    {
+        fprintf(stderr, "single NUMA node, no cross-node numbers\n");
+    }
+
+    for (pn = 0; pn < num_nodes; pn++)
+    {
+        for (cn = 0; cn < num_nodes; cn++)
+        {
+            if (node_cpus[pn][0] < 0 || node_cpus[cn][0] < 0)
+            {
+                continue;
+            }
+            /* Two cpus of the node if it has them. */
+            cpu = (pn == cn && node_cpus[cn][1] >= 0) ?
+                  node_cpus[cn][1] : node_cpus[cn][0];
+            for (s = 0; s < sizeof(item_sizes) / sizeof(item_sizes[0]); s++)
+            {
+                for (side = 0; side < ((pn == cn) ? 1 : 2); side++)
+                {
+                    numa_stream(node_cpus[pn][0], cpu, pn, cn,
+                                (0 == side) ? pn : cn, item_sizes[s]);
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    int producer_cpu = 0;
+    int consumer_cpu = 1;
+    int numa = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "jqnp:c:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'j':
+            json = 1;
+            break;
+        case 'q':
+            work_shift = 4;
+            break;
+        case 'n':
+            numa = 1;
+            break;
+        case 'p':
+            producer_cpu = atoi(optarg);
+            break;
+        case 'c':
+            consumer_cpu = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr,
+                    "usage: %s [-j] [-q] [-n] [-p producer cpu] [-c consumer cpu]\n",
+                    argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (numa)
+    {
+        numa_bench();
+    }
+    else
+    {
+        pin_thread(producer_cpu);
+        single_thread_bench(&lock);
+        cross_core_bench(&lock, consumer_cpu);
+    }
+
+    if (json)
+    {
+        printf("\n]\n");
+    }
+    pthread_mutex_destroy(&lock);
+
+    return 0;
+}
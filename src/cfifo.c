@@ -7,31 +7,103 @@
 
 /*======= Includes ==========================================================*/
 
+/* The out-of-line definitions, never the inline mapping of cfifo_inline.h. */
+#undef CFIFO_INLINE
+
 /* C-Library includes */
 #include <string.h> /* For memcpy */
 
 /* Local includes */
 #include "cfifo.h"
+#include "cfifo_atomic.h"
+#include "cfifo_pos.h"
+#include "cfifo_wait.h"
+#include "cfifo_notify.h"
+#include "cfifo_index.h"
+#include "cfifo_scan.h"
 
 /*======= Local Macro Definitions ===========================================*/
 
 #ifndef MIN
-#define MIN(a,b) ((a) < (b)) ? (a) : (b)
+#define MIN(a,b) (((a) < (b)) ? (a) : (b))
 #endif
 
-#define CFIFO_WRITE_POS     (p_cfifo->write_pos & p_cfifo->num_items_mask)
-#define CFIFO_READ_POS      (p_cfifo->read_pos & p_cfifo->num_items_mask)
-#define CFIFO_WRITE_OFFSET  (CFIFO_WRITE_POS * p_cfifo->item_size)
-#define CFIFO_READ_OFFSET   (CFIFO_READ_POS * p_cfifo->item_size)
+#define CFIFO_OFFSET(pos)   (cfifo_pos_slot(p_cfifo, (pos)) * p_cfifo->item_size)
+#define CFIFO_POS_ADD(pos, num_items) cfifo_pos_add(p_cfifo, (pos), (num_items))
+#define CFIFO_POS_DIFF(end, start)    cfifo_pos_diff(p_cfifo, (end), (start))
+#define CFIFO_WRITE_OFFSET  CFIFO_OFFSET(CFIFO_LOAD_RELAXED(p_cfifo->write_pos))
+#define CFIFO_READ_OFFSET   CFIFO_OFFSET(CFIFO_LOAD_RELAXED(p_cfifo->read_pos))
+#define CFIFO_CAPACITY      (p_cfifo->num_items_mask + 1)
+#define CFIFO_MIRRORED      (p_cfifo->flags & CFIFO_FLAG_MIRRORED)
+#define CFIFO_BUF           cfifo_pos_buf(p_cfifo)
+#define CFIFO_SIGNALLED     (p_cfifo->flags & (CFIFO_FLAG_WAIT | CFIFO_FLAG_NOTIFY))
+#define CFIFO_INDEXED       (p_cfifo->flags & CFIFO_FLAG_INDEX)
+#define CFIFO_OVERWRITE     (p_cfifo->flags & CFIFO_FLAG_OVERWRITE)
 #define CFIFO_SIZE          cfifoi_size(p_cfifo)
+
+#if defined(CFIFO_STATS)
+#define CFIFO_STATS_PUT(num_items, write_pos)                               \
+        cfifoi_stats_put(p_cfifo, (num_items), (write_pos))
+#define CFIFO_STATS_GET(num_items)                                          \
+        cfifoi_stats_get(p_cfifo, (num_items))
+#define CFIFO_STATS_FULL()                                                  \
+        cfifoi_stats_reject(&p_cfifo->put_stats.seq, &p_cfifo->put_stats.rejects)
+#define CFIFO_STATS_EMPTY()                                                 \
+        cfifoi_stats_reject(&p_cfifo->get_stats.seq, &p_cfifo->get_stats.rejects)
+#else
+#define CFIFO_STATS_PUT(num_items, write_pos)
+#define CFIFO_STATS_GET(num_items)
+#define CFIFO_STATS_FULL()
+#define CFIFO_STATS_EMPTY()
+#endif
 #define CFIFO_AVAILABLE     cfifoi_available(p_cfifo)
 
 /*======= Local function prototypes =========================================*/
 
 static size_t cfifoi_available(cfifo_t p_cfifo);
 static size_t cfifoi_size(cfifo_t p_cfifo);
+static size_t cfifoi_write_available(cfifo_t p_cfifo, size_t num_items);
+static size_t cfifoi_read_size(cfifo_t p_cfifo, size_t num_items);
+static void cfifoi_refresh_read_pos(cfifo_t p_cfifo);
+static void cfifoi_index_add(cfifo_t p_cfifo, size_t pos, size_t end);
+static void cfifoi_index_sync(cfifo_t p_cfifo, size_t read_pos);
+static void cfifoi_publish_write(cfifo_t p_cfifo, size_t write_pos);
+static void cfifoi_publish_read(cfifo_t p_cfifo, size_t read_pos);
 static void cfifoi_put(cfifo_t p_cfifo, const void * const p_item);
 static void cfifoi_get(cfifo_t p_cfifo, void *p_item);
+static void cfifoi_write(cfifo_t p_cfifo,
+                         const uint8_t *p_src,
+                         size_t num_items);
+static void cfifoi_read(cfifo_t p_cfifo, uint8_t *p_dest, size_t num_items);
+static void cfifoi_copy_in(cfifo_t p_cfifo,
+                           size_t pos,
+                           const uint8_t *p_src,
+                           size_t num_items);
+static void cfifoi_copy_out(cfifo_t p_cfifo,
+                            size_t pos,
+                            uint8_t *p_dest,
+                            size_t num_items);
+static void cfifoi_copy(cfifo_t p_cfifo,
+                        uint8_t *p_dest,
+                        const uint8_t *p_src,
+                        size_t num_bytes);
+static void cfifoi_overwrite_write(cfifo_t p_cfifo,
+                                   const uint8_t *p_src,
+                                   size_t num_items);
+static size_t cfifoi_overwrite_read(cfifo_t p_cfifo,
+                                    uint8_t *p_dest,
+                                    size_t num_items,
+                                    int remove);
+#if defined(CFIFO_STATS)
+static void cfifoi_stats_put(cfifo_t p_cfifo, size_t num_items, size_t write_pos);
+static void cfifoi_stats_get(cfifo_t p_cfifo, size_t num_items);
+static void cfifoi_stats_reject(size_t *p_seq, size_t *p_rejects);
+static void cfifoi_stats_copy(const size_t *p_seq,
+                              const size_t *p_src,
+                              size_t *p_dest,
+                              size_t num_words);
+#endif
+static void cfifoi_stored_spans(cfifo_t p_cfifo, cfifo_span_t p_spans[2]);
 
 /*======= Global function implementations ===================================*/
 
@@ -47,7 +119,7 @@ cfifo_ret_t cfifo_init(cfifo_t p_cfifo,
         return CFIFO_ERR_NULL;
     }
 
-    if (!CFIFO_IS_POW_2(num_items))
+    if (!CFIFO_IS_CAPACITY(num_items))
     {
         return CFIFO_ERR_BAD_SIZE;
     }
@@ -59,16 +131,73 @@ cfifo_ret_t cfifo_init(cfifo_t p_cfifo,
 
     p_cfifo->p_buf = p_buf;
     p_cfifo->num_items_mask = num_items - 1;
+    p_cfifo->pos_wrap = CFIFO_POS_WRAP(num_items);
     p_cfifo->item_size = item_size;
+    p_cfifo->flags = 0;
+    p_cfifo->data_fd = -1;
+    p_cfifo->space_fd = -1;
     p_cfifo->read_pos = 0;
+    p_cfifo->write_pos_cache = 0;
+    p_cfifo->put_waiters = 0;
+    p_cfifo->space_armed = 0;
     p_cfifo->write_pos = 0;
+    p_cfifo->read_pos_cache = 0;
+    p_cfifo->get_waiters = 0;
+    p_cfifo->data_armed = 0;
+    p_cfifo->p_index = NULL;
+    p_cfifo->overwritten = 0;
+#if defined(CFIFO_STATS)
+    memset(&p_cfifo->get_stats, 0, sizeof(p_cfifo->get_stats));
+    memset(&p_cfifo->put_stats, 0, sizeof(p_cfifo->put_stats));
+#endif
 
     return CFIFO_SUCCESS;
 }
 
+cfifo_ret_t cfifo_init_mirrored(cfifo_t p_cfifo,
+                                uint8_t *p_buf,
+                                size_t num_items,
+                                size_t item_size,
+                                size_t buf_size)
+{
+    cfifo_ret_t ret = cfifo_init(p_cfifo, p_buf, num_items, item_size, buf_size);
+
+    if (CFIFO_SUCCESS == ret)
+    {
+        p_cfifo->flags |= CFIFO_FLAG_MIRRORED;
+    }
+
+    return ret;
+}
+
+cfifo_ret_t cfifo_init_relative(cfifo_t p_cfifo,
+                                uint8_t *p_buf,
+                                size_t num_items,
+                                size_t item_size,
+                                size_t buf_size)
+{
+    cfifo_ret_t ret;
+
+    /* The offset is stored in p_buf and must not look like NULL. */
+    if (NULL != p_cfifo && p_buf <= (uint8_t *) p_cfifo)
+    {
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+    ret = cfifo_init(p_cfifo, p_buf, num_items, item_size, buf_size);
+    if (CFIFO_SUCCESS == ret)
+    {
+        p_cfifo->p_buf = (uint8_t *) (uintptr_t) (p_buf - (uint8_t *) p_cfifo);
+        p_cfifo->flags |= CFIFO_FLAG_RELATIVE;
+    }
+
+    return ret;
+}
+
 cfifo_ret_t cfifo_put(cfifo_t p_cfifo,
                       const void * const p_item)
 {
+#if CFIFO_CHECKED
     if (NULL == p_cfifo || NULL == p_item)
     {
         /* Error, null pointers. */
@@ -79,12 +208,20 @@ cfifo_ret_t cfifo_put(cfifo_t p_cfifo,
     {
         return CFIFO_ERR_INVALID_STATE;
     }
+#endif
 
-    if (CFIFO_AVAILABLE > 0)
+    if (CFIFO_OVERWRITE)
+    {
+        cfifoi_overwrite_write(p_cfifo, (const uint8_t *) p_item, 1);
+        return CFIFO_SUCCESS;
+    }
+
+    if (cfifoi_write_available(p_cfifo, 1) > 0)
     {
         cfifoi_put(p_cfifo, p_item);
         return CFIFO_SUCCESS;
     }
+    CFIFO_STATS_FULL();
     return CFIFO_ERR_FULL;
 }
 
@@ -92,9 +229,9 @@ cfifo_ret_t cfifo_write(cfifo_t p_cfifo,
                         const void * const p_items,
                         size_t *p_num_items)
 {
-    size_t i;
-    const uint8_t * const p_src = (const uint8_t * const) p_items;
+    size_t available;
 
+#if CFIFO_CHECKED
     if (NULL == p_cfifo || NULL == p_items || NULL == p_num_items)
     {
         /* Error, null pointers. */
@@ -105,22 +242,77 @@ cfifo_ret_t cfifo_write(cfifo_t p_cfifo,
     {
         return CFIFO_ERR_INVALID_STATE;
     }
+#endif
 
-    (*p_num_items) = MIN((*p_num_items), CFIFO_AVAILABLE);
+    if (CFIFO_OVERWRITE)
+    {
+        /* Items beyond the capacity would be overwritten right away. */
+        available = MIN((*p_num_items), CFIFO_CAPACITY);
+        CFIFO_STORE_RELAXED(p_cfifo->overwritten,
+                            p_cfifo->overwritten + (*p_num_items) - available);
+        cfifoi_overwrite_write(p_cfifo,
+                               (const uint8_t *) p_items +
+                               ((*p_num_items) - available) * p_cfifo->item_size,
+                               available);
+        return CFIFO_SUCCESS;
+    }
 
-    for (i = 0; i < (*p_num_items); i++)
+    /* Not inside MIN(), the other side may move between two calls. */
+    available = cfifoi_write_available(p_cfifo, (*p_num_items));
+    if (0 == available && (*p_num_items) > 0)
     {
-        cfifoi_put(p_cfifo, &p_src[i * p_cfifo->item_size]);
+        CFIFO_STATS_FULL();
     }
+    (*p_num_items) = MIN((*p_num_items), available);
+
+    cfifoi_write(p_cfifo, (const uint8_t *) p_items, (*p_num_items));
 
     return CFIFO_SUCCESS;
 
 }
 
+cfifo_ret_t cfifo_write_bulk(cfifo_t p_cfifo,
+                             const void * const p_items,
+                             size_t num_items)
+{
+    if (NULL == p_cfifo || NULL == p_items)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (NULL == p_cfifo->p_buf)
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    if (num_items > CFIFO_CAPACITY)
+    {
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+    if (CFIFO_OVERWRITE)
+    {
+        cfifoi_overwrite_write(p_cfifo, (const uint8_t *) p_items, num_items);
+        return CFIFO_SUCCESS;
+    }
+
+    if (cfifoi_write_available(p_cfifo, num_items) < num_items)
+    {
+        CFIFO_STATS_FULL();
+        return CFIFO_ERR_FULL;
+    }
+
+    cfifoi_write(p_cfifo, (const uint8_t *) p_items, num_items);
+
+    return CFIFO_SUCCESS;
+}
+
 cfifo_ret_t cfifo_get(cfifo_t p_cfifo,
                       void *p_item)
 {
 
+#if CFIFO_CHECKED
     if (NULL == p_cfifo || NULL == p_item)
     {
         /* Error, null pointers. */
@@ -131,12 +323,21 @@ cfifo_ret_t cfifo_get(cfifo_t p_cfifo,
     {
         return CFIFO_ERR_INVALID_STATE;
     }
+#endif
 
-    if (CFIFO_SIZE > 0)
+    if (CFIFO_OVERWRITE)
+    {
+        if (cfifoi_overwrite_read(p_cfifo, (uint8_t *) p_item, 1, 1) > 0)
+        {
+            return CFIFO_SUCCESS;
+        }
+    }
+    else if (cfifoi_read_size(p_cfifo, 1) > 0)
     {
         cfifoi_get(p_cfifo, p_item);
         return CFIFO_SUCCESS;
     }
+    CFIFO_STATS_EMPTY();
     return CFIFO_ERR_EMPTY;
 }
 
@@ -144,10 +345,9 @@ cfifo_ret_t cfifo_read(cfifo_t p_cfifo,
                        void *p_items,
                        size_t *p_num_items)
 {
+    size_t size;
 
-    size_t i;
-    uint8_t *p_dest = (uint8_t *) p_items;
-
+#if CFIFO_CHECKED
     if (NULL == p_cfifo || NULL == p_items || NULL == p_num_items)
     {
         /* Error, null pointers. */
@@ -158,18 +358,75 @@ cfifo_ret_t cfifo_read(cfifo_t p_cfifo,
     {
         return CFIFO_ERR_INVALID_STATE;
     }
+#endif
 
-    (*p_num_items) = MIN((*p_num_items), CFIFO_SIZE);
+    if (CFIFO_OVERWRITE)
+    {
+        size = cfifoi_overwrite_read(p_cfifo,
+                                     (uint8_t *) p_items,
+                                     (*p_num_items),
+                                     1);
+    }
+    else
+    {
+        size = cfifoi_read_size(p_cfifo, (*p_num_items));
+        size = MIN((*p_num_items), size);
+        cfifoi_read(p_cfifo, (uint8_t *) p_items, size);
+    }
 
-    for (i = 0; i < (*p_num_items); i++)
+    if (0 == size && (*p_num_items) > 0)
     {
-        cfifoi_get(p_cfifo, &p_dest[i * p_cfifo->item_size]);
+        CFIFO_STATS_EMPTY();
     }
+    (*p_num_items) = size;
 
     return CFIFO_SUCCESS;
 
 }
 
+cfifo_ret_t cfifo_read_bulk(cfifo_t p_cfifo,
+                            void *p_items,
+                            size_t num_items)
+{
+    if (NULL == p_cfifo || NULL == p_items)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (NULL == p_cfifo->p_buf)
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    if (num_items > CFIFO_CAPACITY)
+    {
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+    if (CFIFO_OVERWRITE)
+    {
+        /* Only the consumer makes the fifo shrink, enough items stay. */
+        if (CFIFO_SIZE < num_items)
+        {
+            CFIFO_STATS_EMPTY();
+            return CFIFO_ERR_EMPTY;
+        }
+        (void) cfifoi_overwrite_read(p_cfifo, (uint8_t *) p_items, num_items, 1);
+        return CFIFO_SUCCESS;
+    }
+
+    if (cfifoi_read_size(p_cfifo, num_items) < num_items)
+    {
+        CFIFO_STATS_EMPTY();
+        return CFIFO_ERR_EMPTY;
+    }
+
+    cfifoi_read(p_cfifo, (uint8_t *) p_items, num_items);
+
+    return CFIFO_SUCCESS;
+}
+
 cfifo_ret_t cfifo_peek(cfifo_t p_cfifo,
                        void *p_item)
 {
@@ -184,10 +441,16 @@ cfifo_ret_t cfifo_peek(cfifo_t p_cfifo,
         return CFIFO_ERR_INVALID_STATE;
     }
 
-    if (CFIFO_SIZE > 0)
+    if (CFIFO_OVERWRITE)
+    {
+        return (cfifoi_overwrite_read(p_cfifo, (uint8_t *) p_item, 1, 0) > 0) ?
+               CFIFO_SUCCESS : CFIFO_ERR_EMPTY;
+    }
+
+    if (cfifoi_read_size(p_cfifo, 1) > 0)
     {
         memcpy(p_item,
-               &p_cfifo->p_buf[CFIFO_READ_OFFSET],
+               &CFIFO_BUF[CFIFO_READ_OFFSET],
                p_cfifo->item_size);
         return CFIFO_SUCCESS;
     }
@@ -195,41 +458,322 @@ cfifo_ret_t cfifo_peek(cfifo_t p_cfifo,
 
 }
 
+cfifo_ret_t cfifo_reserve(cfifo_t p_cfifo,
+                          cfifo_span_t p_spans[2])
+{
+    size_t available;
+
+    if (NULL == p_cfifo || NULL == p_spans)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    /* In place access is not protected against overwrites. */
+    if (NULL == p_cfifo->p_buf || CFIFO_OVERWRITE)
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    available = cfifoi_write_available(p_cfifo, CFIFO_CAPACITY);
+    cfifo_pos_spans(p_cfifo,
+                    CFIFO_LOAD_RELAXED(p_cfifo->write_pos),
+                    available,
+                    p_spans);
+
+    if (0 == available)
+    {
+        CFIFO_STATS_FULL();
+        return CFIFO_ERR_FULL;
+    }
+    return CFIFO_SUCCESS;
+}
+
+cfifo_ret_t cfifo_commit(cfifo_t p_cfifo,
+                         size_t num_items)
+{
+    if (NULL == p_cfifo)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (NULL == p_cfifo->p_buf || CFIFO_OVERWRITE)
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    if (cfifoi_write_available(p_cfifo, num_items) < num_items)
+    {
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+    cfifoi_publish_write(p_cfifo,
+                         CFIFO_POS_ADD(CFIFO_LOAD_RELAXED(p_cfifo->write_pos),
+                                       num_items));
+
+    return CFIFO_SUCCESS;
+}
+
+cfifo_ret_t cfifo_acquire(cfifo_t p_cfifo,
+                          cfifo_span_t p_spans[2])
+{
+    size_t size;
+
+    if (NULL == p_cfifo || NULL == p_spans)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (NULL == p_cfifo->p_buf || CFIFO_OVERWRITE)
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    size = cfifoi_read_size(p_cfifo, CFIFO_CAPACITY);
+    cfifo_pos_spans(p_cfifo,
+                    CFIFO_LOAD_RELAXED(p_cfifo->read_pos),
+                    size,
+                    p_spans);
+
+    if (0 == size)
+    {
+        CFIFO_STATS_EMPTY();
+        return CFIFO_ERR_EMPTY;
+    }
+    return CFIFO_SUCCESS;
+}
+
+cfifo_ret_t cfifo_release(cfifo_t p_cfifo,
+                          size_t num_items)
+{
+    if (NULL == p_cfifo)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (NULL == p_cfifo->p_buf || CFIFO_OVERWRITE)
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    if (cfifoi_read_size(p_cfifo, num_items) < num_items)
+    {
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+    cfifoi_publish_read(p_cfifo,
+                        CFIFO_POS_ADD(CFIFO_LOAD_RELAXED(p_cfifo->read_pos),
+                                      num_items));
+
+    return CFIFO_SUCCESS;
+}
+
 size_t cfifo_contains(cfifo_t p_cfifo,
                         void *p_item)
 {
+    cfifo_span_t spans[2];
 
-    /* Store original read pos. */
-    size_t i;
-    size_t size;
-    size_t read_pos;
-    size_t items_found = 0;
+    if (NULL == p_cfifo || NULL == p_item || NULL == p_cfifo->p_buf)
+    {
+        /* Error, null pointers. */
+        return 0;
+    }
+
+    if (CFIFO_INDEXED)
+    {
+        cfifoi_index_sync(p_cfifo, CFIFO_LOAD_ACQUIRE(p_cfifo->read_pos));
+        return cfifo_index_count(p_cfifo->p_index, p_item);
+    }
+
+    cfifoi_stored_spans(p_cfifo, spans);
+
+    return cfifo_scan_count(spans[0].p_data, spans[0].num_items,
+                            p_cfifo->item_size, p_item) +
+           cfifo_scan_count(spans[1].p_data, spans[1].num_items,
+                            p_cfifo->item_size, p_item);
+}
+
+size_t cfifo_find(cfifo_t p_cfifo,
+                  const void *p_item)
+{
+    cfifo_span_t spans[2];
+    size_t index;
 
     if (NULL == p_cfifo || NULL == p_item || NULL == p_cfifo->p_buf)
+    {
+        /* Error, null pointers. */
+        return CFIFO_NOT_FOUND;
+    }
+
+    cfifoi_stored_spans(p_cfifo, spans);
+
+    index = cfifo_scan_find(spans[0].p_data, spans[0].num_items,
+                            p_cfifo->item_size, p_item);
+    if (index < spans[0].num_items)
+    {
+        return index;
+    }
+
+    index = cfifo_scan_find(spans[1].p_data, spans[1].num_items,
+                            p_cfifo->item_size, p_item);
+    if (index < spans[1].num_items)
+    {
+        return spans[0].num_items + index;
+    }
+
+    return CFIFO_NOT_FOUND;
+}
+
+size_t cfifo_count_if(cfifo_t p_cfifo,
+                      cfifo_pred_t pred,
+                      void *p_arg)
+{
+    cfifo_span_t spans[2];
+    size_t items_found = 0;
+    size_t i;
+    size_t j;
+
+    if (NULL == p_cfifo || NULL == pred || NULL == p_cfifo->p_buf)
     {
         /* Error, null pointers. */
         return 0;
     }
 
-    read_pos = p_cfifo->read_pos;
-    size = CFIFO_SIZE;
+    cfifoi_stored_spans(p_cfifo, spans);
 
-    for (i = 0; i < size; i++)
+    for (i = 0; i < 2; i++)
     {
-        if (memcmp(p_item,
-                   &p_cfifo->p_buf[CFIFO_READ_OFFSET],
-                   p_cfifo->item_size) == 0)
+        for (j = 0; j < spans[i].num_items; j++)
         {
-            items_found++;
+            if (pred(&spans[i].p_data[j * p_cfifo->item_size], p_arg))
+            {
+                items_found++;
+            }
         }
-        p_cfifo->read_pos++;
     }
 
-    p_cfifo->read_pos = read_pos;
-
     return items_found;
 }
 
+cfifo_ret_t cfifo_attach_index(cfifo_t p_cfifo,
+                               cfifo_index_t p_index)
+{
+    size_t read_pos;
+
+    if (NULL == p_cfifo || NULL == p_index)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (NULL == p_cfifo->p_buf || CFIFO_OVERWRITE)
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    /* Up to capacity distinct keys, plus one free entry to end probing. */
+    if (p_index->key_size != p_cfifo->item_size ||
+        p_index->num_entries_mask < CFIFO_CAPACITY)
+    {
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+    read_pos = CFIFO_LOAD_ACQUIRE(p_cfifo->read_pos);
+    p_cfifo->read_pos_cache = read_pos;
+    p_cfifo->p_index = p_index;
+    p_index->pos = read_pos;
+    cfifo_index_clear(p_index);
+    cfifoi_index_add(p_cfifo, read_pos, CFIFO_LOAD_RELAXED(p_cfifo->write_pos));
+    p_cfifo->flags |= CFIFO_FLAG_INDEX;
+
+    return CFIFO_SUCCESS;
+}
+
+cfifo_ret_t cfifo_detach_index(cfifo_t p_cfifo)
+{
+    if (NULL == p_cfifo)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    p_cfifo->flags &= ~CFIFO_FLAG_INDEX;
+    p_cfifo->p_index = NULL;
+
+    return CFIFO_SUCCESS;
+}
+
+cfifo_ret_t cfifo_enable_overwrite(cfifo_t p_cfifo)
+{
+    if (NULL == p_cfifo)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    /* Wrapping positions repeat too soon for the compare-and-swap. */
+    if (CFIFO_INDEXED || 0 != p_cfifo->pos_wrap)
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    p_cfifo->flags |= CFIFO_FLAG_OVERWRITE;
+
+    return CFIFO_SUCCESS;
+}
+
+size_t cfifo_overwritten(cfifo_t p_cfifo)
+{
+    return (NULL != p_cfifo) ? CFIFO_LOAD_RELAXED(p_cfifo->overwritten) : 0;
+}
+
+cfifo_ret_t cfifo_stats_snapshot(cfifo_t p_cfifo,
+                                 struct cfifo_stats_s *p_stats)
+{
+#if defined(CFIFO_STATS)
+    size_t put_words[3 + CFIFO_STATS_BINS];
+    size_t get_words[2];
+    size_t i;
+#endif
+
+    if (NULL == p_cfifo || NULL == p_stats)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    memset(p_stats, 0, sizeof(*p_stats));
+
+#if defined(CFIFO_STATS)
+    /* The counters follow seq in the same order as in the local arrays. */
+    /* Consumer first, so items_out never exceeds items_in. */
+    cfifoi_stats_copy(&p_cfifo->get_stats.seq,
+                      &p_cfifo->get_stats.items,
+                      get_words,
+                      2);
+    cfifoi_stats_copy(&p_cfifo->put_stats.seq,
+                      &p_cfifo->put_stats.items,
+                      put_words,
+                      3 + CFIFO_STATS_BINS);
+
+    p_stats->items_in = put_words[0];
+    p_stats->full_rejects = put_words[1];
+    p_stats->high_watermark = put_words[2];
+    for (i = 0; i < CFIFO_STATS_BINS; i++)
+    {
+        p_stats->occupancy[i] = put_words[3 + i];
+    }
+    p_stats->items_out = get_words[0];
+    p_stats->empty_rejects = get_words[1];
+    return CFIFO_SUCCESS;
+#else
+    return CFIFO_ERR_INVALID_STATE;
+#endif
+}
+
 size_t cfifo_size(cfifo_t p_cfifo)
 {
     return (NULL != p_cfifo && p_cfifo->p_buf != NULL) ? CFIFO_SIZE : 0;
@@ -253,8 +797,23 @@ cfifo_ret_t cfifo_flush(cfifo_t p_cfifo)
         return CFIFO_ERR_INVALID_STATE;
     }
 
-    p_cfifo->write_pos = 0;
-    p_cfifo->read_pos = 0;
+    if (CFIFO_OVERWRITE)
+    {
+        /* The producer may move read_pos as well. */
+        size_t read_pos = CFIFO_LOAD_ACQUIRE(p_cfifo->read_pos);
+
+        while (!CFIFO_CAS_WEAK_ACQ_REL(p_cfifo->read_pos,
+                                       &read_pos,
+                                       CFIFO_LOAD_ACQUIRE(p_cfifo->write_pos)))
+        {
+        }
+        return CFIFO_SUCCESS;
+    }
+
+    /* Only the consumer side position moves, so a concurrent producer is
+     * unaffected. */
+    p_cfifo->write_pos_cache = CFIFO_LOAD_ACQUIRE(p_cfifo->write_pos);
+    cfifoi_publish_read(p_cfifo, p_cfifo->write_pos_cache);
 
     return CFIFO_SUCCESS;
 }
@@ -263,26 +822,456 @@ cfifo_ret_t cfifo_flush(cfifo_t p_cfifo)
 
 static size_t cfifoi_available(cfifo_t p_cfifo)
 {
-    return p_cfifo->num_items_mask + 1 - cfifoi_size(p_cfifo);
+    return CFIFO_CAPACITY - cfifoi_size(p_cfifo);
 }
 static size_t cfifoi_size(cfifo_t p_cfifo)
 {
-    size_t tmp = p_cfifo->read_pos;
-    return p_cfifo->write_pos - tmp;
+    /* Read position first, it never passes the write position. */
+    size_t tmp = CFIFO_LOAD_ACQUIRE(p_cfifo->read_pos);
+    size_t size = CFIFO_POS_DIFF(CFIFO_LOAD_ACQUIRE(p_cfifo->write_pos), tmp);
+
+    /* An overwriting producer may have moved both in between. */
+    return MIN(size, CFIFO_CAPACITY);
 }
 
+/*
+ * Producer side free space, at least num_items if that much is free.
+ *
+ * The consumer's read_pos is only loaded when the cached copy does not show
+ * enough room, so the consumer's cache line is left alone while the fifo is
+ * not close to full. A cached value that is out of range (e.g. after the
+ * positions have been reset) is refreshed as well.
+ */
+static size_t cfifoi_write_available(cfifo_t p_cfifo, size_t num_items)
+{
+    size_t write_pos = CFIFO_LOAD_RELAXED(p_cfifo->write_pos);
+    size_t used = CFIFO_POS_DIFF(write_pos, p_cfifo->read_pos_cache);
+
+    if (used > CFIFO_CAPACITY || CFIFO_CAPACITY - used < num_items)
+    {
+        cfifoi_refresh_read_pos(p_cfifo);
+        used = CFIFO_POS_DIFF(write_pos, p_cfifo->read_pos_cache);
+    }
+    return CFIFO_CAPACITY - used;
+}
+
+/* Producer side, load the consumer's read_pos into read_pos_cache. */
+static void cfifoi_refresh_read_pos(cfifo_t p_cfifo)
+{
+    p_cfifo->read_pos_cache = CFIFO_LOAD_ACQUIRE(p_cfifo->read_pos);
+    if (CFIFO_INDEXED)
+    {
+        /* Slots below read_pos_cache may be overwritten from now on. */
+        cfifoi_index_sync(p_cfifo, p_cfifo->read_pos_cache);
+    }
+}
+
+/*
+ * Consumer side counterpart of cfifoi_write_available(), the producer's
+ * write_pos is only loaded when the cached copy shows too few items.
+ */
+static size_t cfifoi_read_size(cfifo_t p_cfifo, size_t num_items)
+{
+    size_t read_pos = CFIFO_LOAD_RELAXED(p_cfifo->read_pos);
+    size_t size = CFIFO_POS_DIFF(p_cfifo->write_pos_cache, read_pos);
+
+    if (size > CFIFO_CAPACITY || size < num_items)
+    {
+        p_cfifo->write_pos_cache = CFIFO_LOAD_ACQUIRE(p_cfifo->write_pos);
+        size = CFIFO_POS_DIFF(p_cfifo->write_pos_cache, read_pos);
+    }
+    return size;
+}
+
+/* Count the items at positions pos up to end. */
+static void cfifoi_index_add(cfifo_t p_cfifo, size_t pos, size_t end)
+{
+    const uint8_t *p_buf = CFIFO_BUF;
+
+    for (; pos != end; pos = CFIFO_POS_ADD(pos, 1))
+    {
+        cfifo_index_add(p_cfifo->p_index, &p_buf[CFIFO_OFFSET(pos)]);
+    }
+}
+
+/*
+ * Uncount the items the consumer has taken, up to read_pos. Their slots
+ * still hold them, the producer only reuses a slot after this has run for
+ * it. Producer side.
+ */
+static void cfifoi_index_sync(cfifo_t p_cfifo, size_t read_pos)
+{
+    cfifo_index_t p_index = p_cfifo->p_index;
+    const uint8_t *p_buf = CFIFO_BUF;
+    size_t write_pos = CFIFO_LOAD_RELAXED(p_cfifo->write_pos);
+    size_t pos;
+
+    if (CFIFO_POS_DIFF(read_pos, p_index->pos) >
+        CFIFO_POS_DIFF(write_pos, p_index->pos))
+    {
+        /* Positions were reset behind our back, recount. */
+        cfifo_index_clear(p_index);
+        cfifoi_index_add(p_cfifo, read_pos, write_pos);
+    }
+    else
+    {
+        for (pos = p_index->pos; pos != read_pos; pos = CFIFO_POS_ADD(pos, 1))
+        {
+            cfifo_index_remove(p_index, &p_buf[CFIFO_OFFSET(pos)]);
+        }
+    }
+    p_index->pos = read_pos;
+}
+
+/*
+ * Store a new write position for the consumer. With blocking waits or the
+ * notifier enabled the store is sequentially consistent and is followed by
+ * a check for a sleeping or armed consumer, see cfifo_wait.c and
+ * cfifo_notify.c. An attached index counts the new items first. Without
+ * any of these the cost is one test of flags that never change while the
+ * fifo is in use.
+ */
+static void cfifoi_publish_write(cfifo_t p_cfifo, size_t write_pos)
+{
+    if (CFIFO_INDEXED)
+    {
+        /* The new items are copied in but not published yet. */
+        cfifoi_index_add(p_cfifo, CFIFO_LOAD_RELAXED(p_cfifo->write_pos), write_pos);
+    }
+    CFIFO_STATS_PUT(CFIFO_POS_DIFF(write_pos, CFIFO_LOAD_RELAXED(p_cfifo->write_pos)),
+                    write_pos);
+
+    if (!CFIFO_SIGNALLED)
+    {
+        CFIFO_STORE_RELEASE(p_cfifo->write_pos, write_pos);
+        return;
+    }
+
+    CFIFO_STORE_SEQ_CST(p_cfifo->write_pos, write_pos);
+    if (p_cfifo->flags & CFIFO_FLAG_WAIT)
+    {
+        cfifo_wait_wake(&p_cfifo->write_pos, &p_cfifo->get_waiters);
+    }
+    if (p_cfifo->flags & CFIFO_FLAG_NOTIFY)
+    {
+        cfifo_notify_signal(p_cfifo->data_fd, &p_cfifo->data_armed);
+    }
+}
+
+static void cfifoi_publish_read(cfifo_t p_cfifo, size_t read_pos)
+{
+    CFIFO_STATS_GET(CFIFO_POS_DIFF(read_pos, CFIFO_LOAD_RELAXED(p_cfifo->read_pos)));
+    if (!CFIFO_SIGNALLED)
+    {
+        CFIFO_STORE_RELEASE(p_cfifo->read_pos, read_pos);
+        return;
+    }
+
+    CFIFO_STORE_SEQ_CST(p_cfifo->read_pos, read_pos);
+    if (p_cfifo->flags & CFIFO_FLAG_WAIT)
+    {
+        cfifo_wait_wake(&p_cfifo->read_pos, &p_cfifo->put_waiters);
+    }
+    if (p_cfifo->flags & CFIFO_FLAG_NOTIFY)
+    {
+        cfifo_notify_signal(p_cfifo->space_fd, &p_cfifo->space_armed);
+    }
+}
+
+/*
+ * The item is copied into its slot before the new write position is
+ * published with release semantics. A consumer that observes the position
+ * with an acquire load is therefore guaranteed to see the complete item.
+ */
 static void cfifoi_put(cfifo_t p_cfifo, const void * const p_item)
 {
-    memcpy(&p_cfifo->p_buf[CFIFO_WRITE_OFFSET],
+    size_t write_pos = CFIFO_LOAD_RELAXED(p_cfifo->write_pos);
+
+    memcpy(&CFIFO_BUF[CFIFO_OFFSET(write_pos)],
            p_item,
            p_cfifo->item_size);
-    p_cfifo->write_pos++;
+    cfifoi_publish_write(p_cfifo, CFIFO_POS_ADD(write_pos, 1));
 }
 
+/*
+ * Mirror of cfifoi_put(), the slot is released to the producer only after
+ * the item has been copied out of it.
+ */
 static void cfifoi_get(cfifo_t p_cfifo, void *p_item)
 {
+    size_t read_pos = CFIFO_LOAD_RELAXED(p_cfifo->read_pos);
+
     memcpy(p_item,
-           &p_cfifo->p_buf[CFIFO_READ_OFFSET],
+           &CFIFO_BUF[CFIFO_OFFSET(read_pos)],
            p_cfifo->item_size);
-    p_cfifo->read_pos++;
+    cfifoi_publish_read(p_cfifo, CFIFO_POS_ADD(read_pos, 1));
+}
+
+/*
+ * Batch versions of cfifoi_put()/cfifoi_get(). The items are copied with at
+ * most two memcpy calls, one up to the end of the buffer and one from the
+ * start of it after wraparound, followed by a single position update. With
+ * a mirrored buffer the first copy simply runs into the second mapping.
+ */
+static void cfifoi_write(cfifo_t p_cfifo,
+                         const uint8_t *p_src,
+                         size_t num_items)
+{
+    size_t write_pos = CFIFO_LOAD_RELAXED(p_cfifo->write_pos);
+
+    cfifoi_copy_in(p_cfifo, write_pos, p_src, num_items);
+    cfifoi_publish_write(p_cfifo, CFIFO_POS_ADD(write_pos, num_items));
+}
+
+static void cfifoi_read(cfifo_t p_cfifo, uint8_t *p_dest, size_t num_items)
+{
+    size_t read_pos = CFIFO_LOAD_RELAXED(p_cfifo->read_pos);
+
+    cfifoi_copy_out(p_cfifo, read_pos, p_dest, num_items);
+    cfifoi_publish_read(p_cfifo, CFIFO_POS_ADD(read_pos, num_items));
+}
+
+static void cfifoi_copy_in(cfifo_t p_cfifo,
+                           size_t pos,
+                           const uint8_t *p_src,
+                           size_t num_items)
+{
+    uint8_t *p_buf = CFIFO_BUF;
+    size_t offset = CFIFO_OFFSET(pos);
+    size_t num_bytes = num_items * p_cfifo->item_size;
+    size_t first = CFIFO_MIRRORED ? num_bytes :
+                   MIN(num_bytes, CFIFO_CAPACITY * p_cfifo->item_size - offset);
+
+    cfifoi_copy(p_cfifo, &p_buf[offset], p_src, first);
+    if (num_bytes > first)
+    {
+        cfifoi_copy(p_cfifo, p_buf, &p_src[first], num_bytes - first);
+    }
+}
+
+static void cfifoi_copy_out(cfifo_t p_cfifo,
+                            size_t pos,
+                            uint8_t *p_dest,
+                            size_t num_items)
+{
+    const uint8_t *p_buf = CFIFO_BUF;
+    size_t offset = CFIFO_OFFSET(pos);
+    size_t num_bytes = num_items * p_cfifo->item_size;
+    size_t first = CFIFO_MIRRORED ? num_bytes :
+                   MIN(num_bytes, CFIFO_CAPACITY * p_cfifo->item_size - offset);
+
+    cfifoi_copy(p_cfifo, p_dest, &p_buf[offset], first);
+    if (num_bytes > first)
+    {
+        cfifoi_copy(p_cfifo, &p_dest[first], p_buf, num_bytes - first);
+    }
+}
+
+/*
+ * memcpy, except in overwrite mode where a slot may be read and rewritten
+ * at the same time: every word is then copied with a relaxed atomic load
+ * and store, and the torn copy is thrown away by the consumer.
+ */
+static void cfifoi_copy(cfifo_t p_cfifo,
+                        uint8_t *p_dest,
+                        const uint8_t *p_src,
+                        size_t num_bytes)
+{
+    size_t i;
+
+    if (!CFIFO_OVERWRITE)
+    {
+        memcpy(p_dest, p_src, num_bytes);
+    }
+    else if ((((uintptr_t) p_dest | (uintptr_t) p_src | num_bytes) % sizeof(size_t)) == 0)
+    {
+        size_t *p_dest_words = (size_t *) (void *) p_dest;
+        const size_t *p_src_words = (const size_t *) (const void *) p_src;
+
+        for (i = 0; i < num_bytes / sizeof(size_t); i++)
+        {
+            CFIFO_STORE_RELAXED(p_dest_words[i], CFIFO_LOAD_RELAXED(p_src_words[i]));
+        }
+    }
+    else
+    {
+        for (i = 0; i < num_bytes; i++)
+        {
+            CFIFO_STORE_RELAXED(p_dest[i], CFIFO_LOAD_RELAXED(p_src[i]));
+        }
+    }
+}
+
+/*
+ * Overwrite mode producer. read_pos is first moved past the items the new
+ * ones will replace, with an acquire compare-and-swap so the slots are only
+ * rewritten after it; a consumer that took items meanwhile makes it retry.
+ */
+static void cfifoi_overwrite_write(cfifo_t p_cfifo,
+                                   const uint8_t *p_src,
+                                   size_t num_items)
+{
+    size_t write_pos = CFIFO_LOAD_RELAXED(p_cfifo->write_pos);
+    size_t read_pos = CFIFO_LOAD_ACQUIRE(p_cfifo->read_pos);
+    size_t lost;
+
+    while (write_pos + num_items - read_pos > CFIFO_CAPACITY)
+    {
+        lost = write_pos + num_items - CFIFO_CAPACITY - read_pos;
+        if (CFIFO_CAS_WEAK_ACQ_REL(p_cfifo->read_pos, &read_pos, read_pos + lost))
+        {
+            CFIFO_STORE_RELAXED(p_cfifo->overwritten, p_cfifo->overwritten + lost);
+            break;
+        }
+    }
+
+    cfifoi_write(p_cfifo, p_src, num_items);
+}
+
+/*
+ * Overwrite mode consumer, seqlock style: copy up to num_items items out,
+ * then take them (or with remove cleared just check them) with a release
+ * compare-and-swap of read_pos. The producer moves read_pos before it
+ * rewrites a slot, so if read_pos is unchanged the copy is intact,
+ * otherwise it was lapped and the copy is redone from the new read_pos.
+ * The producer never waits for space here, so there is nobody to wake.
+ */
+static size_t cfifoi_overwrite_read(cfifo_t p_cfifo,
+                                    uint8_t *p_dest,
+                                    size_t num_items,
+                                    int remove)
+{
+    size_t read_pos = CFIFO_LOAD_ACQUIRE(p_cfifo->read_pos);
+    size_t size;
+
+    for (;;)
+    {
+        size = CFIFO_LOAD_ACQUIRE(p_cfifo->write_pos) - read_pos;
+        if (size > CFIFO_CAPACITY)
+        {
+            /* Stale read_pos, the producer has moved on. */
+            read_pos = CFIFO_LOAD_ACQUIRE(p_cfifo->read_pos);
+            continue;
+        }
+
+        size = MIN(size, num_items);
+        if (0 == size)
+        {
+            return 0;
+        }
+
+        cfifoi_copy_out(p_cfifo, read_pos, p_dest, size);
+        if (CFIFO_CAS_WEAK_ACQ_REL(p_cfifo->read_pos,
+                                   &read_pos,
+                                   remove ? read_pos + size : read_pos))
+        {
+            if (remove)
+            {
+                CFIFO_STATS_GET(size);
+            }
+            return size;
+        }
+    }
 }
+
+/*
+ * Spans of the stored items, for the read-only scans. They go from a local
+ * copy of the read position, the shared one must not move since the
+ * producer uses it to decide which slots are free.
+ */
+static void cfifoi_stored_spans(cfifo_t p_cfifo, cfifo_span_t p_spans[2])
+{
+    size_t read_pos = CFIFO_LOAD_RELAXED(p_cfifo->read_pos);
+
+    cfifo_pos_spans(p_cfifo, read_pos, CFIFO_SIZE, p_spans);
+}
+
+#if defined(CFIFO_STATS)
+
+/*
+ * The statistics blocks are seqlocks with a single writer, the side that
+ * owns them. The counters are stored with release and loaded with acquire
+ * semantics, so a reader that saw any new counter also sees the odd seq
+ * that came before it, and no fences are needed.
+ */
+static void cfifoi_stats_put(cfifo_t p_cfifo, size_t num_items, size_t write_pos)
+{
+    struct cfifo_put_stats_s *p_stats = &p_cfifo->put_stats;
+    size_t seq = p_stats->seq;
+    size_t size;
+    size_t bin;
+
+    if (0 == num_items)
+    {
+        return;
+    }
+
+    /*
+     * read_pos_cache is only refreshed when space runs short, and never in
+     * overwrite mode, so it would show a full fifo after the first lap. The
+     * relaxed load reads the consumer's line, the price of an exact fill
+     * level in a stats build, and is not used to reuse any slots.
+     */
+    size = MIN(CFIFO_POS_DIFF(write_pos, CFIFO_LOAD_RELAXED(p_cfifo->read_pos)),
+               CFIFO_CAPACITY);
+    for (bin = 0; (size >> bin) > 0; bin++)
+    {
+    }
+
+    CFIFO_STORE_RELAXED(p_stats->seq, seq + 1);
+    CFIFO_STORE_RELEASE(p_stats->items, p_stats->items + num_items);
+    if (size > p_stats->high_watermark)
+    {
+        CFIFO_STORE_RELEASE(p_stats->high_watermark, size);
+    }
+    CFIFO_STORE_RELEASE(p_stats->occupancy[bin], p_stats->occupancy[bin] + 1);
+    CFIFO_STORE_RELEASE(p_stats->seq, seq + 2);
+}
+
+static void cfifoi_stats_get(cfifo_t p_cfifo, size_t num_items)
+{
+    struct cfifo_get_stats_s *p_stats = &p_cfifo->get_stats;
+    size_t seq = p_stats->seq;
+
+    if (0 == num_items)
+    {
+        return;
+    }
+
+    CFIFO_STORE_RELAXED(p_stats->seq, seq + 1);
+    CFIFO_STORE_RELEASE(p_stats->items, p_stats->items + num_items);
+    CFIFO_STORE_RELEASE(p_stats->seq, seq + 2);
+}
+
+static void cfifoi_stats_reject(size_t *p_seq, size_t *p_rejects)
+{
+    size_t seq = *p_seq;
+
+    CFIFO_STORE_RELAXED(*p_seq, seq + 1);
+    CFIFO_STORE_RELEASE(*p_rejects, *p_rejects + 1);
+    CFIFO_STORE_RELEASE(*p_seq, seq + 2);
+}
+
+/* Copy num_words counters that follow *p_seq as one consistent set. */
+static void cfifoi_stats_copy(const size_t *p_seq,
+                              const size_t *p_src,
+                              size_t *p_dest,
+                              size_t num_words)
+{
+    size_t seq;
+    size_t i;
+
+    do
+    {
+        while ((seq = CFIFO_LOAD_ACQUIRE(*p_seq)) & 1)
+        {
+            CFIFO_CPU_RELAX();
+        }
+        for (i = 0; i < num_words; i++)
+        {
+            p_dest[i] = CFIFO_LOAD_ACQUIRE(p_src[i]);
+        }
+    } while (CFIFO_LOAD_RELAXED(*p_seq) != seq);
+}
+
+#endif /* CFIFO_STATS */
@@ -20,28 +20,114 @@ extern "C" {
 
 /*======= Public macro definitions ==========================================*/
 
+/*
+ * With CFIFO_SEPARATE_CACHE_LINES defined the producer owned and the consumer
+ * owned parts of struct cfifo_s are placed on separate cache lines, and the
+ * buffers created by the CFIFO_CREATE/CFIFO_DEF macros are cache line
+ * aligned. This avoids false sharing when the producer and the consumer run
+ * on different cores, at the cost of a larger struct. The define must be the
+ * same for the library and all code using it.
+ */
+#ifndef CFIFO_CACHE_LINE_SIZE
+#define CFIFO_CACHE_LINE_SIZE   64
+#endif
+
+#if defined(__GNUC__)
+#define CFIFO_ALIGNED(n)        __attribute__((aligned(n)))
+#else
+#define CFIFO_ALIGNED(n)
+#endif
+
+#if defined(CFIFO_SEPARATE_CACHE_LINES)
+#define CFIFO_CACHE_ALIGNED     CFIFO_ALIGNED(CFIFO_CACHE_LINE_SIZE)
+#else
+#define CFIFO_CACHE_ALIGNED
+#endif
+
+/*
+ * With CFIFO_STATS defined every fifo keeps operational statistics, see
+ * cfifo_stats_snapshot(). Each side updates only its own block, next to its
+ * own position; the producer also loads read_pos after each put to
+ * measure the fill level. Off by default, the define must be the same for
+ * the library and all code using it.
+ */
+#define CFIFO_STATS_BINS        (8 * sizeof(size_t) + 1)
+
+#if defined(CFIFO_STATS)
+#define CFIFO_STATS_DEF         {0, 0, 0},
+#define CFIFO_STATS_DEF_LAST    , {0, 0, 0, 0, {0}}
+#else
+#define CFIFO_STATS_DEF
+#define CFIFO_STATS_DEF_LAST
+#endif
+
+/*
+ * With CFIFO_UNCHECKED and NDEBUG defined, i.e. in release builds only,
+ * cfifo_put(), cfifo_get(), cfifo_write(), cfifo_read() and their inline
+ * versions skip their NULL pointer and state checks. Passing NULL or an
+ * uninitialized fifo is then undefined behaviour. Debug and sanitizer
+ * builds keep the checks.
+ */
+#if defined(CFIFO_UNCHECKED) && defined(NDEBUG)
+#define CFIFO_CHECKED           0
+#else
+#define CFIFO_CHECKED           1
+#endif
+
+/*
+ * Inline function specifier usable in C89 code, used by the header-only
+ * parts of the library.
+ */
+#if defined(__cplusplus) || (defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L)
+#define CFIFO_STATIC_INLINE     static inline
+#elif defined(__GNUC__)
+#define CFIFO_STATIC_INLINE     static __inline__
+#else
+#define CFIFO_STATIC_INLINE     static
+#endif
 
 /*
  * Helper macros that results in compile error if the capacity (number of items)
- * is not a power of 2. I.e., 2, 4, 8, 16, ... 2^n.
+ * is 0 or too large. Any other capacity works, a power of 2 (2, 4, 8, 16, ...
+ * 2^n) is the fastest, see cfifo_pos.h.
  */
 #define CFIFO_IS_POW_2(x)   (((x) > 0) && (((x) & (((x) - 1))) == 0))
+#define CFIFO_IS_CAPACITY(x) (((x) > 0) && ((x) <= SIZE_MAX / 2))
+#define CFIFO_POS_WRAP(x)   (CFIFO_IS_POW_2(x) ? 0 : 2 * (size_t) (x))
 #define CFIFO_BUF_SIZE(y, x) \
-        ((CFIFO_IS_POW_2(x) && (((x)*(y)) <= SIZE_MAX)) ? (int) ((x)*(y)) : (int) -1)
+        ((CFIFO_IS_CAPACITY(x) && (((x)*(y)) <= SIZE_MAX)) ? (int) ((x)*(y)) : (int) -1)
+
+/* Returned by cfifo_find() when there is no matching item. */
+#define CFIFO_NOT_FOUND     ((size_t) -1)
 
 #define CFIFO_STRUCT_DEF(type, capacity, buf)                           \
     {                                                                   \
         buf,                                                            \
         ((capacity) - 1),                                               \
+        CFIFO_POS_WRAP(capacity),                                       \
         sizeof(type),                                                   \
         0,                                                              \
+        0,                                                              \
+        0,                                                              \
+        0,                                                              \
+        0,                                                              \
+        0,                                                              \
+        0,                                                              \
+        CFIFO_STATS_DEF                                                 \
+        0,                                                              \
+        0,                                                              \
+        0,                                                              \
+        0,                                                              \
+        0,                                                              \
         0                                                               \
+        CFIFO_STATS_DEF_LAST                                            \
     }
 
 #define CFIFO_CREATE(p_cfifo, type, capacity) \
     uint8_t                                                             \
             p_cfifo##cfifo_buf##buf##__LINE__                           \
-            [CFIFO_BUF_SIZE((sizeof(type)),(capacity))] = {0};          \
+            [CFIFO_BUF_SIZE((sizeof(type)),(capacity))]                 \
+            CFIFO_CACHE_ALIGNED = {0};                                  \
     struct cfifo_s p_cfifo##data##__LINE__ = CFIFO_STRUCT_DEF(          \
         type, capacity, p_cfifo##cfifo_buf##buf##__LINE__               \
     );                                                                  \
@@ -49,7 +135,8 @@ extern "C" {
 #define CFIFO_CREATE_STATIC(p_cfifo, type, capacity) \
     static uint8_t                                                      \
             p_cfifo##cfifo_buf##buf##__LINE__                           \
-            [CFIFO_BUF_SIZE((sizeof(type)),(capacity))];                \
+            [CFIFO_BUF_SIZE((sizeof(type)),(capacity))]                 \
+            CFIFO_CACHE_ALIGNED;                                        \
     static struct cfifo_s p_cfifo##data##__LINE__ = CFIFO_STRUCT_DEF(   \
         type, capacity, p_cfifo##cfifo_buf##buf##__LINE__               \
     );                                                                  \
@@ -58,33 +145,131 @@ extern "C" {
 #define CFIFO_DEF(p_cfifo, type, capacity)                              \
     uint8_t                                                             \
             p_cfifo##cfifo_buf##buf##__LINE__                           \
-            [CFIFO_BUF_SIZE((sizeof(type)),(capacity))] = {0};          \
+            [CFIFO_BUF_SIZE((sizeof(type)),(capacity))]                 \
+            CFIFO_CACHE_ALIGNED = {0};                                  \
     struct cfifo_s p_cfifo##data##__LINE__ =  CFIFO_STRUCT_DEF(         \
         type, capacity, p_cfifo##cfifo_buf##buf##__LINE__               \
     );                                                                  \
     cfifo_t p_cfifo = &p_cfifo##data##__LINE__
 
+/* Values for struct cfifo_s flags. */
+#define CFIFO_FLAG_MIRRORED     0x01u   /* Buffer is mapped twice back-to-back */
+#define CFIFO_FLAG_WAIT         0x02u   /* Blocking waits enabled, cfifo_wait.h */
+#define CFIFO_FLAG_NOTIFY       0x04u   /* eventfd notifier, cfifo_notify.h */
+#define CFIFO_FLAG_RELATIVE     0x08u   /* p_buf is an offset, cfifo_shm.h */
+#define CFIFO_FLAG_INDEX        0x10u   /* p_index is attached, cfifo_index.h */
+#define CFIFO_FLAG_OVERWRITE    0x20u   /* Full puts drop the oldest items */
+
 /*======= Type Definitions and declarations =================================*/
 
 typedef struct cfifo_s *cfifo_t;
+typedef struct cfifo_index_s *cfifo_index_t;
+
+/* Statistics of a fifo, see cfifo_stats_snapshot(). */
+struct cfifo_stats_s {
+    /* Items put and taken. */
+    size_t  items_in;
+    size_t  items_out;
+    /* Put calls that stored nothing because the fifo was full. */
+    size_t  full_rejects;
+    /* Get calls that took nothing because the fifo was empty. */
+    size_t  empty_rejects;
+    /* Most items ever stored at once. */
+    size_t  high_watermark;
+    /*
+     * Fill level after each put call: occupancy[0] counts calls that left
+     * the fifo empty, occupancy[i] calls that left 2^(i-1) to 2^i - 1 items.
+     */
+    size_t  occupancy[CFIFO_STATS_BINS];
+};
+
+/*
+ * Per side statistics blocks in struct cfifo_s with CFIFO_STATS. seq is odd
+ * while the owning side updates the block.
+ */
+struct cfifo_put_stats_s {
+    size_t  seq;
+    size_t  items;
+    size_t  rejects;
+    size_t  high_watermark;
+    size_t  occupancy[CFIFO_STATS_BINS];
+};
 
+struct cfifo_get_stats_s {
+    size_t  seq;
+    size_t  items;
+    size_t  rejects;
+};
+
+/*
+ * One producer thread (cfifo_put, cfifo_write) and one consumer thread
+ * (cfifo_get, cfifo_read, cfifo_peek, cfifo_contains, cfifo_flush) may use
+ * the same cfifo concurrently without any locking. The positions are
+ * published with release/acquire ordering, see cfifo_atomic.h.
+ */
 struct cfifo_s {
+    /* Offset from the struct instead with CFIFO_FLAG_RELATIVE. */
     uint8_t         *p_buf;
+    /* Capacity - 1, a mask with a power of 2 capacity. */
     size_t          num_items_mask;
+    /* 0 or where positions wrap, see cfifo_pos.h. */
+    size_t          pos_wrap;
     size_t          item_size;
-    volatile size_t read_pos;
-    volatile size_t write_pos;
+    unsigned int    flags;
+    /* eventfds of the notifier, see cfifo_notify.h. */
+    int             data_fd;
+    int             space_fd;
+    /* Consumer owned, write_pos_cache is the last write_pos it has seen. */
+    volatile size_t read_pos CFIFO_CACHE_ALIGNED;
+    size_t          write_pos_cache;
+    /* Producers sleeping in cfifo_put_wait(), checked by the consumer. */
+    volatile unsigned int put_waiters;
+    /* Producer wants space_fd signalled, checked by the consumer. */
+    volatile unsigned int space_armed;
+#if defined(CFIFO_STATS)
+    struct cfifo_get_stats_s get_stats;
+#endif
+    /* Producer owned, read_pos_cache is the last read_pos it has seen. */
+    volatile size_t write_pos CFIFO_CACHE_ALIGNED;
+    size_t          read_pos_cache;
+    /* Consumers sleeping in cfifo_get_wait(), checked by the producer. */
+    volatile unsigned int get_waiters;
+    /* Consumer wants data_fd signalled, checked by the producer. */
+    volatile unsigned int data_armed;
+    /* Index of the stored items, see cfifo_attach_index(). */
+    cfifo_index_t   p_index;
+    /* Items dropped by the producer, see cfifo_enable_overwrite(). */
+    volatile size_t overwritten;
+#if defined(CFIFO_STATS)
+    struct cfifo_put_stats_s put_stats;
+#endif
 };
 
+/*
+ * A contiguous range of items inside the fifo buffer. Ranges that wrap
+ * around the end of the buffer are described by two spans, the second one
+ * starting at the beginning of the buffer.
+ */
+typedef struct cfifo_span_s {
+    uint8_t *p_data;
+    size_t  num_items;
+} cfifo_span_t;
+
 typedef enum cfifo_ret_e {
     CFIFO_SUCCESS,
     CFIFO_ERR_NULL,
     CFIFO_ERR_EMPTY,
     CFIFO_ERR_FULL,
     CFIFO_ERR_BAD_SIZE,
-    CFIFO_ERR_INVALID_STATE
+    CFIFO_ERR_INVALID_STATE,
+    CFIFO_ERR_NO_MEM,
+    CFIFO_ERR_TIMEOUT,
+    CFIFO_ERR_MISMATCH
 } cfifo_ret_t;
 
+/* Item predicate for cfifo_count_if(). */
+typedef int (*cfifo_pred_t)(const void *p_item, void *p_arg);
+
 /*======= Public function declarations ======================================*/
 
 /**
@@ -106,6 +291,54 @@ cfifo_ret_t cfifo_init(cfifo_t p_cfifo,
                        size_t item_size,
                        size_t buf_size);
 
+/**
+ * @brief Initialize a fifo on a mirrored buffer.
+ *
+ * Same as cfifo_init(), but p_buf must be mapped twice back-to-back, i.e.
+ * p_buf[i] and p_buf[buf_size + i] are the same byte, see
+ * cfifo_mirror_alloc() in cfifo_mem.h. Batches and spans then never have to
+ * be split at the end of the buffer: cfifo_write()/cfifo_read() do a single
+ * memcpy and cfifo_reserve()/cfifo_acquire() always return one span.
+ *
+ * @param   p_cfifo
+ * @param   p_buf
+ * @param   num_items
+ * @param   item_size
+ * @param   buf_size    Size of one of the two mappings.
+ *
+ * @return  CFIFO_SUCCESS
+ *
+ */
+cfifo_ret_t cfifo_init_mirrored(cfifo_t p_cfifo,
+                                uint8_t *p_buf,
+                                size_t num_items,
+                                size_t item_size,
+                                size_t buf_size);
+
+/**
+ * @brief Initialize a fifo that does not depend on its own address.
+ *
+ * Same as cfifo_init(), but p_buf is stored as an offset from p_cfifo, so
+ * the struct and the buffer can be placed in memory that is mapped at
+ * different addresses, e.g. shared memory, see cfifo_shm.h. p_buf must come
+ * after p_cfifo in memory and keep its distance from it.
+ *
+ * @param   p_cfifo
+ * @param   p_buf
+ * @param   num_items
+ * @param   item_size
+ * @param   buf_size
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_BAD_SIZE if p_buf does not come after p_cfifo
+ *
+ */
+cfifo_ret_t cfifo_init_relative(cfifo_t p_cfifo,
+                                uint8_t *p_buf,
+                                size_t num_items,
+                                size_t item_size,
+                                size_t buf_size);
+
 /**
  * @brief TODO: Brief description.
  *
@@ -136,6 +369,25 @@ cfifo_ret_t cfifo_write(cfifo_t p_cfifo,
                         const void * const p_items,
                         size_t * const p_num_items);
 
+/**
+ * @brief Write exactly num_items items or nothing at all.
+ *
+ * Unlike cfifo_write(), which writes as many items as fit, nothing is written
+ * unless there is room for all of them.
+ *
+ * @param   p_cfifo
+ * @param   p_items
+ * @param   num_items
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_FULL if fewer than num_items items are free
+ * @return  CFIFO_ERR_BAD_SIZE if num_items is larger than the capacity
+ *
+ */
+cfifo_ret_t cfifo_write_bulk(cfifo_t p_cfifo,
+                             const void * const p_items,
+                             size_t num_items);
+
 /**
  * @brief TODO: Brief description.
  *
@@ -166,6 +418,25 @@ cfifo_ret_t cfifo_read(cfifo_t p_cfifo,
                        void *p_items,
                        size_t *p_num_items);
 
+/**
+ * @brief Read exactly num_items items or nothing at all.
+ *
+ * Unlike cfifo_read(), which reads as many items as are available, nothing
+ * is read unless the fifo holds at least num_items items.
+ *
+ * @param   p_cfifo
+ * @param   p_items
+ * @param   num_items
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_EMPTY if fewer than num_items items are stored
+ * @return  CFIFO_ERR_BAD_SIZE if num_items is larger than the capacity
+ *
+ */
+cfifo_ret_t cfifo_read_bulk(cfifo_t p_cfifo,
+                            void *p_items,
+                            size_t num_items);
+
 /**
  * @brief TODO: Brief description.
  *
@@ -181,17 +452,204 @@ cfifo_ret_t cfifo_peek(cfifo_t p_cfifo,
                        void *p_item);
 
 /**
- * @brief [brief description]
- * @details [long description]
- * 
- * @param p_cfifo [description]
- * @param p_item [description]
- * 
- * @return
+ * @brief Reserve the free part of the buffer for writing in place.
+ *
+ * Fills p_spans with the free slots, starting at the write position. The
+ * second span is only non-empty when the free slots wrap around the end of
+ * the buffer. Nothing is visible to the consumer until cfifo_commit() is
+ * called. Producer side only.
+ *
+ * @param   p_cfifo
+ * @param   p_spans     Two spans, filled in on return.
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_FULL if there are no free slots
+ *
+ */
+cfifo_ret_t cfifo_reserve(cfifo_t p_cfifo,
+                          cfifo_span_t p_spans[2]);
+
+/**
+ * @brief Publish num_items items written in place after cfifo_reserve().
+ *
+ * @param   p_cfifo
+ * @param   num_items
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_BAD_SIZE if num_items is more than the free slots
+ *
+ */
+cfifo_ret_t cfifo_commit(cfifo_t p_cfifo,
+                         size_t num_items);
+
+/**
+ * @brief Acquire the stored items for reading in place.
+ *
+ * Fills p_spans with the stored items, oldest first. The second span is only
+ * non-empty when the items wrap around the end of the buffer. The slots are
+ * not handed back to the producer until cfifo_release() is called. Consumer
+ * side only.
+ *
+ * @param   p_cfifo
+ * @param   p_spans     Two spans, filled in on return.
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_EMPTY if the fifo is empty
+ *
+ */
+cfifo_ret_t cfifo_acquire(cfifo_t p_cfifo,
+                          cfifo_span_t p_spans[2]);
+
+/**
+ * @brief Release num_items items read in place after cfifo_acquire().
+ *
+ * @param   p_cfifo
+ * @param   num_items
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_BAD_SIZE if num_items is more than the stored items
+ *
+ */
+cfifo_ret_t cfifo_release(cfifo_t p_cfifo,
+                          size_t num_items);
+
+/**
+ * @brief Number of stored items equal to p_item.
+ *
+ * Compares every stored item, O(size * item_size), on the consumer side.
+ * With an index attached (cfifo_attach_index()) it is a hash lookup instead
+ * and must be called on the producer side.
+ *
+ * @param   p_cfifo
+ * @param   p_item
+ *
+ * @return  Number of matching items, 0 on NULL pointers.
  */
 size_t cfifo_contains(cfifo_t p_cfifo,
                         void *p_item);
 
+/**
+ * @brief Position of the oldest stored item equal to p_item.
+ *
+ * Stops at the first match. Consumer side, read_pos is not changed.
+ *
+ * @param   p_cfifo
+ * @param   p_item
+ *
+ * @return  Index of the match counted from the oldest item (0 is the next
+ *          item cfifo_get() returns), CFIFO_NOT_FOUND if there is none or
+ *          on NULL pointers.
+ */
+size_t cfifo_find(cfifo_t p_cfifo,
+                  const void *p_item);
+
+/**
+ * @brief Number of stored items for which pred returns non-zero.
+ *
+ * pred is called with every stored item, oldest first, and p_arg. Consumer
+ * side, read_pos is not changed.
+ *
+ * @param   p_cfifo
+ * @param   pred
+ * @param   p_arg
+ *
+ * @return  Number of matching items, 0 on NULL pointers.
+ */
+size_t cfifo_count_if(cfifo_t p_cfifo,
+                      cfifo_pred_t pred,
+                      void *p_arg);
+
+/**
+ * @brief Keep p_index up to date with the stored items.
+ *
+ * p_index must be initialized with cfifo_index_init(), with item_size as
+ * key size and more entries than the fifo capacity. The stored items are
+ * counted right away. After that the producer side functions add the items
+ * they store and remove the items the consumer has taken, before their
+ * slots are reused; the consumer side is not affected. cfifo_contains()
+ * then becomes a producer side O(1) lookup.
+ *
+ * Producer side, not for fifos shared between processes.
+ *
+ * @param   p_cfifo
+ * @param   p_index
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_BAD_SIZE if the index does not match the fifo
+ *
+ */
+cfifo_ret_t cfifo_attach_index(cfifo_t p_cfifo,
+                               cfifo_index_t p_index);
+
+/**
+ * @brief Stop updating the attached index.
+ *
+ * @param   p_cfifo
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ *
+ */
+cfifo_ret_t cfifo_detach_index(cfifo_t p_cfifo);
+
+/**
+ * @brief Let a full fifo drop its oldest items instead of failing puts.
+ *
+ * cfifo_put(), cfifo_write() and cfifo_write_bulk() then always store
+ * their items, moving read_pos past the items they overwrite, which are
+ * counted in cfifo_overwritten(). cfifo_write() keeps only the last
+ * capacity items of a larger batch. Call before the fifo is used.
+ *
+ * Both sides move read_pos with a compare-and-swap. The consumer copies
+ * items out and only takes them if read_pos did not move meanwhile; if the
+ * producer lapped it, the copy is retried from the new read_pos. Items are
+ * copied word by word with atomic accesses. cfifo_reserve(),
+ * cfifo_acquire() and an index are not available, and the scans
+ * (cfifo_contains() etc.) are only exact while the producer is idle.
+ *
+ * @param   p_cfifo
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_INVALID_STATE if an index is attached or the capacity
+ *          is not a power of 2, the lap check needs free running positions
+ *
+ */
+cfifo_ret_t cfifo_enable_overwrite(cfifo_t p_cfifo);
+
+/**
+ * @brief Number of items dropped by a full fifo, see
+ *        cfifo_enable_overwrite(). Any side.
+ *
+ * @param   p_cfifo
+ *
+ * @return  Total number of overwritten items, 0 on NULL pointers.
+ */
+size_t cfifo_overwritten(cfifo_t p_cfifo);
+
+/**
+ * @brief Copy the statistics of a fifo, from any thread.
+ *
+ * Each side's counters are read as one consistent set, retrying while that
+ * side is updating them; the consumer's set is taken first, so items_out
+ * never exceeds items_in. The fill level for the high watermark and the
+ * occupancy histogram is taken by the producer right after each put,
+ * against the read position at that moment. A get racing with the put may
+ * not be counted yet, so it can be a little higher than the consumer saw.
+ *
+ * @param   p_cfifo
+ * @param   p_stats
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_INVALID_STATE if the library was built without
+ *          CFIFO_STATS, *p_stats is zeroed then
+ *
+ */
+cfifo_ret_t cfifo_stats_snapshot(cfifo_t p_cfifo,
+                                 struct cfifo_stats_s *p_stats);
+
 /**
  * @brief TODO: Brief description.
  *
@@ -235,4 +693,9 @@ cfifo_ret_t cfifo_flush(cfifo_t p_cfifo);
 }
 #endif
 
+/* cfifo_put() and friends as inline functions, see cfifo_inline.h. */
+#if defined(CFIFO_INLINE)
+#include "cfifo_inline.h"
+#endif
+
 #endif /* _CFIFO_H_ */
@@ -0,0 +1,220 @@
+#ifndef _CFIFO_HPP_
+#define _CFIFO_HPP_
+
+/**
+ * @file cfifo.hpp
+ *
+ * Header-only C++11 ring buffer, cfifo::ring<T, N>.
+ *
+ * Same position/mask design as cfifo_t: free running read and write
+ * positions, a power of 2 capacity and single-producer/single-consumer
+ * thread safety with release/acquire ordering. Unlike cfifo_t the items are
+ * objects, not bytes. They are constructed in place in uninitialized storage
+ * and moved in and out, so types that are not trivially copyable, e.g.
+ * std::unique_ptr, can be queued.
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+/* C++ library includes */
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/* Local includes */
+#include "cfifo.h"
+
+namespace cfifo {
+
+/*======= Type Definitions and declarations =================================*/
+
+template <typename T, std::size_t N>
+class ring {
+
+    static_assert(CFIFO_IS_POW_2(N), "ring capacity must be a power of 2");
+
+public:
+
+    typedef T value_type;
+    typedef std::size_t size_type;
+
+    ring() noexcept
+        : read_pos_(0), write_pos_cache_(0), write_pos_(0), read_pos_cache_(0)
+    {
+    }
+
+    ~ring()
+    {
+        clear();
+    }
+
+    ring(const ring &) = delete;
+    ring &operator=(const ring &) = delete;
+
+    static constexpr size_type capacity() noexcept
+    {
+        return N;
+    }
+
+    static constexpr size_type max_size() noexcept
+    {
+        return N;
+    }
+
+    /**
+     * @brief Construct an item in place from args.
+     *
+     * @return  false if the ring is full, nothing is constructed then.
+     */
+    template <typename... Args>
+    bool emplace(Args &&... args)
+    {
+        const size_type write_pos = write_pos_.load(std::memory_order_relaxed);
+
+        if (write_available(1) == 0)
+        {
+            return false;
+        }
+        ::new (static_cast<void *>(slot(write_pos)))
+                T(std::forward<Args>(args)...);
+        write_pos_.store(write_pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_push(const T &item)
+    {
+        return emplace(item);
+    }
+
+    bool try_push(T &&item)
+    {
+        return emplace(std::move(item));
+    }
+
+    /**
+     * @brief Move the oldest item into item and destroy it in the ring.
+     *
+     * @return  false if the ring is empty, item is left untouched then.
+     */
+    bool try_pop(T &item)
+    {
+        const size_type read_pos = read_pos_.load(std::memory_order_relaxed);
+        T *p_item;
+
+        if (read_size(1) == 0)
+        {
+            return false;
+        }
+        p_item = slot(read_pos);
+        item = std::move(*p_item);
+        p_item->~T();
+        read_pos_.store(read_pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Oldest item, or nullptr if the ring is empty. Consumer side.
+     */
+    T *front()
+    {
+        const size_type read_pos = read_pos_.load(std::memory_order_relaxed);
+        return (read_size(1) == 0) ? nullptr : slot(read_pos);
+    }
+
+    /**
+     * @brief Destroy the oldest item. Consumer side, ring must not be empty.
+     */
+    void pop()
+    {
+        const size_type read_pos = read_pos_.load(std::memory_order_relaxed);
+        slot(read_pos)->~T();
+        read_pos_.store(read_pos + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Destroy all stored items. Consumer side.
+     */
+    void clear()
+    {
+        while (front() != nullptr)
+        {
+            pop();
+        }
+    }
+
+    size_type size() const noexcept
+    {
+        /* Read position first, it never passes the write position. */
+        const size_type tmp = read_pos_.load(std::memory_order_acquire);
+        return write_pos_.load(std::memory_order_acquire) - tmp;
+    }
+
+    size_type available() const noexcept
+    {
+        return N - size();
+    }
+
+    bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+private:
+
+    typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type
+            storage_type;
+
+#if defined(CFIFO_SEPARATE_CACHE_LINES)
+    static constexpr size_type line_align = CFIFO_CACHE_LINE_SIZE;
+#else
+    static constexpr size_type line_align = alignof(std::atomic<size_type>);
+#endif
+
+    T *slot(size_type pos) noexcept
+    {
+        return reinterpret_cast<T *>(&buf_[pos & (N - 1)]);
+    }
+
+    /* See cfifoi_write_available() in cfifo.c. */
+    size_type write_available(size_type num_items) noexcept
+    {
+        const size_type write_pos = write_pos_.load(std::memory_order_relaxed);
+        size_type used = write_pos - read_pos_cache_;
+
+        if (used > N || N - used < num_items)
+        {
+            read_pos_cache_ = read_pos_.load(std::memory_order_acquire);
+            used = write_pos - read_pos_cache_;
+        }
+        return N - used;
+    }
+
+    /* See cfifoi_read_size() in cfifo.c. */
+    size_type read_size(size_type num_items) noexcept
+    {
+        const size_type read_pos = read_pos_.load(std::memory_order_relaxed);
+        size_type size = write_pos_cache_ - read_pos;
+
+        if (size > N || size < num_items)
+        {
+            write_pos_cache_ = write_pos_.load(std::memory_order_acquire);
+            size = write_pos_cache_ - read_pos;
+        }
+        return size;
+    }
+
+    storage_type buf_[N];
+    /* Consumer owned. */
+    alignas(line_align) std::atomic<size_type> read_pos_;
+    size_type write_pos_cache_;
+    /* Producer owned. */
+    alignas(line_align) std::atomic<size_type> write_pos_;
+    size_type read_pos_cache_;
+};
+
+} /* namespace cfifo */
+
+#endif /* _CFIFO_HPP_ */
@@ -0,0 +1,74 @@
+#ifndef _CFIFO_ATOMIC_H_
+#define _CFIFO_ATOMIC_H_
+
+/**
+ * @file cfifo_atomic.h
+ *
+ * Memory ordering primitives for the read/write position handshake.
+ *
+ * The GCC/clang __atomic builtins are used when available, they are accepted
+ * in C89 mode as well. Other compilers fall back to plain accesses of the
+ * volatile position fields, which gives no ordering guarantees between
+ * threads. CFIFO_HAS_ATOMICS tells which one is in use, the lock-free
+ * multi-producer/multi-consumer parts require the builtins.
+ *
+ */
+
+/*======= Public macro definitions ==========================================*/
+
+#if defined(__GNUC__) && defined(__ATOMIC_ACQUIRE)
+
+#define CFIFO_HAS_ATOMICS           1
+
+#define CFIFO_LOAD_RELAXED(x)       __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define CFIFO_LOAD_ACQUIRE(x)       __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define CFIFO_STORE_RELAXED(x, v)   __atomic_store_n(&(x), (v), __ATOMIC_RELAXED)
+#define CFIFO_STORE_RELEASE(x, v)   __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+
+/* Weak compare-and-swap, on failure *(p_expected) is updated to the current
+ * value. Ordering is relaxed, the callers publish data through other
+ * acquire/release pairs. */
+#define CFIFO_CAS_WEAK_RELAXED(x, p_expected, desired)                      \
+        __atomic_compare_exchange_n(&(x), (p_expected), (desired), 1,       \
+                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+
+/* Sequentially consistent accesses, for the store-then-load handshake
+ * between a sleeping thread and the thread that has to wake it. */
+#define CFIFO_LOAD_SEQ_CST(x)       __atomic_load_n(&(x), __ATOMIC_SEQ_CST)
+#define CFIFO_STORE_SEQ_CST(x, v)   __atomic_store_n(&(x), (v), __ATOMIC_SEQ_CST)
+#define CFIFO_FETCH_ADD(x, v)       __atomic_fetch_add(&(x), (v), __ATOMIC_SEQ_CST)
+#define CFIFO_EXCHANGE(x, v)        __atomic_exchange_n(&(x), (v), __ATOMIC_SEQ_CST)
+
+/* Weak compare-and-swap that also orders the caller's accesses: earlier
+ * ones complete before it (release), later ones start after it (acquire).
+ * For a position that both sides move, see CFIFO_FLAG_OVERWRITE. */
+#define CFIFO_CAS_WEAK_ACQ_REL(x, p_expected, desired)                      \
+        __atomic_compare_exchange_n(&(x), (p_expected), (desired), 1,       \
+                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+
+#else
+
+#define CFIFO_HAS_ATOMICS           0
+
+#define CFIFO_LOAD_RELAXED(x)       (x)
+#define CFIFO_LOAD_ACQUIRE(x)       (x)
+#define CFIFO_STORE_RELAXED(x, v)   ((x) = (v))
+#define CFIFO_STORE_RELEASE(x, v)   ((x) = (v))
+#define CFIFO_LOAD_SEQ_CST(x)       (x)
+#define CFIFO_STORE_SEQ_CST(x, v)   ((x) = (v))
+#define CFIFO_CAS_WEAK_ACQ_REL(x, p_expected, desired)                      \
+        (((x) == *(p_expected)) ? ((x) = (desired), 1) :                    \
+                                  (*(p_expected) = (x), 0))
+
+#endif
+
+/* Spin loop hint, lets the sibling hyper-thread run and saves power. */
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define CFIFO_CPU_RELAX()           __builtin_ia32_pause()
+#elif defined(__GNUC__) && (defined(__aarch64__) || defined(__arm__))
+#define CFIFO_CPU_RELAX()           __asm__ __volatile__("yield" ::: "memory")
+#else
+#define CFIFO_CPU_RELAX()
+#endif
+
+#endif /* _CFIFO_ATOMIC_H_ */
@@ -0,0 +1,380 @@
+/**
+ * @file cfifo_bcast.c
+ *
+ * Bounded broadcast fifo, see cfifo_bcast.h.
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+/* C-Library includes */
+#include <stddef.h> /* For offsetof */
+#include <string.h> /* For memcpy */
+
+/* Local includes */
+#include "cfifo_bcast.h"
+#include "cfifo_atomic.h"
+
+#if !CFIFO_HAS_ATOMICS
+#error "cfifo_bcast requires the __atomic builtins"
+#endif
+
+/*======= Local Macro Definitions ===========================================*/
+
+#define CFIFO_CAPACITY      (p_bcast->num_items_mask + 1)
+#define CFIFO_SLOT(pos)     ((pos) & p_bcast->num_items_mask)
+
+/*======= Type Definitions and declarations =================================*/
+
+#if defined(__GNUC__)
+/* Fails to compile if the cache line layout of cfifo_bcast.h is lost. */
+typedef char cfifo_bcast_layout_check
+    [(sizeof(struct cfifo_bcast_reader_s) % CFIFO_CACHE_LINE_SIZE == 0 &&
+      offsetof(struct cfifo_bcast_s, write_pos) % CFIFO_CACHE_LINE_SIZE == 0 &&
+      offsetof(struct cfifo_bcast_s, readers) % CFIFO_CACHE_LINE_SIZE == 0) ?
+     1 : -1];
+#endif
+
+/*======= Local function prototypes =========================================*/
+
+static size_t cfifoi_bcast_free(cfifo_bcast_t p_bcast, size_t num_items);
+static void cfifoi_bcast_accept(cfifo_bcast_t p_bcast);
+static size_t cfifoi_bcast_slowest(cfifo_bcast_t p_bcast);
+static size_t cfifoi_bcast_available(cfifo_bcast_t p_bcast,
+                                     cfifo_bcast_reader_t p_reader,
+                                     size_t num_items);
+
+/*======= Global function implementations ===================================*/
+
+cfifo_ret_t cfifo_bcast_init(cfifo_bcast_t p_bcast,
+                             uint8_t *p_buf,
+                             size_t num_items,
+                             size_t item_size,
+                             size_t buf_size)
+{
+    size_t i;
+
+    if (NULL == p_bcast || NULL == p_buf)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (!CFIFO_IS_POW_2(num_items) || 0 == item_size ||
+        buf_size / item_size != num_items)
+    {
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+    p_bcast->p_buf = p_buf;
+    p_bcast->num_items_mask = num_items - 1;
+    p_bcast->item_size = item_size;
+    p_bcast->attach_requests = 0;
+    p_bcast->write_pos = 0;
+    p_bcast->read_pos_cache = 0;
+    p_bcast->attach_seen = 0;
+    for (i = 0; i < CFIFO_BCAST_MAX_READERS; i++)
+    {
+        p_bcast->readers[i].read_pos = 0;
+        p_bcast->readers[i].write_pos_cache = 0;
+        p_bcast->readers[i].state = CFIFO_BCAST_FREE;
+    }
+
+    return CFIFO_SUCCESS;
+}
+
+cfifo_ret_t cfifo_bcast_attach(cfifo_bcast_t p_bcast,
+                               cfifo_bcast_reader_t *pp_reader)
+{
+    unsigned int expected;
+    size_t i;
+
+    if (NULL == p_bcast || NULL == pp_reader)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    for (i = 0; i < CFIFO_BCAST_MAX_READERS; i++)
+    {
+        expected = CFIFO_BCAST_FREE;
+        while (!CFIFO_CAS_WEAK_ACQ_REL(p_bcast->readers[i].state,
+                                       &expected,
+                                       CFIFO_BCAST_REQUESTED))
+        {
+            if (CFIFO_BCAST_FREE != expected)
+            {
+                break;
+            }
+        }
+
+        if (CFIFO_BCAST_FREE == expected)
+        {
+            /* The producer sets the cursor, see cfifoi_bcast_accept(). */
+            (void) CFIFO_FETCH_ADD(p_bcast->attach_requests, 1);
+            *pp_reader = &p_bcast->readers[i];
+            return CFIFO_SUCCESS;
+        }
+    }
+
+    return CFIFO_ERR_FULL;
+}
+
+cfifo_ret_t cfifo_bcast_detach(cfifo_bcast_t p_bcast,
+                               cfifo_bcast_reader_t p_reader)
+{
+    if (NULL == p_bcast || NULL == p_reader)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (CFIFO_BCAST_FREE == CFIFO_EXCHANGE(p_reader->state, CFIFO_BCAST_FREE))
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    return CFIFO_SUCCESS;
+}
+
+cfifo_ret_t cfifo_bcast_put(cfifo_bcast_t p_bcast,
+                            const void *p_item)
+{
+    size_t write_pos;
+
+    if (NULL == p_bcast || NULL == p_item)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (0 == cfifoi_bcast_free(p_bcast, 1))
+    {
+        return CFIFO_ERR_FULL;
+    }
+
+    write_pos = CFIFO_LOAD_RELAXED(p_bcast->write_pos);
+    memcpy(&p_bcast->p_buf[CFIFO_SLOT(write_pos) * p_bcast->item_size],
+           p_item,
+           p_bcast->item_size);
+    CFIFO_STORE_RELEASE(p_bcast->write_pos, write_pos + 1);
+
+    return CFIFO_SUCCESS;
+}
+
+cfifo_ret_t cfifo_bcast_write(cfifo_bcast_t p_bcast,
+                              const void *p_items,
+                              size_t *p_num_items)
+{
+    const uint8_t *p_src = (const uint8_t *) p_items;
+    size_t write_pos;
+    size_t num_items;
+    size_t first;
+    size_t free_items;
+
+    if (NULL == p_bcast || NULL == p_items || NULL == p_num_items)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    free_items = cfifoi_bcast_free(p_bcast, *p_num_items);
+    num_items = (*p_num_items < free_items) ? *p_num_items : free_items;
+
+    write_pos = CFIFO_LOAD_RELAXED(p_bcast->write_pos);
+    first = CFIFO_CAPACITY - CFIFO_SLOT(write_pos);
+    first = (num_items < first) ? num_items : first;
+    memcpy(&p_bcast->p_buf[CFIFO_SLOT(write_pos) * p_bcast->item_size],
+           p_src,
+           first * p_bcast->item_size);
+    memcpy(p_bcast->p_buf,
+           &p_src[first * p_bcast->item_size],
+           (num_items - first) * p_bcast->item_size);
+    CFIFO_STORE_RELEASE(p_bcast->write_pos, write_pos + num_items);
+
+    *p_num_items = num_items;
+
+    return CFIFO_SUCCESS;
+}
+
+cfifo_ret_t cfifo_bcast_get(cfifo_bcast_t p_bcast,
+                            cfifo_bcast_reader_t p_reader,
+                            void *p_item)
+{
+    size_t read_pos;
+
+    if (NULL == p_bcast || NULL == p_reader || NULL == p_item)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (0 == cfifoi_bcast_available(p_bcast, p_reader, 1))
+    {
+        return CFIFO_ERR_EMPTY;
+    }
+
+    read_pos = CFIFO_LOAD_RELAXED(p_reader->read_pos);
+    memcpy(p_item,
+           &p_bcast->p_buf[CFIFO_SLOT(read_pos) * p_bcast->item_size],
+           p_bcast->item_size);
+    CFIFO_STORE_RELEASE(p_reader->read_pos, read_pos + 1);
+
+    return CFIFO_SUCCESS;
+}
+
+cfifo_ret_t cfifo_bcast_read(cfifo_bcast_t p_bcast,
+                             cfifo_bcast_reader_t p_reader,
+                             void *p_items,
+                             size_t *p_num_items)
+{
+    uint8_t *p_dest = (uint8_t *) p_items;
+    size_t read_pos;
+    size_t num_items;
+    size_t first;
+    size_t available;
+
+    if (NULL == p_bcast || NULL == p_reader || NULL == p_items ||
+        NULL == p_num_items)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    available = cfifoi_bcast_available(p_bcast, p_reader, *p_num_items);
+    num_items = (*p_num_items < available) ? *p_num_items : available;
+
+    read_pos = CFIFO_LOAD_RELAXED(p_reader->read_pos);
+    first = CFIFO_CAPACITY - CFIFO_SLOT(read_pos);
+    first = (num_items < first) ? num_items : first;
+    memcpy(p_dest,
+           &p_bcast->p_buf[CFIFO_SLOT(read_pos) * p_bcast->item_size],
+           first * p_bcast->item_size);
+    memcpy(&p_dest[first * p_bcast->item_size],
+           p_bcast->p_buf,
+           (num_items - first) * p_bcast->item_size);
+    CFIFO_STORE_RELEASE(p_reader->read_pos, read_pos + num_items);
+
+    *p_num_items = num_items;
+
+    return CFIFO_SUCCESS;
+}
+
+size_t cfifo_bcast_size(cfifo_bcast_t p_bcast,
+                        cfifo_bcast_reader_t p_reader)
+{
+    if (NULL == p_bcast || NULL == p_reader)
+    {
+        return 0;
+    }
+
+    return cfifoi_bcast_available(p_bcast, p_reader, CFIFO_CAPACITY);
+}
+
+/*======= Local function implementations ====================================*/
+
+/*
+ * Producer side, free slots, looking at the readers again only if the
+ * cached slowest position leaves fewer than num_items.
+ */
+static size_t cfifoi_bcast_free(cfifo_bcast_t p_bcast, size_t num_items)
+{
+    size_t write_pos = CFIFO_LOAD_RELAXED(p_bcast->write_pos);
+    size_t requests = CFIFO_LOAD_ACQUIRE(p_bcast->attach_requests);
+    size_t free_items;
+
+    if (requests != p_bcast->attach_seen)
+    {
+        p_bcast->attach_seen = requests;
+        cfifoi_bcast_accept(p_bcast);
+    }
+
+    free_items = CFIFO_CAPACITY - (write_pos - p_bcast->read_pos_cache);
+    if (free_items < num_items)
+    {
+        p_bcast->read_pos_cache = cfifoi_bcast_slowest(p_bcast);
+        free_items = CFIFO_CAPACITY - (write_pos - p_bcast->read_pos_cache);
+    }
+
+    return free_items;
+}
+
+/*
+ * Producer side, start every requested reader at the write position. Only
+ * the producer moves a slot to CFIFO_BCAST_ATTACHED, so the cursor of an
+ * attached reader is never behind what the producer may overwrite. A
+ * reader that detached meanwhile makes the compare-and-swap fail.
+ */
+static void cfifoi_bcast_accept(cfifo_bcast_t p_bcast)
+{
+    size_t write_pos = CFIFO_LOAD_RELAXED(p_bcast->write_pos);
+    unsigned int expected;
+    size_t i;
+
+    for (i = 0; i < CFIFO_BCAST_MAX_READERS; i++)
+    {
+        if (CFIFO_BCAST_REQUESTED != CFIFO_LOAD_ACQUIRE(p_bcast->readers[i].state))
+        {
+            continue;
+        }
+
+        CFIFO_STORE_RELAXED(p_bcast->readers[i].read_pos, write_pos);
+        p_bcast->readers[i].write_pos_cache = write_pos;
+        expected = CFIFO_BCAST_REQUESTED;
+        while (!CFIFO_CAS_WEAK_ACQ_REL(p_bcast->readers[i].state,
+                                       &expected,
+                                       CFIFO_BCAST_ATTACHED) &&
+               CFIFO_BCAST_REQUESTED == expected)
+        {
+        }
+    }
+}
+
+/* Producer side, read position of the reader furthest behind. */
+static size_t cfifoi_bcast_slowest(cfifo_bcast_t p_bcast)
+{
+    size_t write_pos = CFIFO_LOAD_RELAXED(p_bcast->write_pos);
+    size_t slowest = write_pos;
+    size_t read_pos;
+    size_t i;
+
+    for (i = 0; i < CFIFO_BCAST_MAX_READERS; i++)
+    {
+        if (CFIFO_BCAST_ATTACHED != CFIFO_LOAD_ACQUIRE(p_bcast->readers[i].state))
+        {
+            continue;
+        }
+
+        read_pos = CFIFO_LOAD_ACQUIRE(p_bcast->readers[i].read_pos);
+        if (write_pos - read_pos > write_pos - slowest)
+        {
+            slowest = read_pos;
+        }
+    }
+
+    return slowest;
+}
+
+/*
+ * Reader side, items available to p_reader, loading write_pos again only
+ * if the cached one gives fewer than num_items.
+ */
+static size_t cfifoi_bcast_available(cfifo_bcast_t p_bcast,
+                                     cfifo_bcast_reader_t p_reader,
+                                     size_t num_items)
+{
+    size_t read_pos;
+
+    if (CFIFO_BCAST_ATTACHED != CFIFO_LOAD_ACQUIRE(p_reader->state))
+    {
+        return 0;
+    }
+
+    read_pos = CFIFO_LOAD_RELAXED(p_reader->read_pos);
+    if (p_reader->write_pos_cache - read_pos < num_items)
+    {
+        p_reader->write_pos_cache = CFIFO_LOAD_ACQUIRE(p_bcast->write_pos);
+    }
+
+    return p_reader->write_pos_cache - read_pos;
+}
@@ -0,0 +1,217 @@
+#ifndef _CFIFO_BCAST_H_
+#define _CFIFO_BCAST_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file cfifo_bcast.h
+ *
+ * Bounded broadcast fifo: one producer, several readers that each get every
+ * item.
+ *
+ * There is one buffer and one write position, and every reader has its own
+ * read position, a cursor. The producer only overwrites a slot once all
+ * attached readers are past it, so its free space is bounded by the slowest
+ * reader. Each item is copied in once however many readers there are.
+ *
+ * Readers attach and detach at any time from their own threads. A newly
+ * attached reader starts at the write position, the producer moves it
+ * there in its next cfifo_bcast_put()/cfifo_bcast_write(); until then the
+ * reader finds the fifo empty. Cursors of readers that are not attached do
+ * not hold the producer back.
+ *
+ * One producer thread, and one thread per attached reader.
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+/* C-Library includes */
+#include <stddef.h> /* for size_t */
+#include <stdint.h> /* for uint8_t */
+
+/* Local includes */
+#include "cfifo.h"
+
+/*======= Public macro definitions ==========================================*/
+
+/* Readers that can be attached at the same time. */
+#ifndef CFIFO_BCAST_MAX_READERS
+#define CFIFO_BCAST_MAX_READERS     8
+#endif
+
+/* States of a reader slot. */
+#define CFIFO_BCAST_FREE            0u
+/* Claimed by cfifo_bcast_attach(), not seen by the producer yet. */
+#define CFIFO_BCAST_REQUESTED       1u
+#define CFIFO_BCAST_ATTACHED        2u
+
+/*======= Type Definitions and declarations =================================*/
+
+typedef struct cfifo_bcast_s *cfifo_bcast_t;
+typedef struct cfifo_bcast_reader_s *cfifo_bcast_reader_t;
+
+/*
+ * The producer's fields and each reader start a cache line of their own,
+ * with or without CFIFO_SEPARATE_CACHE_LINES, so readers do not slow each
+ * other down.
+ */
+struct cfifo_bcast_reader_s {
+    /* Reader owned, write_pos_cache is the last write_pos it has seen. */
+    volatile size_t read_pos CFIFO_ALIGNED(CFIFO_CACHE_LINE_SIZE);
+    size_t          write_pos_cache;
+    /* CFIFO_BCAST_FREE, CFIFO_BCAST_REQUESTED or CFIFO_BCAST_ATTACHED. */
+    volatile unsigned int state;
+};
+
+struct cfifo_bcast_s {
+    uint8_t         *p_buf;
+    size_t          num_items_mask;
+    size_t          item_size;
+    /* Bumped by cfifo_bcast_attach(), checked by the producer. */
+    volatile size_t attach_requests;
+    /* Producer owned, read_pos_cache is the slowest read_pos it has seen. */
+    volatile size_t write_pos CFIFO_ALIGNED(CFIFO_CACHE_LINE_SIZE);
+    size_t          read_pos_cache;
+    size_t          attach_seen;
+    struct cfifo_bcast_reader_s readers[CFIFO_BCAST_MAX_READERS];
+};
+
+/*======= Public function declarations ======================================*/
+
+/**
+ * @brief Initialize a broadcast fifo without readers.
+ *
+ * @param   p_bcast
+ * @param   p_buf
+ * @param   num_items   Capacity, a power of 2.
+ * @param   item_size
+ * @param   buf_size    num_items * item_size
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_BAD_SIZE
+ *
+ */
+cfifo_ret_t cfifo_bcast_init(cfifo_bcast_t p_bcast,
+                             uint8_t *p_buf,
+                             size_t num_items,
+                             size_t item_size,
+                             size_t buf_size);
+
+/**
+ * @brief Attach a reader. From the reader's thread.
+ *
+ * The reader gets the items put after the producer noticed it, see the
+ * file description.
+ *
+ * @param   p_bcast
+ * @param   pp_reader   Out: the reader's cursor.
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_FULL if CFIFO_BCAST_MAX_READERS are attached
+ *
+ */
+cfifo_ret_t cfifo_bcast_attach(cfifo_bcast_t p_bcast,
+                               cfifo_bcast_reader_t *pp_reader);
+
+/**
+ * @brief Detach a reader. From the reader's thread.
+ *
+ * The items it has not read no longer hold the producer back.
+ *
+ * @param   p_bcast
+ * @param   p_reader
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_INVALID_STATE if not attached
+ *
+ */
+cfifo_ret_t cfifo_bcast_detach(cfifo_bcast_t p_bcast,
+                               cfifo_bcast_reader_t p_reader);
+
+/**
+ * @brief Put one item for all attached readers. Producer thread only.
+ *
+ * @param   p_bcast
+ * @param   p_item
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_FULL if the slowest reader is a full capacity behind
+ *
+ */
+cfifo_ret_t cfifo_bcast_put(cfifo_bcast_t p_bcast,
+                            const void *p_item);
+
+/**
+ * @brief Put up to *p_num_items items. Producer thread only.
+ *
+ * @param   p_bcast
+ * @param   p_items
+ * @param   p_num_items In: items to put. Out: items put.
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ *
+ */
+cfifo_ret_t cfifo_bcast_write(cfifo_bcast_t p_bcast,
+                              const void *p_items,
+                              size_t *p_num_items);
+
+/**
+ * @brief Get the reader's next item. From the reader's thread.
+ *
+ * @param   p_bcast
+ * @param   p_reader
+ * @param   p_item
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_EMPTY, also while the attach is not seen yet
+ *
+ */
+cfifo_ret_t cfifo_bcast_get(cfifo_bcast_t p_bcast,
+                            cfifo_bcast_reader_t p_reader,
+                            void *p_item);
+
+/**
+ * @brief Get up to *p_num_items of the reader's next items. From the
+ * reader's thread.
+ *
+ * @param   p_bcast
+ * @param   p_reader
+ * @param   p_items
+ * @param   p_num_items In: room in p_items. Out: items read.
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ *
+ */
+cfifo_ret_t cfifo_bcast_read(cfifo_bcast_t p_bcast,
+                             cfifo_bcast_reader_t p_reader,
+                             void *p_items,
+                             size_t *p_num_items);
+
+/**
+ * @brief Number of items the reader has not read yet. From the reader's
+ * thread.
+ *
+ * @param   p_bcast
+ * @param   p_reader
+ *
+ * @return  The items, 0 if not attached or a pointer is NULL.
+ *
+ */
+size_t cfifo_bcast_size(cfifo_bcast_t p_bcast,
+                        cfifo_bcast_reader_t p_reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CFIFO_BCAST_H_ */
@@ -0,0 +1,179 @@
+/**
+ * @file cfifo_index.c
+ *
+ * Counting hash table, see cfifo_index.h.
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+/* C-Library includes */
+#include <string.h> /* For memcmp */
+
+/* Local includes */
+#include "cfifo_index.h"
+
+/*======= Local Macro Definitions ===========================================*/
+
+#define CFIFO_ENTRY(i)      (&p_index->p_table[(i) * p_index->entry_size])
+#define CFIFO_HASH(p_entry) (((size_t *) (void *) (p_entry))[0])
+#define CFIFO_COUNT(p_entry) (((size_t *) (void *) (p_entry))[1])
+#define CFIFO_KEY(p_entry)  (&(p_entry)[2 * sizeof(size_t)])
+
+/*======= Local function prototypes =========================================*/
+
+static size_t cfifoi_hash(const uint8_t *p_key, size_t key_size);
+static size_t cfifoi_find(cfifo_index_t p_index,
+                          const void *p_key,
+                          size_t hash);
+
+/*======= Global function implementations ===================================*/
+
+cfifo_ret_t cfifo_index_init(cfifo_index_t p_index,
+                             uint8_t *p_table,
+                             size_t num_entries,
+                             size_t key_size,
+                             size_t table_size)
+{
+    if (NULL == p_index || NULL == p_table)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (!CFIFO_IS_POW_2(num_entries))
+    {
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+    if (!((key_size > 0) &&
+          (table_size / CFIFO_INDEX_ENTRY_SIZE(key_size) == num_entries) &&
+          (((uintptr_t) p_table % sizeof(size_t)) == 0)))
+    {
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+    p_index->p_table = p_table;
+    p_index->num_entries_mask = num_entries - 1;
+    p_index->key_size = key_size;
+    p_index->entry_size = CFIFO_INDEX_ENTRY_SIZE(key_size);
+    p_index->pos = 0;
+    cfifo_index_clear(p_index);
+
+    return CFIFO_SUCCESS;
+}
+
+void cfifo_index_add(cfifo_index_t p_index,
+                     const void *p_key)
+{
+    size_t hash = cfifoi_hash((const uint8_t *) p_key, p_index->key_size);
+    uint8_t *p_entry = CFIFO_ENTRY(cfifoi_find(p_index, p_key, hash));
+
+    if (0 == CFIFO_COUNT(p_entry))
+    {
+        CFIFO_HASH(p_entry) = hash;
+        memcpy(CFIFO_KEY(p_entry), p_key, p_index->key_size);
+    }
+    CFIFO_COUNT(p_entry)++;
+    p_index->num_keys++;
+}
+
+/*
+ * When the last copy goes the entry is emptied and the following entries of
+ * the probe run are shifted back into the hole, unless they would move in
+ * front of their home slot (Knuth's algorithm R).
+ */
+void cfifo_index_remove(cfifo_index_t p_index,
+                        const void *p_key)
+{
+    size_t hash = cfifoi_hash((const uint8_t *) p_key, p_index->key_size);
+    size_t hole = cfifoi_find(p_index, p_key, hash);
+    size_t i = hole;
+    size_t home;
+    uint8_t *p_entry = CFIFO_ENTRY(hole);
+
+    if (0 == CFIFO_COUNT(p_entry))
+    {
+        /* Not counted. */
+        return;
+    }
+
+    p_index->num_keys--;
+    if (--CFIFO_COUNT(p_entry) > 0)
+    {
+        return;
+    }
+
+    for (;;)
+    {
+        i = (i + 1) & p_index->num_entries_mask;
+        p_entry = CFIFO_ENTRY(i);
+        if (0 == CFIFO_COUNT(p_entry))
+        {
+            break;
+        }
+
+        /* Entry i may move to the hole if its home is not in (hole, i]. */
+        home = CFIFO_HASH(p_entry) & p_index->num_entries_mask;
+        if (((i - home) & p_index->num_entries_mask) >=
+            ((i - hole) & p_index->num_entries_mask))
+        {
+            memcpy(CFIFO_ENTRY(hole), p_entry, p_index->entry_size);
+            CFIFO_COUNT(p_entry) = 0;
+            hole = i;
+        }
+    }
+}
+
+size_t cfifo_index_count(cfifo_index_t p_index,
+                         const void *p_key)
+{
+    size_t hash = cfifoi_hash((const uint8_t *) p_key, p_index->key_size);
+
+    return CFIFO_COUNT(CFIFO_ENTRY(cfifoi_find(p_index, p_key, hash)));
+}
+
+void cfifo_index_clear(cfifo_index_t p_index)
+{
+    size_t i;
+
+    for (i = 0; i <= p_index->num_entries_mask; i++)
+    {
+        CFIFO_COUNT(CFIFO_ENTRY(i)) = 0;
+    }
+    p_index->num_keys = 0;
+}
+
+/*======= Local function implementations ====================================*/
+
+/* FNV-1a, folded to size_t. */
+static size_t cfifoi_hash(const uint8_t *p_key, size_t key_size)
+{
+    uint32_t hash = 2166136261u;
+    size_t i;
+
+    for (i = 0; i < key_size; i++)
+    {
+        hash ^= p_key[i];
+        hash *= 16777619u;
+    }
+    return (size_t) hash;
+}
+
+/* Entry holding p_key, or the empty entry ending its probe run. */
+static size_t cfifoi_find(cfifo_index_t p_index,
+                          const void *p_key,
+                          size_t hash)
+{
+    size_t i = hash & p_index->num_entries_mask;
+    uint8_t *p_entry = CFIFO_ENTRY(i);
+
+    while (0 != CFIFO_COUNT(p_entry) &&
+           !(CFIFO_HASH(p_entry) == hash &&
+             memcmp(CFIFO_KEY(p_entry), p_key, p_index->key_size) == 0))
+    {
+        i = (i + 1) & p_index->num_entries_mask;
+        p_entry = CFIFO_ENTRY(i);
+    }
+    return i;
+}
@@ -0,0 +1,115 @@
+#ifndef _CFIFO_INDEX_H_
+#define _CFIFO_INDEX_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file cfifo_index.h
+ *
+ * Counting hash table keyed on item bytes, used as a companion index of a
+ * cfifo_t to answer cfifo_contains() in O(1), see cfifo_attach_index().
+ *
+ * Open addressing with linear probing. Every entry holds the hash, the
+ * number of stored copies and the key. Entries whose count drops to 0 are
+ * removed with backward shifting, so the table never fills up with
+ * tombstones. The table memory is provided by the caller, like the fifo
+ * buffer.
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+/* C-Library includes */
+#include <stddef.h> /* for size_t */
+#include <stdint.h> /* for uint8_t */
+
+/* Local includes */
+#include "cfifo.h"
+
+/*======= Public macro definitions ==========================================*/
+
+/* Bytes used by one entry: hash, count and the key padded to a size_t. */
+#define CFIFO_INDEX_ENTRY_SIZE(key_size)                                \
+        (2 * sizeof(size_t) +                                           \
+         ((((key_size) + sizeof(size_t) - 1) / sizeof(size_t)) *        \
+          sizeof(size_t)))
+
+/*
+ * Number of size_t words for a table with num_entries entries, or -1
+ * (compile error) if num_entries is not a power of 2.
+ */
+#define CFIFO_INDEX_BUF_WORDS(key_size, num_entries)                    \
+        (CFIFO_IS_POW_2(num_entries) ?                                  \
+         (int) ((num_entries) * CFIFO_INDEX_ENTRY_SIZE(key_size)        \
+                / sizeof(size_t)) : -1)
+
+/*======= Type Definitions and declarations =================================*/
+
+struct cfifo_index_s {
+    uint8_t *p_table;
+    size_t  num_entries_mask;
+    size_t  key_size;
+    size_t  entry_size;
+    /* Number of keys counted, including copies. */
+    size_t  num_keys;
+    /* Oldest fifo position still counted, see cfifo_attach_index(). */
+    size_t  pos;
+};
+
+/*======= Public function declarations ======================================*/
+
+/**
+ * @brief Initialize an empty index.
+ *
+ * @param   p_index
+ * @param   p_table     Buffer of table_size bytes, aligned for size_t.
+ * @param   num_entries Power of 2, more than the number of keys that will
+ *                      be counted at the same time. Twice that keeps the
+ *                      probe sequences short.
+ * @param   key_size
+ * @param   table_size  num_entries * CFIFO_INDEX_ENTRY_SIZE(key_size)
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_BAD_SIZE
+ *
+ */
+cfifo_ret_t cfifo_index_init(cfifo_index_t p_index,
+                             uint8_t *p_table,
+                             size_t num_entries,
+                             size_t key_size,
+                             size_t table_size);
+
+/**
+ * @brief Count one more copy of p_key.
+ *
+ * The table must have a free entry, i.e. fewer than num_entries distinct
+ * keys may be counted.
+ */
+void cfifo_index_add(cfifo_index_t p_index,
+                     const void *p_key);
+
+/**
+ * @brief Count one copy of p_key less, p_key must have been added.
+ */
+void cfifo_index_remove(cfifo_index_t p_index,
+                        const void *p_key);
+
+/**
+ * @brief Number of counted copies of p_key.
+ */
+size_t cfifo_index_count(cfifo_index_t p_index,
+                         const void *p_key);
+
+/**
+ * @brief Remove all keys.
+ */
+void cfifo_index_clear(cfifo_index_t p_index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CFIFO_INDEX_H_ */
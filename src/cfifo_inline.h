@@ -0,0 +1,298 @@
+#ifndef _CFIFO_INLINE_H_
+#define _CFIFO_INLINE_H_
+
+/**
+ * @file cfifo_inline.h
+ *
+ * Inline versions of cfifo_put(), cfifo_get(), cfifo_write() and
+ * cfifo_read() for tight loops, where the call and the checks cost more
+ * than copying a small item.
+ *
+ * They behave exactly like the out-of-line functions and can be mixed with
+ * them on the same fifo. Only plain fifos take the inline path: a fifo with
+ * any CFIFO_FLAG_* set (blocking waits, notifier, index, overwrite mode,
+ * mirrored or relative buffer), or a build with CFIFO_STATS, goes through
+ * the out-of-line function after one test of the flags.
+ *
+ * Either call the *_inline functions directly, or define CFIFO_INLINE for a
+ * translation unit before cfifo.h is included: cfifo_put() and friends
+ * then map to them. With CFIFO_UNCHECKED and NDEBUG the NULL pointer and
+ * state checks are left out as well, see CFIFO_CHECKED.
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+/* C-Library includes */
+#include <stddef.h> /* for size_t */
+#include <string.h> /* for memcpy */
+
+/* Local includes */
+#include "cfifo.h"
+#include "cfifo_atomic.h"
+#include "cfifo_pos.h"
+
+/*======= Public macro definitions ==========================================*/
+
+/* Fifos the inline path cannot serve. */
+#if defined(CFIFO_STATS)
+#define CFIFO_INLINE_SLOW(p_cfifo)  1
+#else
+#define CFIFO_INLINE_SLOW(p_cfifo)  (0 != (p_cfifo)->flags)
+#endif
+
+/*======= Public function declarations ======================================*/
+
+/* Producer side free space, see cfifoi_write_available() in cfifo.c. */
+CFIFO_STATIC_INLINE size_t cfifo_inline_free(cfifo_t p_cfifo,
+                                             size_t num_items)
+{
+    size_t capacity = p_cfifo->num_items_mask + 1;
+    size_t write_pos = CFIFO_LOAD_RELAXED(p_cfifo->write_pos);
+    size_t used = cfifo_pos_diff(p_cfifo, write_pos, p_cfifo->read_pos_cache);
+
+    if (used > capacity || capacity - used < num_items)
+    {
+        p_cfifo->read_pos_cache = CFIFO_LOAD_ACQUIRE(p_cfifo->read_pos);
+        used = cfifo_pos_diff(p_cfifo, write_pos, p_cfifo->read_pos_cache);
+    }
+    return capacity - used;
+}
+
+/* Consumer side stored items, see cfifoi_read_size() in cfifo.c. */
+CFIFO_STATIC_INLINE size_t cfifo_inline_stored(cfifo_t p_cfifo,
+                                               size_t num_items)
+{
+    size_t read_pos = CFIFO_LOAD_RELAXED(p_cfifo->read_pos);
+    size_t size = cfifo_pos_diff(p_cfifo, p_cfifo->write_pos_cache, read_pos);
+
+    if (size > p_cfifo->num_items_mask + 1 || size < num_items)
+    {
+        p_cfifo->write_pos_cache = CFIFO_LOAD_ACQUIRE(p_cfifo->write_pos);
+        size = cfifo_pos_diff(p_cfifo, p_cfifo->write_pos_cache, read_pos);
+    }
+    return size;
+}
+
+/**
+ * @brief Inline cfifo_put().
+ *
+ * @param   p_cfifo
+ * @param   p_item
+ *
+ * @return  As cfifo_put().
+ *
+ */
+CFIFO_STATIC_INLINE cfifo_ret_t cfifo_put_inline(cfifo_t p_cfifo,
+                                                 const void *p_item)
+{
+    size_t write_pos;
+
+#if CFIFO_CHECKED
+    if (NULL == p_cfifo || NULL == p_item)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (NULL == p_cfifo->p_buf)
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+#endif
+
+    if (CFIFO_INLINE_SLOW(p_cfifo))
+    {
+        return (cfifo_put)(p_cfifo, p_item);
+    }
+
+    if (0 == cfifo_inline_free(p_cfifo, 1))
+    {
+        return CFIFO_ERR_FULL;
+    }
+
+    write_pos = CFIFO_LOAD_RELAXED(p_cfifo->write_pos);
+    memcpy(&p_cfifo->p_buf[cfifo_pos_slot(p_cfifo, write_pos) * p_cfifo->item_size],
+           p_item,
+           p_cfifo->item_size);
+    CFIFO_STORE_RELEASE(p_cfifo->write_pos, cfifo_pos_add(p_cfifo, write_pos, 1));
+
+    return CFIFO_SUCCESS;
+}
+
+/**
+ * @brief Inline cfifo_get().
+ *
+ * @param   p_cfifo
+ * @param   p_item
+ *
+ * @return  As cfifo_get().
+ *
+ */
+CFIFO_STATIC_INLINE cfifo_ret_t cfifo_get_inline(cfifo_t p_cfifo,
+                                                 void *p_item)
+{
+    size_t read_pos;
+
+#if CFIFO_CHECKED
+    if (NULL == p_cfifo || NULL == p_item)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (NULL == p_cfifo->p_buf)
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+#endif
+
+    if (CFIFO_INLINE_SLOW(p_cfifo))
+    {
+        return (cfifo_get)(p_cfifo, p_item);
+    }
+
+    if (0 == cfifo_inline_stored(p_cfifo, 1))
+    {
+        return CFIFO_ERR_EMPTY;
+    }
+
+    read_pos = CFIFO_LOAD_RELAXED(p_cfifo->read_pos);
+    memcpy(p_item,
+           &p_cfifo->p_buf[cfifo_pos_slot(p_cfifo, read_pos) * p_cfifo->item_size],
+           p_cfifo->item_size);
+    CFIFO_STORE_RELEASE(p_cfifo->read_pos, cfifo_pos_add(p_cfifo, read_pos, 1));
+
+    return CFIFO_SUCCESS;
+}
+
+/**
+ * @brief Inline cfifo_write().
+ *
+ * @param   p_cfifo
+ * @param   p_items
+ * @param   p_num_items
+ *
+ * @return  As cfifo_write().
+ *
+ */
+CFIFO_STATIC_INLINE cfifo_ret_t cfifo_write_inline(cfifo_t p_cfifo,
+                                                   const void *p_items,
+                                                   size_t *p_num_items)
+{
+    const uint8_t *p_src = (const uint8_t *) p_items;
+    size_t capacity;
+    size_t write_pos;
+    size_t slot;
+    size_t num_items;
+    size_t first;
+
+#if CFIFO_CHECKED
+    if (NULL == p_cfifo || NULL == p_items || NULL == p_num_items)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (NULL == p_cfifo->p_buf)
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+#endif
+
+    if (CFIFO_INLINE_SLOW(p_cfifo))
+    {
+        return (cfifo_write)(p_cfifo, p_items, p_num_items);
+    }
+
+    capacity = p_cfifo->num_items_mask + 1;
+    num_items = cfifo_inline_free(p_cfifo, *p_num_items);
+    num_items = (*p_num_items < num_items) ? *p_num_items : num_items;
+
+    write_pos = CFIFO_LOAD_RELAXED(p_cfifo->write_pos);
+    slot = cfifo_pos_slot(p_cfifo, write_pos);
+    first = (num_items < capacity - slot) ? num_items : capacity - slot;
+    memcpy(&p_cfifo->p_buf[slot * p_cfifo->item_size],
+           p_src,
+           first * p_cfifo->item_size);
+    memcpy(p_cfifo->p_buf,
+           &p_src[first * p_cfifo->item_size],
+           (num_items - first) * p_cfifo->item_size);
+    CFIFO_STORE_RELEASE(p_cfifo->write_pos,
+                        cfifo_pos_add(p_cfifo, write_pos, num_items));
+
+    *p_num_items = num_items;
+
+    return CFIFO_SUCCESS;
+}
+
+/**
+ * @brief Inline cfifo_read().
+ *
+ * @param   p_cfifo
+ * @param   p_items
+ * @param   p_num_items
+ *
+ * @return  As cfifo_read().
+ *
+ */
+CFIFO_STATIC_INLINE cfifo_ret_t cfifo_read_inline(cfifo_t p_cfifo,
+                                                  void *p_items,
+                                                  size_t *p_num_items)
+{
+    uint8_t *p_dest = (uint8_t *) p_items;
+    size_t capacity;
+    size_t read_pos;
+    size_t slot;
+    size_t num_items;
+    size_t first;
+
+#if CFIFO_CHECKED
+    if (NULL == p_cfifo || NULL == p_items || NULL == p_num_items)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (NULL == p_cfifo->p_buf)
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+#endif
+
+    if (CFIFO_INLINE_SLOW(p_cfifo))
+    {
+        return (cfifo_read)(p_cfifo, p_items, p_num_items);
+    }
+
+    capacity = p_cfifo->num_items_mask + 1;
+    num_items = cfifo_inline_stored(p_cfifo, *p_num_items);
+    num_items = (*p_num_items < num_items) ? *p_num_items : num_items;
+
+    read_pos = CFIFO_LOAD_RELAXED(p_cfifo->read_pos);
+    slot = cfifo_pos_slot(p_cfifo, read_pos);
+    first = (num_items < capacity - slot) ? num_items : capacity - slot;
+    memcpy(p_dest,
+           &p_cfifo->p_buf[slot * p_cfifo->item_size],
+           first * p_cfifo->item_size);
+    memcpy(&p_dest[first * p_cfifo->item_size],
+           p_cfifo->p_buf,
+           (num_items - first) * p_cfifo->item_size);
+    CFIFO_STORE_RELEASE(p_cfifo->read_pos,
+                        cfifo_pos_add(p_cfifo, read_pos, num_items));
+
+    *p_num_items = num_items;
+
+    return CFIFO_SUCCESS;
+}
+
+#if defined(CFIFO_INLINE)
+#define cfifo_put(p_cfifo, p_item)      cfifo_put_inline((p_cfifo), (p_item))
+#define cfifo_get(p_cfifo, p_item)      cfifo_get_inline((p_cfifo), (p_item))
+#define cfifo_write(p_cfifo, p_items, p_num_items)                          \
+        cfifo_write_inline((p_cfifo), (p_items), (p_num_items))
+#define cfifo_read(p_cfifo, p_items, p_num_items)                           \
+        cfifo_read_inline((p_cfifo), (p_items), (p_num_items))
+#endif
+
+#endif /* _CFIFO_INLINE_H_ */
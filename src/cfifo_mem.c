@@ -0,0 +1,549 @@
+/**
+ * @file cfifo_mem.c
+ *
+ * Optional buffer allocators, see cfifo_mem.h.
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+#if defined(__linux__)
+#define _GNU_SOURCE
+#endif
+
+/* C-Library includes */
+#include <stdio.h>  /* For fopen */
+#include <stdlib.h> /* For malloc */
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/* Local includes */
+#include "cfifo_mem.h"
+
+/*======= Local Macro Definitions ===========================================*/
+
+#if defined(__linux__) && defined(SYS_memfd_create)
+#define CFIFO_HAS_MIRROR    1
+#else
+#define CFIFO_HAS_MIRROR    0
+#endif
+
+#if defined(__linux__)
+#define CFIFO_HAS_MMAP      1
+#else
+#define CFIFO_HAS_MMAP      0
+#endif
+
+#if defined(__linux__) && defined(SYS_mbind)
+#define CFIFO_HAS_MBIND     1
+#else
+#define CFIFO_HAS_MBIND     0
+#endif
+
+/* From linux/mempolicy.h, not installed everywhere. */
+#define CFIFO_MPOL_BIND         2
+#define CFIFO_MPOL_MF_MOVE      (1 << 1)
+
+#define CFIFO_ULONG_BITS        (8 * sizeof(unsigned long))
+
+/* Mapping size of a provisioned buffer, 0 if buf_size is too large. */
+#define CFIFO_MEM_MAP_SIZE(buf_size)                                        \
+        (((buf_size) > SIZE_MAX - CFIFO_MEM_HUGE_PAGE_SIZE) ? 0 :           \
+         (((buf_size) + CFIFO_MEM_HUGE_PAGE_SIZE - 1) &                     \
+          ~(CFIFO_MEM_HUGE_PAGE_SIZE - 1)))
+
+/*======= Local function prototypes =========================================*/
+
+#if CFIFO_HAS_MMAP
+static uint8_t *cfifoi_mem_map(size_t map_size, unsigned int *p_flags);
+#endif
+static void cfifoi_mem_prefault(uint8_t *p_buf, size_t buf_size);
+
+/*======= Global function implementations ===================================*/
+
+cfifo_ret_t cfifo_mirror_alloc(uint8_t **pp_buf,
+                               size_t buf_size)
+{
+#if CFIFO_HAS_MIRROR
+    long page_size = sysconf(_SC_PAGESIZE);
+    uint8_t *p_base;
+    int fd;
+
+    if (NULL == pp_buf)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (page_size <= 0 || 0 == buf_size || (buf_size % (size_t) page_size) != 0)
+    {
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+    /* memfd_create() through syscall(), the wrapper needs glibc 2.27. */
+    fd = (int) syscall(SYS_memfd_create, "cfifo", 0);
+    if (fd < 0)
+    {
+        return CFIFO_ERR_NO_MEM;
+    }
+
+    if (ftruncate(fd, (off_t) buf_size) != 0)
+    {
+        close(fd);
+        return CFIFO_ERR_NO_MEM;
+    }
+
+    /* Reserve address space for both halves, then map the file twice. */
+    p_base = (uint8_t *) mmap(NULL, 2 * buf_size, PROT_NONE,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == (void *) p_base)
+    {
+        close(fd);
+        return CFIFO_ERR_NO_MEM;
+    }
+
+    if (MAP_FAILED == mmap(p_base, buf_size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_FIXED, fd, 0) ||
+        MAP_FAILED == mmap(p_base + buf_size, buf_size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_FIXED, fd, 0))
+    {
+        munmap(p_base, 2 * buf_size);
+        close(fd);
+        return CFIFO_ERR_NO_MEM;
+    }
+
+    /* The mappings keep the memory alive. */
+    close(fd);
+
+    *pp_buf = p_base;
+
+    return CFIFO_SUCCESS;
+#else
+    if (NULL == pp_buf)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    (void) buf_size;
+
+    return CFIFO_ERR_BAD_SIZE;
+#endif
+}
+
+void cfifo_mirror_free(uint8_t *p_buf,
+                       size_t buf_size)
+{
+#if CFIFO_HAS_MIRROR
+    if (NULL != p_buf)
+    {
+        munmap(p_buf, 2 * buf_size);
+    }
+#else
+    (void) p_buf;
+    (void) buf_size;
+#endif
+}
+
+cfifo_ret_t cfifo_mirror_create(cfifo_t p_cfifo,
+                                size_t num_items,
+                                size_t item_size)
+{
+    size_t buf_size = num_items * item_size;
+    uint8_t *p_buf;
+    cfifo_ret_t ret;
+
+    if (NULL == p_cfifo)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (!CFIFO_IS_CAPACITY(num_items) || 0 == item_size ||
+        buf_size / item_size != num_items)
+    {
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+    ret = cfifo_mirror_alloc(&p_buf, buf_size);
+    if (CFIFO_SUCCESS == ret)
+    {
+        return cfifo_init_mirrored(p_cfifo, p_buf, num_items, item_size, buf_size);
+    }
+
+    if (CFIFO_ERR_BAD_SIZE != ret)
+    {
+        return ret;
+    }
+
+    /* Page size constraints not met, fall back to a flat buffer. */
+    p_buf = (uint8_t *) malloc(buf_size);
+    if (NULL == p_buf)
+    {
+        return CFIFO_ERR_NO_MEM;
+    }
+
+    return cfifo_init(p_cfifo, p_buf, num_items, item_size, buf_size);
+}
+
+cfifo_ret_t cfifo_mirror_destroy(cfifo_t p_cfifo)
+{
+    if (NULL == p_cfifo)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (NULL == p_cfifo->p_buf)
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    if (p_cfifo->flags & CFIFO_FLAG_MIRRORED)
+    {
+        cfifo_mirror_free(p_cfifo->p_buf,
+                          (p_cfifo->num_items_mask + 1) * p_cfifo->item_size);
+    }
+    else
+    {
+        free(p_cfifo->p_buf);
+    }
+
+    p_cfifo->p_buf = NULL;
+
+    return CFIFO_SUCCESS;
+}
+
+cfifo_ret_t cfifo_mem_alloc(uint8_t **pp_buf,
+                            size_t buf_size,
+                            unsigned int *p_flags)
+{
+    size_t map_size = CFIFO_MEM_MAP_SIZE(buf_size);
+    uint8_t *p_buf;
+
+    if (NULL == pp_buf || NULL == p_flags)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (0 == buf_size || 0 == map_size)
+    {
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+#if CFIFO_HAS_MMAP
+    p_buf = cfifoi_mem_map(map_size, p_flags);
+    if (NULL == p_buf)
+    {
+        return CFIFO_ERR_NO_MEM;
+    }
+
+    /* Before anything is faulted in, so nothing has to move. */
+    if (CFIFO_MEM_GET_NODE(*p_flags) >= 0 &&
+        CFIFO_SUCCESS != cfifo_mem_bind(p_buf, map_size, CFIFO_MEM_GET_NODE(*p_flags)))
+    {
+        *p_flags &= ~CFIFO_MEM_NODE_MASK;
+    }
+
+    /* mlock() faults every page in as well. */
+    if ((*p_flags & CFIFO_MEM_LOCK) && 0 != mlock(p_buf, map_size))
+    {
+        *p_flags &= ~CFIFO_MEM_LOCK;
+    }
+#else
+    p_buf = (uint8_t *) malloc(buf_size);
+    if (NULL == p_buf)
+    {
+        return CFIFO_ERR_NO_MEM;
+    }
+    *p_flags &= CFIFO_MEM_PREFAULT;
+    map_size = buf_size;
+#endif
+
+    if (*p_flags & CFIFO_MEM_PREFAULT)
+    {
+        cfifoi_mem_prefault(p_buf, map_size);
+    }
+
+    *pp_buf = p_buf;
+
+    return CFIFO_SUCCESS;
+}
+
+void cfifo_mem_free(uint8_t *p_buf,
+                    size_t buf_size)
+{
+    if (NULL == p_buf)
+    {
+        return;
+    }
+
+#if CFIFO_HAS_MMAP
+    munmap(p_buf, CFIFO_MEM_MAP_SIZE(buf_size));
+#else
+    (void) buf_size;
+    free(p_buf);
+#endif
+}
+
+cfifo_ret_t cfifo_mem_create(cfifo_t p_cfifo,
+                             size_t num_items,
+                             size_t item_size,
+                             unsigned int *p_flags)
+{
+    size_t buf_size = num_items * item_size;
+    uint8_t *p_buf;
+    cfifo_ret_t ret;
+
+    if (NULL == p_cfifo || NULL == p_flags)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (!CFIFO_IS_CAPACITY(num_items) || 0 == item_size ||
+        buf_size / item_size != num_items)
+    {
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+    ret = cfifo_mem_alloc(&p_buf, buf_size, p_flags);
+    if (CFIFO_SUCCESS != ret)
+    {
+        return ret;
+    }
+
+    return cfifo_init(p_cfifo, p_buf, num_items, item_size, buf_size);
+}
+
+cfifo_ret_t cfifo_mem_destroy(cfifo_t p_cfifo)
+{
+    if (NULL == p_cfifo)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (NULL == p_cfifo->p_buf)
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    cfifo_mem_free(p_cfifo->p_buf,
+                   (p_cfifo->num_items_mask + 1) * p_cfifo->item_size);
+    p_cfifo->p_buf = NULL;
+
+    return CFIFO_SUCCESS;
+}
+
+cfifo_ret_t cfifo_mem_bind(const void *p_mem,
+                           size_t size,
+                           int node)
+{
+#if CFIFO_HAS_MBIND
+    unsigned long mask[CFIFO_MEM_MAX_NODES / (8 * sizeof(unsigned long)) + 1];
+    long page_size = sysconf(_SC_PAGESIZE);
+    uintptr_t start;
+    uintptr_t end;
+    size_t i;
+#endif
+
+    if (NULL == p_mem)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (0 == size || node < 0 || node >= CFIFO_MEM_MAX_NODES ||
+        (uintptr_t) p_mem > UINTPTR_MAX - size)
+    {
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+#if CFIFO_HAS_MBIND
+    if (page_size <= 0)
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    start = (uintptr_t) p_mem & ~((uintptr_t) page_size - 1);
+    end = ((uintptr_t) p_mem + size - 1) | ((uintptr_t) page_size - 1);
+
+    for (i = 0; i < sizeof(mask) / sizeof(mask[0]); i++)
+    {
+        mask[i] = 0;
+    }
+    mask[(size_t) node / CFIFO_ULONG_BITS] = 1ul << ((size_t) node % CFIFO_ULONG_BITS);
+
+    /* The kernel takes maxnode as one more than the bits to look at. */
+    if (0 != syscall(SYS_mbind, (void *) start, (unsigned long) (end - start + 1),
+                     CFIFO_MPOL_BIND, mask,
+                     (unsigned long) (sizeof(mask) * 8 + 1), CFIFO_MPOL_MF_MOVE))
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    return CFIFO_SUCCESS;
+#else
+    return CFIFO_ERR_INVALID_STATE;
+#endif
+}
+
+int cfifo_mem_num_nodes(void)
+{
+    char line[256];
+    int num_nodes = 1;
+    FILE *p_file;
+    size_t i;
+    int node;
+
+    /* A list like "0" or "0-1,4-7", the last number is the highest. */
+    p_file = fopen("/sys/devices/system/node/online", "r");
+    if (NULL == p_file)
+    {
+        return num_nodes;
+    }
+
+    if (NULL != fgets(line, sizeof(line), p_file))
+    {
+        node = -1;
+        for (i = 0; '\0' != line[i]; i++)
+        {
+            if (line[i] >= '0' && line[i] <= '9')
+            {
+                node = ((node < 0) ? 0 : node * 10) + (line[i] - '0');
+            }
+            else if (node >= 0)
+            {
+                if (node >= num_nodes)
+                {
+                    num_nodes = node + 1;
+                }
+                node = -1;
+            }
+        }
+        if (node >= num_nodes)
+        {
+            num_nodes = node + 1;
+        }
+    }
+    fclose(p_file);
+
+    return num_nodes;
+}
+
+int cfifo_mem_cpu_node(int cpu)
+{
+#if defined(__linux__)
+    /* The cpu directory links to its node as nodeN. */
+    char path[64];
+    int num_nodes = cfifo_mem_num_nodes();
+    int node;
+
+    if (cpu < 0)
+    {
+        return -1;
+    }
+
+    for (node = 0; node < num_nodes; node++)
+    {
+        sprintf(path, "/sys/devices/system/cpu/cpu%d/node%d", cpu, node);
+        if (0 == access(path, F_OK))
+        {
+            return node;
+        }
+    }
+#else
+    (void) cpu;
+#endif
+
+    return -1;
+}
+
+/*======= Local function implementations ====================================*/
+
+#if CFIFO_HAS_MMAP
+/*
+ * Explicit huge pages if asked for and available, otherwise normal pages
+ * aligned to the huge page size so that transparent huge pages can back
+ * all of it. Clears the options that did not take effect.
+ */
+static uint8_t *cfifoi_mem_map(size_t map_size, unsigned int *p_flags)
+{
+    uint8_t *p_map;
+    size_t head;
+
+#if defined(MAP_HUGETLB)
+    if (*p_flags & CFIFO_MEM_HUGETLB)
+    {
+        p_map = (uint8_t *) mmap(NULL, map_size, PROT_READ | PROT_WRITE,
+                                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (MAP_FAILED != (void *) p_map)
+        {
+            *p_flags &= ~CFIFO_MEM_THP;
+            return p_map;
+        }
+    }
+#endif
+    *p_flags &= ~CFIFO_MEM_HUGETLB;
+
+    /* Over-map by one huge page, then cut off the unaligned ends. */
+    if (map_size > SIZE_MAX - CFIFO_MEM_HUGE_PAGE_SIZE)
+    {
+        return NULL;
+    }
+    p_map = (uint8_t *) mmap(NULL, map_size + CFIFO_MEM_HUGE_PAGE_SIZE,
+                             PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == (void *) p_map)
+    {
+        return NULL;
+    }
+    head = (CFIFO_MEM_HUGE_PAGE_SIZE -
+            ((uintptr_t) p_map & (CFIFO_MEM_HUGE_PAGE_SIZE - 1))) &
+           (CFIFO_MEM_HUGE_PAGE_SIZE - 1);
+    if (head > 0)
+    {
+        munmap(p_map, head);
+    }
+    munmap(p_map + head + map_size, CFIFO_MEM_HUGE_PAGE_SIZE - head);
+    p_map += head;
+
+#if defined(MADV_HUGEPAGE)
+    if ((*p_flags & CFIFO_MEM_THP) && 0 != madvise(p_map, map_size, MADV_HUGEPAGE))
+    {
+        *p_flags &= ~CFIFO_MEM_THP;
+    }
+#else
+    *p_flags &= ~CFIFO_MEM_THP;
+#endif
+
+    return p_map;
+}
+#endif
+
+/* One write per small page makes the kernel back all of them now. */
+static void cfifoi_mem_prefault(uint8_t *p_buf, size_t buf_size)
+{
+    volatile uint8_t *p_touch = p_buf;
+    size_t step = 4096;
+    size_t i;
+
+#if CFIFO_HAS_MMAP
+    if (sysconf(_SC_PAGESIZE) > 0)
+    {
+        step = (size_t) sysconf(_SC_PAGESIZE);
+    }
+#endif
+
+    for (i = 0; i < buf_size; i += step)
+    {
+        p_touch[i] = 0;
+    }
+}
+
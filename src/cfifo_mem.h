@@ -0,0 +1,248 @@
+#ifndef _CFIFO_MEM_H_
+#define _CFIFO_MEM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file cfifo_mem.h
+ *
+ * Optional buffer allocators for cfifo_t.
+ *
+ * The rest of the library never allocates memory, these helpers are for
+ * buffers that need more than a plain array.
+ *
+ * Mirrored buffers map the same pages twice back-to-back, so any range of
+ * up to the buffer size starting inside the first mapping is contiguous in
+ * memory. Only available on Linux (memfd_create), and only for buffer sizes
+ * that are a multiple of the page size.
+ *
+ * Provisioned buffers, cfifo_mem_alloc(), are for large fifos that must not
+ * take TLB misses or first touch page faults while traffic is flowing: huge
+ * pages, locked in memory and faulted in up front. Every step is optional
+ * and falls back quietly to what the system allows, the caller learns what
+ * it got from the returned flags.
+ *
+ * On multi-socket machines the buffer can be bound to a NUMA node as well,
+ * with mbind() and the /sys topology, no libnuma needed. Pages are the unit
+ * of placement: a struct cfifo_s is far smaller than a page, so its
+ * producer and consumer lines always share one node, see cfifo_mem_bind().
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+/* C-Library includes */
+#include <stddef.h> /* for size_t */
+#include <stdint.h> /* for uint8_t */
+
+/* Local includes */
+#include "cfifo.h"
+
+/*======= Public macro definitions ==========================================*/
+
+/* Options of cfifo_mem_alloc(). */
+/* Explicit huge pages, mmap(MAP_HUGETLB), from the preallocated pool. */
+#define CFIFO_MEM_HUGETLB       0x01u
+/* Transparent huge pages, madvise(MADV_HUGEPAGE), if MAP_HUGETLB is not used. */
+#define CFIFO_MEM_THP           0x02u
+/* mlock() the buffer, subject to RLIMIT_MEMLOCK. */
+#define CFIFO_MEM_LOCK          0x04u
+/* Write to every page now instead of on first use. */
+#define CFIFO_MEM_PREFAULT      0x08u
+
+/* Bind to NUMA node n, 0 to CFIFO_MEM_MAX_NODES - 1. */
+#define CFIFO_MEM_NODE(n)       ((((unsigned int) (n)) + 1u) << 16)
+#define CFIFO_MEM_NODE_MASK     0xffff0000u
+/* Node requested or bound in a set of options, -1 for none. */
+#define CFIFO_MEM_GET_NODE(flags)   ((int) ((flags) >> 16) - 1)
+
+/* Nodes cfifo_mem_bind() can address. */
+#ifndef CFIFO_MEM_MAX_NODES
+#define CFIFO_MEM_MAX_NODES     1024
+#endif
+
+/* Provisioned buffers are mapped in multiples of this, and aligned to it. */
+#ifndef CFIFO_MEM_HUGE_PAGE_SIZE
+#define CFIFO_MEM_HUGE_PAGE_SIZE    ((size_t) 2 * 1024 * 1024)
+#endif
+
+/*======= Public function declarations ======================================*/
+
+/**
+ * @brief Allocate a mirrored buffer.
+ *
+ * On success *pp_buf points to 2 * buf_size bytes of address space where
+ * the second half maps the same memory as the first half.
+ *
+ * @param   pp_buf
+ * @param   buf_size    Multiple of the page size.
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_BAD_SIZE if buf_size is not a multiple of the page size
+ *          or mirroring is not supported on this platform
+ * @return  CFIFO_ERR_NO_MEM
+ *
+ */
+cfifo_ret_t cfifo_mirror_alloc(uint8_t **pp_buf,
+                               size_t buf_size);
+
+/**
+ * @brief Free a buffer from cfifo_mirror_alloc().
+ *
+ * @param   p_buf
+ * @param   buf_size    Same size as passed to cfifo_mirror_alloc().
+ *
+ */
+void cfifo_mirror_free(uint8_t *p_buf,
+                       size_t buf_size);
+
+/**
+ * @brief Allocate a buffer and initialize a fifo on it, mirrored if possible.
+ *
+ * Uses cfifo_mirror_alloc() and cfifo_init_mirrored() when num_items *
+ * item_size meets the page size constraints, and falls back to a normal
+ * malloc()'ed buffer and cfifo_init() otherwise. CFIFO_FLAG_MIRRORED in
+ * p_cfifo->flags tells which one was used. Free with cfifo_mirror_destroy().
+ *
+ * @param   p_cfifo
+ * @param   num_items
+ * @param   item_size
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_BAD_SIZE
+ * @return  CFIFO_ERR_NO_MEM
+ *
+ */
+cfifo_ret_t cfifo_mirror_create(cfifo_t p_cfifo,
+                                size_t num_items,
+                                size_t item_size);
+
+/**
+ * @brief Free the buffer of a fifo from cfifo_mirror_create().
+ *
+ * @param   p_cfifo
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_INVALID_STATE
+ *
+ */
+cfifo_ret_t cfifo_mirror_destroy(cfifo_t p_cfifo);
+
+/**
+ * @brief Allocate a buffer with huge pages, locked and pre-faulted on request.
+ *
+ * CFIFO_MEM_HUGETLB is tried first, then a normal mapping aligned to
+ * CFIFO_MEM_HUGE_PAGE_SIZE with CFIFO_MEM_THP. Options the system refuses
+ * are left out of *p_flags, only running out of memory is an error. With
+ * CFIFO_MEM_NODE(n) the pages are bound to node n before they are locked or
+ * faulted in; if that fails the node is cleared from *p_flags. Without
+ * mmap() the buffer comes from malloc() and only CFIFO_MEM_PREFAULT is
+ * honoured.
+ *
+ * @param   pp_buf
+ * @param   buf_size
+ * @param   p_flags     In: CFIFO_MEM_* options. Out: the ones in effect.
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_BAD_SIZE if buf_size is 0 or too large
+ * @return  CFIFO_ERR_NO_MEM
+ *
+ */
+cfifo_ret_t cfifo_mem_alloc(uint8_t **pp_buf,
+                            size_t buf_size,
+                            unsigned int *p_flags);
+
+/**
+ * @brief Free a buffer from cfifo_mem_alloc().
+ *
+ * @param   p_buf
+ * @param   buf_size    Same size as passed to cfifo_mem_alloc().
+ *
+ */
+void cfifo_mem_free(uint8_t *p_buf,
+                    size_t buf_size);
+
+/**
+ * @brief Allocate a buffer with cfifo_mem_alloc() and initialize a fifo on it.
+ *
+ * Free with cfifo_mem_destroy().
+ *
+ * @param   p_cfifo
+ * @param   num_items
+ * @param   item_size
+ * @param   p_flags     In: CFIFO_MEM_* options. Out: the ones in effect.
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_BAD_SIZE
+ * @return  CFIFO_ERR_NO_MEM
+ *
+ */
+cfifo_ret_t cfifo_mem_create(cfifo_t p_cfifo,
+                             size_t num_items,
+                             size_t item_size,
+                             unsigned int *p_flags);
+
+/**
+ * @brief Free the buffer of a fifo from cfifo_mem_create().
+ *
+ * @param   p_cfifo
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_INVALID_STATE
+ *
+ */
+cfifo_ret_t cfifo_mem_destroy(cfifo_t p_cfifo);
+
+/**
+ * @brief Bind memory to a NUMA node.
+ *
+ * Applies to the whole pages covering [p_mem, p_mem + size), whatever else
+ * they hold moves along. Pages already faulted in are migrated. To place a
+ * fifo header on its own, give it its own page.
+ *
+ * @param   p_mem
+ * @param   size
+ * @param   node        0 to CFIFO_MEM_MAX_NODES - 1.
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_BAD_SIZE if size is 0 or node is out of range
+ * @return  CFIFO_ERR_INVALID_STATE if the system refused, e.g. no NUMA
+ *          support or the node is offline
+ *
+ */
+cfifo_ret_t cfifo_mem_bind(const void *p_mem,
+                           size_t size,
+                           int node);
+
+/**
+ * @brief Number of NUMA nodes, from /sys/devices/system/node/online.
+ *
+ * @return  Highest online node + 1, 1 if unknown.
+ *
+ */
+int cfifo_mem_num_nodes(void);
+
+/**
+ * @brief NUMA node of a cpu, from /sys/devices/system/cpu.
+ *
+ * @param   cpu
+ *
+ * @return  The node, -1 if unknown.
+ *
+ */
+int cfifo_mem_cpu_node(int cpu);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CFIFO_MEM_H_ */
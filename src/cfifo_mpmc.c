@@ -0,0 +1,190 @@
+/**
+ * @file cfifo_mpmc.c
+ *
+ * Bounded lock-free multi-producer/multi-consumer fifo, see cfifo_mpmc.h.
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+/* C-Library includes */
+#include <string.h> /* For memcpy */
+
+/* Local includes */
+#include "cfifo_mpmc.h"
+#include "cfifo_atomic.h"
+
+#if !CFIFO_HAS_ATOMICS
+#error "cfifo_mpmc requires the __atomic builtins"
+#endif
+
+/*======= Local Macro Definitions ===========================================*/
+
+#define CFIFO_CAPACITY      (p_cfifo->num_items_mask + 1)
+#define CFIFO_LAP(pos)      ((pos) & ~p_cfifo->num_items_mask)
+#define CFIFO_SLOT(pos)     \
+        (&p_cfifo->p_buf[((pos) & p_cfifo->num_items_mask) * p_cfifo->slot_size])
+#define CFIFO_SEQ(p_slot)   (*(size_t *) (void *) (p_slot))
+#define CFIFO_ITEM(p_slot)  (&(p_slot)[sizeof(size_t)])
+
+/*======= Global function implementations ===================================*/
+
+cfifo_ret_t cfifo_mpmc_init(cfifo_mpmc_t p_cfifo,
+                            uint8_t *p_buf,
+                            size_t num_items,
+                            size_t item_size,
+                            size_t buf_size)
+{
+    if (NULL == p_cfifo || NULL == p_buf)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    /* A capacity of 1 would make a full and an empty slot look the same. */
+    if (!CFIFO_IS_POW_2(num_items) || num_items < 2)
+    {
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+    if (!((item_size > 0) &&
+          (buf_size / CFIFO_MPMC_SLOT_SIZE(item_size) == num_items) &&
+          (((uintptr_t) p_buf % sizeof(size_t)) == 0)))
+    {
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+    /* Zero sequence words mark every slot free for the first lap. */
+    memset(p_buf, 0, num_items * CFIFO_MPMC_SLOT_SIZE(item_size));
+
+    p_cfifo->p_buf = p_buf;
+    p_cfifo->num_items_mask = num_items - 1;
+    p_cfifo->item_size = item_size;
+    p_cfifo->slot_size = CFIFO_MPMC_SLOT_SIZE(item_size);
+    p_cfifo->write_pos = 0;
+    p_cfifo->read_pos = 0;
+
+    return CFIFO_SUCCESS;
+}
+
+/*
+ * A slot at position pos is free for the producer claiming pos when its
+ * sequence word equals CFIFO_LAP(pos). The producer publishes the item by
+ * setting it to CFIFO_LAP(pos) + 1, and the consumer hands it back by
+ * setting it to the lap of the next round, CFIFO_LAP(pos) + capacity.
+ */
+cfifo_ret_t cfifo_mpmc_put(cfifo_mpmc_t p_cfifo,
+                           const void * const p_item)
+{
+    size_t pos;
+    uint8_t *p_slot;
+    ptrdiff_t diff;
+
+    if (NULL == p_cfifo || NULL == p_item)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (NULL == p_cfifo->p_buf)
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    pos = CFIFO_LOAD_RELAXED(p_cfifo->write_pos);
+    for (;;)
+    {
+        p_slot = CFIFO_SLOT(pos);
+        diff = (ptrdiff_t) (CFIFO_LOAD_ACQUIRE(CFIFO_SEQ(p_slot)) -
+                            CFIFO_LAP(pos));
+        if (0 == diff)
+        {
+            if (CFIFO_CAS_WEAK_RELAXED(p_cfifo->write_pos, &pos, pos + 1))
+            {
+                break;
+            }
+            /* Lost the race, pos has been updated by the CAS. */
+        }
+        else if (diff < 0)
+        {
+            /* Slot still holds the item from the previous lap. */
+            return CFIFO_ERR_FULL;
+        }
+        else
+        {
+            /* Another producer already claimed pos. */
+            pos = CFIFO_LOAD_RELAXED(p_cfifo->write_pos);
+        }
+    }
+
+    memcpy(CFIFO_ITEM(p_slot), p_item, p_cfifo->item_size);
+    CFIFO_STORE_RELEASE(CFIFO_SEQ(p_slot), CFIFO_LAP(pos) + 1);
+
+    return CFIFO_SUCCESS;
+}
+
+cfifo_ret_t cfifo_mpmc_get(cfifo_mpmc_t p_cfifo,
+                           void *p_item)
+{
+    size_t pos;
+    uint8_t *p_slot;
+    ptrdiff_t diff;
+
+    if (NULL == p_cfifo || NULL == p_item)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (NULL == p_cfifo->p_buf)
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    pos = CFIFO_LOAD_RELAXED(p_cfifo->read_pos);
+    for (;;)
+    {
+        p_slot = CFIFO_SLOT(pos);
+        diff = (ptrdiff_t) (CFIFO_LOAD_ACQUIRE(CFIFO_SEQ(p_slot)) -
+                            (CFIFO_LAP(pos) + 1));
+        if (0 == diff)
+        {
+            if (CFIFO_CAS_WEAK_RELAXED(p_cfifo->read_pos, &pos, pos + 1))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            /* Slot not published yet. */
+            return CFIFO_ERR_EMPTY;
+        }
+        else
+        {
+            /* Another consumer already claimed pos. */
+            pos = CFIFO_LOAD_RELAXED(p_cfifo->read_pos);
+        }
+    }
+
+    memcpy(p_item, CFIFO_ITEM(p_slot), p_cfifo->item_size);
+    CFIFO_STORE_RELEASE(CFIFO_SEQ(p_slot), CFIFO_LAP(pos) + CFIFO_CAPACITY);
+
+    return CFIFO_SUCCESS;
+}
+
+size_t cfifo_mpmc_size(cfifo_mpmc_t p_cfifo)
+{
+    size_t read_pos;
+    size_t size;
+
+    if (NULL == p_cfifo || NULL == p_cfifo->p_buf)
+    {
+        return 0;
+    }
+
+    read_pos = CFIFO_LOAD_ACQUIRE(p_cfifo->read_pos);
+    size = CFIFO_LOAD_ACQUIRE(p_cfifo->write_pos) - read_pos;
+
+    /* Producers may have claimed more slots after read_pos was loaded. */
+    return (size > CFIFO_CAPACITY) ? CFIFO_CAPACITY : size;
+}
@@ -0,0 +1,166 @@
+#ifndef _CFIFO_MPMC_H_
+#define _CFIFO_MPMC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file cfifo_mpmc.h
+ *
+ * Bounded lock-free multi-producer/multi-consumer fifo.
+ *
+ * Same power of 2 ring and item_size model as cfifo_t. Every slot carries a
+ * sequence word next to the item (D. Vyukov's bounded MPMC queue). Producers
+ * and consumers claim positions with a compare-and-swap on their own
+ * position, which live on separate cache lines, and hand slots over to the
+ * other side through the slot's sequence word. Producers and consumers
+ * therefore only touch the same cache lines when the fifo is close to full
+ * or empty.
+ *
+ * The sequence word holds the lap (position with the index bits cleared) of
+ * the slot's current state, which makes an all zero buffer a valid empty
+ * fifo, so the CFIFO_MPMC_CREATE macros need no run time initialization.
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+/* C-Library includes */
+#include <stddef.h> /* for size_t */
+#include <stdint.h> /* for uint8_t */
+
+/* Local includes */
+#include "cfifo.h"
+
+/*======= Public macro definitions ==========================================*/
+
+/*
+ * Bytes used by one slot, the sequence word followed by the item padded to
+ * a multiple of the sequence word size.
+ */
+#define CFIFO_MPMC_SLOT_SIZE(item_size)                                 \
+        (sizeof(size_t) +                                               \
+         ((((item_size) + sizeof(size_t) - 1) / sizeof(size_t)) *       \
+          sizeof(size_t)))
+
+/*
+ * Number of size_t words needed for the buffer, or -1 (compile error) if the
+ * capacity is not a power of 2 of at least 2.
+ */
+#define CFIFO_MPMC_BUF_WORDS(item_size, capacity)                       \
+        (((capacity) > 1 && CFIFO_IS_POW_2(capacity)) ?                 \
+         (int) ((capacity) * CFIFO_MPMC_SLOT_SIZE(item_size)            \
+                / sizeof(size_t)) : -1)
+
+#define CFIFO_MPMC_STRUCT_DEF(type, capacity, buf)                      \
+    {                                                                   \
+        (uint8_t *) buf,                                                \
+        ((capacity) - 1),                                               \
+        sizeof(type),                                                   \
+        CFIFO_MPMC_SLOT_SIZE(sizeof(type)),                             \
+        0,                                                              \
+        0                                                               \
+    }
+
+#define CFIFO_MPMC_CREATE(p_cfifo, type, capacity)                      \
+    size_t                                                              \
+            p_cfifo##cfifo_buf##buf##__LINE__                           \
+            [CFIFO_MPMC_BUF_WORDS(sizeof(type), (capacity))]            \
+            CFIFO_ALIGNED(CFIFO_CACHE_LINE_SIZE) = {0};                 \
+    struct cfifo_mpmc_s p_cfifo##data##__LINE__ =                       \
+        CFIFO_MPMC_STRUCT_DEF(type, capacity,                           \
+                              p_cfifo##cfifo_buf##buf##__LINE__);       \
+    cfifo_mpmc_t p_cfifo = &p_cfifo##data##__LINE__
+
+#define CFIFO_MPMC_CREATE_STATIC(p_cfifo, type, capacity)               \
+    static size_t                                                       \
+            p_cfifo##cfifo_buf##buf##__LINE__                           \
+            [CFIFO_MPMC_BUF_WORDS(sizeof(type), (capacity))]            \
+            CFIFO_ALIGNED(CFIFO_CACHE_LINE_SIZE);                       \
+    static struct cfifo_mpmc_s p_cfifo##data##__LINE__ =                \
+        CFIFO_MPMC_STRUCT_DEF(type, capacity,                           \
+                              p_cfifo##cfifo_buf##buf##__LINE__);       \
+    static cfifo_mpmc_t p_cfifo = &p_cfifo##data##__LINE__
+
+/*======= Type Definitions and declarations =================================*/
+
+typedef struct cfifo_mpmc_s *cfifo_mpmc_t;
+
+struct cfifo_mpmc_s {
+    uint8_t         *p_buf;
+    size_t          num_items_mask;
+    size_t          item_size;
+    size_t          slot_size;
+    /* Claimed by producers. */
+    volatile size_t write_pos CFIFO_ALIGNED(CFIFO_CACHE_LINE_SIZE);
+    /* Claimed by consumers. */
+    volatile size_t read_pos CFIFO_ALIGNED(CFIFO_CACHE_LINE_SIZE);
+};
+
+/*======= Public function declarations ======================================*/
+
+/**
+ * @brief Initialize a multi-producer/multi-consumer fifo.
+ *
+ * @param   p_cfifo
+ * @param   p_buf       Buffer of buf_size bytes, aligned for size_t.
+ * @param   num_items   Capacity, a power of 2 of at least 2.
+ * @param   item_size
+ * @param   buf_size    num_items * CFIFO_MPMC_SLOT_SIZE(item_size)
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_BAD_SIZE
+ *
+ */
+cfifo_ret_t cfifo_mpmc_init(cfifo_mpmc_t p_cfifo,
+                            uint8_t *p_buf,
+                            size_t num_items,
+                            size_t item_size,
+                            size_t buf_size);
+
+/**
+ * @brief Put one item, may be called from any number of threads.
+ *
+ * @param   p_cfifo
+ * @param   p_item
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_FULL
+ *
+ */
+cfifo_ret_t cfifo_mpmc_put(cfifo_mpmc_t p_cfifo,
+                           const void * const p_item);
+
+/**
+ * @brief Get one item, may be called from any number of threads.
+ *
+ * @param   p_cfifo
+ * @param   p_item
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_EMPTY
+ *
+ */
+cfifo_ret_t cfifo_mpmc_get(cfifo_mpmc_t p_cfifo,
+                           void *p_item);
+
+/**
+ * @brief Number of claimed items.
+ *
+ * Only a snapshot while other threads are active, items that are claimed
+ * but not yet completely written or read are included.
+ *
+ * @param   p_cfifo
+ *
+ * @return  Number of items, 0 on NULL pointers.
+ *
+ */
+size_t cfifo_mpmc_size(cfifo_mpmc_t p_cfifo);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CFIFO_MPMC_H_ */
@@ -0,0 +1,210 @@
+/**
+ * @file cfifo_mpsc.c
+ *
+ * Bounded lock-free multi-producer/single-consumer fifo, see cfifo_mpsc.h.
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+/* C-Library includes */
+#include <string.h> /* For memcpy */
+
+/* Local includes */
+#include "cfifo_mpsc.h"
+#include "cfifo_atomic.h"
+
+#if !CFIFO_HAS_ATOMICS
+#error "cfifo_mpsc requires the __atomic builtins"
+#endif
+
+/*======= Local Macro Definitions ===========================================*/
+
+#define CFIFO_CAPACITY      (p_cfifo->num_items_mask + 1)
+#define CFIFO_LAP(pos)      ((pos) & ~p_cfifo->num_items_mask)
+#define CFIFO_SLOT(pos)     \
+        (&p_cfifo->p_buf[((pos) & p_cfifo->num_items_mask) * p_cfifo->slot_size])
+#define CFIFO_SEQ(p_slot)   (*(size_t *) (void *) (p_slot))
+#define CFIFO_ITEM(p_slot)  (&(p_slot)[sizeof(size_t)])
+
+/*======= Global function implementations ===================================*/
+
+cfifo_ret_t cfifo_mpsc_init(cfifo_mpsc_t p_cfifo,
+                            uint8_t *p_buf,
+                            size_t num_items,
+                            size_t item_size,
+                            size_t buf_size)
+{
+    if (NULL == p_cfifo || NULL == p_buf)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (!CFIFO_IS_POW_2(num_items))
+    {
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+    if (!((item_size > 0) &&
+          (buf_size / CFIFO_MPSC_SLOT_SIZE(item_size) == num_items) &&
+          (((uintptr_t) p_buf % sizeof(size_t)) == 0)))
+    {
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+    /* No slot is published for the first lap. */
+    memset(p_buf, 0, num_items * CFIFO_MPSC_SLOT_SIZE(item_size));
+
+    p_cfifo->p_buf = p_buf;
+    p_cfifo->num_items_mask = num_items - 1;
+    p_cfifo->item_size = item_size;
+    p_cfifo->slot_size = CFIFO_MPSC_SLOT_SIZE(item_size);
+    p_cfifo->write_pos = 0;
+    p_cfifo->read_pos_cache = 0;
+    p_cfifo->read_pos = 0;
+
+    return CFIFO_SUCCESS;
+}
+
+/*
+ * A position is claimed with a compare-and-swap rather than a plain
+ * fetch-and-add, since a fetch-and-add cannot be undone when the fifo turns
+ * out to be full. The item is published by storing CFIFO_LAP(pos) + 1 in
+ * the slot's sequence word.
+ *
+ * The producers share read_pos_cache on their own cache line and only load
+ * the consumer's read_pos when the cached one says the fifo is full. The
+ * release store and acquire load of the cache pass on what the consumer
+ * released to the producer that reuses the slot.
+ */
+cfifo_ret_t cfifo_mpsc_put(cfifo_mpsc_t p_cfifo,
+                           const void * const p_item)
+{
+    size_t pos;
+    size_t read_pos;
+    uint8_t *p_slot;
+
+    if (NULL == p_cfifo || NULL == p_item)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (NULL == p_cfifo->p_buf)
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    pos = CFIFO_LOAD_RELAXED(p_cfifo->write_pos);
+    for (;;)
+    {
+        if (pos - CFIFO_LOAD_ACQUIRE(p_cfifo->read_pos_cache) >= CFIFO_CAPACITY)
+        {
+            read_pos = CFIFO_LOAD_ACQUIRE(p_cfifo->read_pos);
+            CFIFO_STORE_RELEASE(p_cfifo->read_pos_cache, read_pos);
+            if (pos - read_pos == CFIFO_CAPACITY)
+            {
+                return CFIFO_ERR_FULL;
+            }
+            if (pos - read_pos > CFIFO_CAPACITY)
+            {
+                /* pos is stale, the consumer has read past it. */
+                pos = CFIFO_LOAD_RELAXED(p_cfifo->write_pos);
+                continue;
+            }
+        }
+        if (CFIFO_CAS_WEAK_RELAXED(p_cfifo->write_pos, &pos, pos + 1))
+        {
+            break;
+        }
+    }
+
+    p_slot = CFIFO_SLOT(pos);
+    memcpy(CFIFO_ITEM(p_slot), p_item, p_cfifo->item_size);
+    CFIFO_STORE_RELEASE(CFIFO_SEQ(p_slot), CFIFO_LAP(pos) + 1);
+
+    return CFIFO_SUCCESS;
+}
+
+cfifo_ret_t cfifo_mpsc_get(cfifo_mpsc_t p_cfifo,
+                           void *p_item)
+{
+    size_t num_items = 1;
+
+    if (NULL == p_cfifo || NULL == p_item)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (NULL == p_cfifo->p_buf)
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    (void) cfifo_mpsc_read(p_cfifo, p_item, &num_items);
+
+    return (num_items > 0) ? CFIFO_SUCCESS : CFIFO_ERR_EMPTY;
+}
+
+cfifo_ret_t cfifo_mpsc_read(cfifo_mpsc_t p_cfifo,
+                            void *p_items,
+                            size_t *p_num_items)
+{
+    uint8_t *p_dest = (uint8_t *) p_items;
+    uint8_t *p_slot;
+    size_t read_pos;
+    size_t i;
+
+    if (NULL == p_cfifo || NULL == p_items || NULL == p_num_items)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (NULL == p_cfifo->p_buf)
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    /* Only this thread writes read_pos. */
+    read_pos = p_cfifo->read_pos;
+
+    for (i = 0; i < (*p_num_items); i++)
+    {
+        p_slot = CFIFO_SLOT(read_pos + i);
+        if (CFIFO_LOAD_ACQUIRE(CFIFO_SEQ(p_slot)) != CFIFO_LAP(read_pos + i) + 1)
+        {
+            break;
+        }
+        memcpy(&p_dest[i * p_cfifo->item_size],
+               CFIFO_ITEM(p_slot),
+               p_cfifo->item_size);
+    }
+
+    if (i > 0)
+    {
+        CFIFO_STORE_RELEASE(p_cfifo->read_pos, read_pos + i);
+    }
+    (*p_num_items) = i;
+
+    return CFIFO_SUCCESS;
+}
+
+size_t cfifo_mpsc_size(cfifo_mpsc_t p_cfifo)
+{
+    size_t read_pos;
+    size_t size;
+
+    if (NULL == p_cfifo || NULL == p_cfifo->p_buf)
+    {
+        return 0;
+    }
+
+    read_pos = CFIFO_LOAD_ACQUIRE(p_cfifo->read_pos);
+    size = CFIFO_LOAD_ACQUIRE(p_cfifo->write_pos) - read_pos;
+
+    /* Producers may have claimed more slots after read_pos was loaded. */
+    return (size > CFIFO_CAPACITY) ? CFIFO_CAPACITY : size;
+}
@@ -0,0 +1,176 @@
+#ifndef _CFIFO_MPSC_H_
+#define _CFIFO_MPSC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file cfifo_mpsc.h
+ *
+ * Bounded lock-free multi-producer/single-consumer fifo, e.g. for many
+ * threads emitting log or telemetry records to one flushing thread.
+ *
+ * Slots have the same layout as the ones of cfifo_mpmc_t, a sequence word
+ * followed by the item. Producers claim a position and publish the item
+ * through the slot's sequence word. The single consumer does not need any
+ * read-modify-write operations: it copies out every published item in
+ * order and hands all of them back to the producers with one release store
+ * of read_pos per batch.
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+/* C-Library includes */
+#include <stddef.h> /* for size_t */
+#include <stdint.h> /* for uint8_t */
+
+/* Local includes */
+#include "cfifo.h"
+#include "cfifo_mpmc.h"
+
+/*======= Public macro definitions ==========================================*/
+
+#define CFIFO_MPSC_SLOT_SIZE(item_size)     CFIFO_MPMC_SLOT_SIZE(item_size)
+
+/*
+ * Number of size_t words needed for the buffer, or -1 (compile error) if the
+ * capacity is not a power of 2.
+ */
+#define CFIFO_MPSC_BUF_WORDS(item_size, capacity)                       \
+        (CFIFO_IS_POW_2(capacity) ?                                     \
+         (int) ((capacity) * CFIFO_MPSC_SLOT_SIZE(item_size)            \
+                / sizeof(size_t)) : -1)
+
+#define CFIFO_MPSC_STRUCT_DEF(type, capacity, buf)                      \
+    {                                                                   \
+        (uint8_t *) buf,                                                \
+        ((capacity) - 1),                                               \
+        sizeof(type),                                                   \
+        CFIFO_MPSC_SLOT_SIZE(sizeof(type)),                             \
+        0,                                                              \
+        0,                                                              \
+        0                                                               \
+    }
+
+#define CFIFO_MPSC_CREATE(p_cfifo, type, capacity)                      \
+    size_t                                                              \
+            p_cfifo##cfifo_buf##buf##__LINE__                           \
+            [CFIFO_MPSC_BUF_WORDS(sizeof(type), (capacity))]            \
+            CFIFO_ALIGNED(CFIFO_CACHE_LINE_SIZE) = {0};                 \
+    struct cfifo_mpsc_s p_cfifo##data##__LINE__ =                       \
+        CFIFO_MPSC_STRUCT_DEF(type, capacity,                           \
+                              p_cfifo##cfifo_buf##buf##__LINE__);       \
+    cfifo_mpsc_t p_cfifo = &p_cfifo##data##__LINE__
+
+#define CFIFO_MPSC_CREATE_STATIC(p_cfifo, type, capacity)               \
+    static size_t                                                       \
+            p_cfifo##cfifo_buf##buf##__LINE__                           \
+            [CFIFO_MPSC_BUF_WORDS(sizeof(type), (capacity))]            \
+            CFIFO_ALIGNED(CFIFO_CACHE_LINE_SIZE);                       \
+    static struct cfifo_mpsc_s p_cfifo##data##__LINE__ =                \
+        CFIFO_MPSC_STRUCT_DEF(type, capacity,                           \
+                              p_cfifo##cfifo_buf##buf##__LINE__);       \
+    static cfifo_mpsc_t p_cfifo = &p_cfifo##data##__LINE__
+
+/*======= Type Definitions and declarations =================================*/
+
+typedef struct cfifo_mpsc_s *cfifo_mpsc_t;
+
+struct cfifo_mpsc_s {
+    uint8_t         *p_buf;
+    size_t          num_items_mask;
+    size_t          item_size;
+    size_t          slot_size;
+    /* Claimed by producers. */
+    volatile size_t write_pos CFIFO_ALIGNED(CFIFO_CACHE_LINE_SIZE);
+    /* A read_pos some producer has seen, never ahead of read_pos. */
+    volatile size_t read_pos_cache;
+    /* Consumer owned. */
+    volatile size_t read_pos CFIFO_ALIGNED(CFIFO_CACHE_LINE_SIZE);
+};
+
+/*======= Public function declarations ======================================*/
+
+/**
+ * @brief Initialize a multi-producer/single-consumer fifo.
+ *
+ * @param   p_cfifo
+ * @param   p_buf       Buffer of buf_size bytes, aligned for size_t.
+ * @param   num_items   Capacity, a power of 2.
+ * @param   item_size
+ * @param   buf_size    num_items * CFIFO_MPSC_SLOT_SIZE(item_size)
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_BAD_SIZE
+ *
+ */
+cfifo_ret_t cfifo_mpsc_init(cfifo_mpsc_t p_cfifo,
+                            uint8_t *p_buf,
+                            size_t num_items,
+                            size_t item_size,
+                            size_t buf_size);
+
+/**
+ * @brief Put one item, may be called from any number of threads.
+ *
+ * @param   p_cfifo
+ * @param   p_item
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_FULL
+ *
+ */
+cfifo_ret_t cfifo_mpsc_put(cfifo_mpsc_t p_cfifo,
+                           const void * const p_item);
+
+/**
+ * @brief Get one item. Consumer thread only.
+ *
+ * @param   p_cfifo
+ * @param   p_item
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_EMPTY if the oldest claimed item is not published yet
+ *
+ */
+cfifo_ret_t cfifo_mpsc_get(cfifo_mpsc_t p_cfifo,
+                           void *p_item);
+
+/**
+ * @brief Drain all items published so far in one pass. Consumer thread only.
+ *
+ * Same semantics as cfifo_read(): copies up to *p_num_items items into
+ * p_items and sets *p_num_items to the number copied. Draining stops at the
+ * first position that a producer has claimed but not published yet, so the
+ * items are returned in claim order. read_pos is updated once for the whole
+ * batch.
+ *
+ * @param   p_cfifo
+ * @param   p_items
+ * @param   p_num_items
+ *
+ * @return  CFIFO_SUCCESS
+ *
+ */
+cfifo_ret_t cfifo_mpsc_read(cfifo_mpsc_t p_cfifo,
+                            void *p_items,
+                            size_t *p_num_items);
+
+/**
+ * @brief Number of claimed items, published or not.
+ *
+ * @param   p_cfifo
+ *
+ * @return  Number of items, 0 on NULL pointers.
+ *
+ */
+size_t cfifo_mpsc_size(cfifo_mpsc_t p_cfifo);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CFIFO_MPSC_H_ */
@@ -0,0 +1,239 @@
+/**
+ * @file cfifo_notify.c
+ *
+ * eventfd readiness notification, see cfifo_notify.h.
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+#if defined(__linux__)
+#define _GNU_SOURCE
+#endif
+
+/* C-Library includes */
+#include <stdint.h>
+
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+/* Local includes */
+#include "cfifo_notify.h"
+#include "cfifo_atomic.h"
+#include "cfifo_pos.h"
+
+#if !CFIFO_HAS_ATOMICS
+#error "cfifo_notify requires the __atomic builtins"
+#endif
+
+/*======= Local Macro Definitions ===========================================*/
+
+#define CFIFO_CAPACITY      (p_cfifo->num_items_mask + 1)
+#define CFIFO_ENABLED       (p_cfifo->flags & CFIFO_FLAG_NOTIFY)
+
+/*======= Local function prototypes =========================================*/
+
+static int cfifoi_eventfd(void);
+static void cfifoi_reset(int fd);
+
+/*======= Global function implementations ===================================*/
+
+cfifo_ret_t cfifo_enable_notify(cfifo_t p_cfifo,
+                                unsigned int events)
+{
+    if (NULL == p_cfifo)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (0 == events || (events & ~(CFIFO_NOTIFY_DATA | CFIFO_NOTIFY_SPACE)))
+    {
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+#if defined(__linux__)
+    if (NULL == p_cfifo->p_buf || CFIFO_ENABLED)
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    p_cfifo->data_fd = (events & CFIFO_NOTIFY_DATA) ? cfifoi_eventfd() : -1;
+    p_cfifo->space_fd = (events & CFIFO_NOTIFY_SPACE) ? cfifoi_eventfd() : -1;
+
+    p_cfifo->flags |= CFIFO_FLAG_NOTIFY;
+
+    if (((events & CFIFO_NOTIFY_DATA) && p_cfifo->data_fd < 0) ||
+        ((events & CFIFO_NOTIFY_SPACE) && p_cfifo->space_fd < 0))
+    {
+        (void) cfifo_disable_notify(p_cfifo);
+        return CFIFO_ERR_NO_MEM;
+    }
+
+    p_cfifo->data_armed = (p_cfifo->data_fd >= 0);
+    p_cfifo->space_armed = (p_cfifo->space_fd >= 0);
+
+    /* Conditions that already hold are reported right away. */
+    if (cfifo_size(p_cfifo) > 0)
+    {
+        cfifo_notify_signal(p_cfifo->data_fd, &p_cfifo->data_armed);
+    }
+    if (cfifo_available(p_cfifo) > 0)
+    {
+        cfifo_notify_signal(p_cfifo->space_fd, &p_cfifo->space_armed);
+    }
+
+    return CFIFO_SUCCESS;
+#else
+    return CFIFO_ERR_INVALID_STATE;
+#endif
+}
+
+cfifo_ret_t cfifo_disable_notify(cfifo_t p_cfifo)
+{
+    if (NULL == p_cfifo)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+#if defined(__linux__)
+    /* The fd fields are only valid while enabled, CFIFO_STRUCT_DEF leaves
+     * them 0. */
+    if (CFIFO_ENABLED && p_cfifo->data_fd >= 0)
+    {
+        (void) close(p_cfifo->data_fd);
+    }
+    if (CFIFO_ENABLED && p_cfifo->space_fd >= 0)
+    {
+        (void) close(p_cfifo->space_fd);
+    }
+#endif
+
+    p_cfifo->flags &= ~CFIFO_FLAG_NOTIFY;
+    p_cfifo->data_fd = -1;
+    p_cfifo->space_fd = -1;
+    p_cfifo->data_armed = 0;
+    p_cfifo->space_armed = 0;
+
+    return CFIFO_SUCCESS;
+}
+
+int cfifo_data_fd(cfifo_t p_cfifo)
+{
+    return (NULL != p_cfifo && CFIFO_ENABLED) ? p_cfifo->data_fd : -1;
+}
+
+int cfifo_space_fd(cfifo_t p_cfifo)
+{
+    return (NULL != p_cfifo && CFIFO_ENABLED) ? p_cfifo->space_fd : -1;
+}
+
+/*
+ * The consumer arms, then checks write_pos. The producer stores write_pos,
+ * then checks the arm. All of it is sequentially consistent, so either the
+ * consumer sees the new items or the producer sees the arm and signals.
+ */
+size_t cfifo_rearm_data(cfifo_t p_cfifo)
+{
+    size_t read_pos;
+    size_t size;
+
+    if (NULL == p_cfifo || NULL == p_cfifo->p_buf)
+    {
+        return 0;
+    }
+
+    if (!CFIFO_ENABLED || p_cfifo->data_fd < 0)
+    {
+        return cfifo_size(p_cfifo);
+    }
+
+    cfifoi_reset(p_cfifo->data_fd);
+    CFIFO_STORE_SEQ_CST(p_cfifo->data_armed, 1);
+
+    read_pos = CFIFO_LOAD_RELAXED(p_cfifo->read_pos);
+    size = cfifo_pos_diff(p_cfifo, CFIFO_LOAD_SEQ_CST(p_cfifo->write_pos), read_pos);
+    if (size > 0)
+    {
+        /* The caller keeps reading, no need for a signal. */
+        CFIFO_STORE_RELAXED(p_cfifo->data_armed, 0);
+    }
+
+    return size;
+}
+
+size_t cfifo_rearm_space(cfifo_t p_cfifo)
+{
+    size_t write_pos;
+    size_t available;
+
+    if (NULL == p_cfifo || NULL == p_cfifo->p_buf)
+    {
+        return 0;
+    }
+
+    if (!CFIFO_ENABLED || p_cfifo->space_fd < 0)
+    {
+        return cfifo_available(p_cfifo);
+    }
+
+    cfifoi_reset(p_cfifo->space_fd);
+    CFIFO_STORE_SEQ_CST(p_cfifo->space_armed, 1);
+
+    write_pos = CFIFO_LOAD_RELAXED(p_cfifo->write_pos);
+    available = CFIFO_CAPACITY -
+                cfifo_pos_diff(p_cfifo, write_pos, CFIFO_LOAD_SEQ_CST(p_cfifo->read_pos));
+    if (available > 0)
+    {
+        CFIFO_STORE_RELAXED(p_cfifo->space_armed, 0);
+    }
+
+    return available;
+}
+
+/*
+ * The plain load keeps the common case, nobody armed, free of atomic
+ * read-modify-writes. The exchange makes sure only one signal is sent per
+ * arm.
+ */
+void cfifo_notify_signal(int fd,
+                         volatile unsigned int *p_armed)
+{
+#if defined(__linux__)
+    uint64_t one = 1;
+
+    if (0 != CFIFO_LOAD_SEQ_CST(*p_armed) && 0 != CFIFO_EXCHANGE(*p_armed, 0))
+    {
+        (void) write(fd, &one, sizeof(one));
+    }
+#else
+    (void) fd;
+    (void) p_armed;
+#endif
+}
+
+/*======= Local function implementations ====================================*/
+
+static int cfifoi_eventfd(void)
+{
+#if defined(__linux__)
+    return eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#else
+    return -1;
+#endif
+}
+
+/* Clear a pending signal, the fd is non-blocking. */
+static void cfifoi_reset(int fd)
+{
+#if defined(__linux__)
+    uint64_t count;
+
+    (void) read(fd, &count, sizeof(count));
+#else
+    (void) fd;
+#endif
+}
@@ -0,0 +1,123 @@
+#ifndef _CFIFO_NOTIFY_H_
+#define _CFIFO_NOTIFY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file cfifo_notify.h
+ *
+ * eventfd readiness notification for cfifo_t, for event loops built on
+ * epoll/poll/select.
+ *
+ * The data fd becomes readable when items arrive in a fifo the consumer has
+ * seen empty, the space fd when slots are freed in a fifo the producer has
+ * seen full. Notification is edge triggered: each fd is signalled once and
+ * then stays quiet until its owner calls the matching rearm function, so a
+ * busy fifo costs no syscalls. The usual consumer loop is
+ *
+ *     epoll_wait() reports cfifo_data_fd()
+ *     do {
+ *         drain with cfifo_read()/cfifo_get()
+ *     } while (cfifo_rearm_data(p_cfifo) > 0);
+ *
+ * cfifo_rearm_data() resets the fd and arms it, then checks the fifo again,
+ * so items put between the last read and the rearm are not missed.
+ *
+ * The non-blocking API is unchanged, puts and gets signal the fds by
+ * themselves. Only available on Linux.
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+/* C-Library includes */
+#include <stddef.h> /* for size_t */
+
+/* Local includes */
+#include "cfifo.h"
+
+/*======= Public macro definitions ==========================================*/
+
+/* Events for cfifo_enable_notify(). */
+#define CFIFO_NOTIFY_DATA   0x01u   /* Items available, for the consumer */
+#define CFIFO_NOTIFY_SPACE  0x02u   /* Slots free, for the producer */
+
+/*======= Public function declarations ======================================*/
+
+/**
+ * @brief Create the eventfds for the requested events and arm them.
+ *
+ * Must be called after cfifo_init() and before the fifo is used from more
+ * than one thread. An fd whose condition already holds is signalled right
+ * away.
+ *
+ * @param   p_cfifo
+ * @param   events      CFIFO_NOTIFY_DATA and/or CFIFO_NOTIFY_SPACE
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_BAD_SIZE if events is empty or has unknown bits
+ * @return  CFIFO_ERR_INVALID_STATE if already enabled or not supported
+ * @return  CFIFO_ERR_NO_MEM if an eventfd could not be created
+ *
+ */
+cfifo_ret_t cfifo_enable_notify(cfifo_t p_cfifo,
+                                unsigned int events);
+
+/**
+ * @brief Close the eventfds. The fifo must not be in use by other threads.
+ *
+ * @param   p_cfifo
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ *
+ */
+cfifo_ret_t cfifo_disable_notify(cfifo_t p_cfifo);
+
+/**
+ * @brief eventfd signalled when items arrive, or -1 if not enabled.
+ */
+int cfifo_data_fd(cfifo_t p_cfifo);
+
+/**
+ * @brief eventfd signalled when slots are freed, or -1 if not enabled.
+ */
+int cfifo_space_fd(cfifo_t p_cfifo);
+
+/**
+ * @brief Reset and arm the data fd. Consumer side.
+ *
+ * @param   p_cfifo
+ *
+ * @return  Number of stored items. If 0 the fd is armed and the consumer can
+ *          go back to waiting for it, otherwise it should keep reading.
+ *
+ */
+size_t cfifo_rearm_data(cfifo_t p_cfifo);
+
+/**
+ * @brief Reset and arm the space fd. Producer side.
+ *
+ * @param   p_cfifo
+ *
+ * @return  Number of free slots. If 0 the fd is armed and the producer can
+ *          go back to waiting for it, otherwise it should keep writing.
+ *
+ */
+size_t cfifo_rearm_space(cfifo_t p_cfifo);
+
+/*
+ * Used by cfifo.c after storing a new position with a seq_cst store:
+ * signals fd if *p_armed is set, and disarms it.
+ */
+void cfifo_notify_signal(int fd,
+                         volatile unsigned int *p_armed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CFIFO_NOTIFY_H_ */
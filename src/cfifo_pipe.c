@@ -0,0 +1,178 @@
+/**
+ * @file cfifo_pipe.c
+ *
+ * Pipeline of processing stages sharing one cfifo_t, see cfifo_pipe.h.
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+/* C-Library includes */
+#include <stddef.h> /* For offsetof */
+
+/* Local includes */
+#include "cfifo_pipe.h"
+#include "cfifo_atomic.h"
+#include "cfifo_pos.h"
+
+/*======= Local Macro Definitions ===========================================*/
+
+#define CFIFO_PIPE_LAST(stage)  ((stage) + 1 == p_pipe->num_stages)
+
+/*======= Type Definitions and declarations =================================*/
+
+#if defined(__GNUC__)
+/* Fails to compile if the cache line layout of cfifo_pipe.h is lost. */
+typedef char cfifo_pipe_layout_check
+    [(sizeof(struct cfifo_pipe_stage_s) % CFIFO_CACHE_LINE_SIZE == 0 &&
+      offsetof(struct cfifo_pipe_s, stages) % CFIFO_CACHE_LINE_SIZE == 0) ?
+     1 : -1];
+#endif
+
+/*======= Local function prototypes =========================================*/
+
+static size_t cfifoi_pipe_pos(cfifo_pipe_t p_pipe, size_t stage);
+static size_t cfifoi_pipe_available(cfifo_pipe_t p_pipe,
+                                    size_t stage,
+                                    size_t num_items);
+
+/*======= Global function implementations ===================================*/
+
+cfifo_ret_t cfifo_pipe_init(cfifo_pipe_t p_pipe,
+                            uint8_t *p_buf,
+                            size_t num_items,
+                            size_t item_size,
+                            size_t buf_size,
+                            size_t num_stages)
+{
+    cfifo_ret_t ret;
+    size_t i;
+
+    if (NULL == p_pipe || NULL == p_buf)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (0 == num_stages || num_stages > CFIFO_PIPE_MAX_STAGES)
+    {
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+    ret = cfifo_init(&p_pipe->fifo, p_buf, num_items, item_size, buf_size);
+    if (CFIFO_SUCCESS != ret)
+    {
+        return ret;
+    }
+
+    p_pipe->num_stages = num_stages;
+    for (i = 0; i < CFIFO_PIPE_MAX_STAGES; i++)
+    {
+        p_pipe->stages[i].pos = 0;
+        p_pipe->stages[i].upstream_cache = 0;
+    }
+
+    return CFIFO_SUCCESS;
+}
+
+cfifo_ret_t cfifo_pipe_claim(cfifo_pipe_t p_pipe,
+                             size_t stage,
+                             cfifo_span_t p_spans[2])
+{
+    size_t available;
+
+    if (NULL == p_pipe || NULL == p_spans)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (stage >= p_pipe->num_stages)
+    {
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+    available = cfifoi_pipe_available(p_pipe, stage,
+                                      p_pipe->fifo.num_items_mask + 1);
+    /* Like cfifo_acquire(), for mirrored or relative buffers as well. */
+    cfifo_pos_spans(&p_pipe->fifo, cfifoi_pipe_pos(p_pipe, stage),
+                    available, p_spans);
+
+    return (0 == available) ? CFIFO_ERR_EMPTY : CFIFO_SUCCESS;
+}
+
+cfifo_ret_t cfifo_pipe_release(cfifo_pipe_t p_pipe,
+                               size_t stage,
+                               size_t num_items)
+{
+    if (NULL == p_pipe)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (stage >= p_pipe->num_stages ||
+        cfifoi_pipe_available(p_pipe, stage, num_items) < num_items)
+    {
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+    /* Wakes a producer blocked in cfifo_put_wait() as well. */
+    if (CFIFO_PIPE_LAST(stage))
+    {
+        return cfifo_release(&p_pipe->fifo, num_items);
+    }
+
+    CFIFO_STORE_RELEASE(p_pipe->stages[stage].pos,
+                        cfifo_pos_add(&p_pipe->fifo,
+                                      cfifoi_pipe_pos(p_pipe, stage),
+                                      num_items));
+
+    return CFIFO_SUCCESS;
+}
+
+size_t cfifo_pipe_size(cfifo_pipe_t p_pipe,
+                       size_t stage)
+{
+    if (NULL == p_pipe || stage >= p_pipe->num_stages)
+    {
+        return 0;
+    }
+
+    return cfifoi_pipe_available(p_pipe, stage, p_pipe->fifo.num_items_mask + 1);
+}
+
+/*======= Local function implementations ====================================*/
+
+/* Cursor of a stage, owned by that stage. */
+static size_t cfifoi_pipe_pos(cfifo_pipe_t p_pipe, size_t stage)
+{
+    if (CFIFO_PIPE_LAST(stage))
+    {
+        return CFIFO_LOAD_RELAXED(p_pipe->fifo.read_pos);
+    }
+    return CFIFO_LOAD_RELAXED(p_pipe->stages[stage].pos);
+}
+
+/*
+ * Items released to a stage by the stage before, or put by the producer
+ * for stage 0. The cursor before is loaded again only if the cached one
+ * gives fewer than num_items. The acquire load pairs with the release store
+ * of that cursor, so the items are seen as the stage before left them.
+ */
+static size_t cfifoi_pipe_available(cfifo_pipe_t p_pipe,
+                                    size_t stage,
+                                    size_t num_items)
+{
+    struct cfifo_pipe_stage_s *p_stage = &p_pipe->stages[stage];
+    size_t pos = cfifoi_pipe_pos(p_pipe, stage);
+
+    if (cfifo_pos_diff(&p_pipe->fifo, p_stage->upstream_cache, pos) < num_items)
+    {
+        p_stage->upstream_cache = (0 == stage) ?
+                                  CFIFO_LOAD_ACQUIRE(p_pipe->fifo.write_pos) :
+                                  CFIFO_LOAD_ACQUIRE(p_pipe->stages[stage - 1].pos);
+    }
+
+    return cfifo_pos_diff(&p_pipe->fifo, p_stage->upstream_cache, pos);
+}
@@ -0,0 +1,150 @@
+#ifndef _CFIFO_PIPE_H_
+#define _CFIFO_PIPE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file cfifo_pipe.h
+ *
+ * Pipeline of processing stages sharing one cfifo_t, items never move.
+ *
+ * The producer puts into the embedded fifo with the usual cfifo_put(),
+ * cfifo_write() or cfifo_reserve()/cfifo_commit(). Stage 0 then claims the
+ * items in place, works on them and releases them to stage 1, and so on.
+ * Each stage has its own cursor and only ever claims up to the cursor of
+ * the stage before it. The cursor of the last stage is the fifo's read
+ * position, so the producer only reuses slots the last stage released.
+ *
+ * A claim hands out everything the stage before has released, as one or
+ * two spans like cfifo_acquire(), so stages work in batches. A release is
+ * one release store of the stage's cursor.
+ *
+ * One producer thread and one thread per stage. The embedded fifo stays a
+ * normal cfifo_t: cfifo_size() counts the items in the pipeline and
+ * cfifo_peek() shows the oldest one, for single threaded debugging. Only
+ * the last stage may move the read position, with cfifo_pipe_release().
+ * cfifo_get(), cfifo_read(), cfifo_release() or cfifo_flush() on the
+ * embedded fifo would hand items back to the producer before the earlier
+ * stages are done with them, and so would overwrite mode. Mirrored and
+ * relative buffers work, claims honour them like cfifo_acquire().
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+/* C-Library includes */
+#include <stddef.h> /* for size_t */
+#include <stdint.h> /* for uint8_t */
+
+/* Local includes */
+#include "cfifo.h"
+
+/*======= Public macro definitions ==========================================*/
+
+#ifndef CFIFO_PIPE_MAX_STAGES
+#define CFIFO_PIPE_MAX_STAGES   8
+#endif
+
+/*======= Type Definitions and declarations =================================*/
+
+typedef struct cfifo_pipe_s *cfifo_pipe_t;
+
+/*
+ * Each stage starts a cache line of its own, with or without
+ * CFIFO_SEPARATE_CACHE_LINES, so a release does not disturb the neighbours.
+ */
+struct cfifo_pipe_stage_s {
+    /* Stage owned, unused for the last stage, see cfifo_pipe.h. */
+    volatile size_t pos CFIFO_ALIGNED(CFIFO_CACHE_LINE_SIZE);
+    /* The last cursor of the stage before that this stage has seen. */
+    size_t          upstream_cache;
+};
+
+struct cfifo_pipe_s {
+    struct cfifo_s  fifo;
+    size_t          num_stages;
+    struct cfifo_pipe_stage_s stages[CFIFO_PIPE_MAX_STAGES];
+};
+
+/*======= Public function declarations ======================================*/
+
+/**
+ * @brief Initialize an empty pipeline.
+ *
+ * @param   p_pipe
+ * @param   p_buf
+ * @param   num_items   Capacity, as for cfifo_init().
+ * @param   item_size
+ * @param   buf_size
+ * @param   num_stages  1 to CFIFO_PIPE_MAX_STAGES.
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_BAD_SIZE
+ *
+ */
+cfifo_ret_t cfifo_pipe_init(cfifo_pipe_t p_pipe,
+                            uint8_t *p_buf,
+                            size_t num_items,
+                            size_t item_size,
+                            size_t buf_size,
+                            size_t num_stages);
+
+/**
+ * @brief Claim the items released by the stage before, for use in place.
+ *
+ * Stage 0 claims what the producer put. Fills p_spans with the claimed
+ * items, oldest first; the second span is only non-empty when they wrap
+ * around the end of the buffer. From the stage's thread only.
+ *
+ * @param   p_pipe
+ * @param   stage
+ * @param   p_spans     Two spans, filled in on return.
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_BAD_SIZE if there is no such stage
+ * @return  CFIFO_ERR_EMPTY if there is nothing to claim
+ *
+ */
+cfifo_ret_t cfifo_pipe_claim(cfifo_pipe_t p_pipe,
+                             size_t stage,
+                             cfifo_span_t p_spans[2]);
+
+/**
+ * @brief Hand the oldest num_items claimed items on to the next stage, or
+ * back to the producer from the last stage.
+ *
+ * @param   p_pipe
+ * @param   stage
+ * @param   num_items
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_BAD_SIZE if there is no such stage, or num_items is
+ *          more than the stage before has released
+ *
+ */
+cfifo_ret_t cfifo_pipe_release(cfifo_pipe_t p_pipe,
+                               size_t stage,
+                               size_t num_items);
+
+/**
+ * @brief Number of items waiting for a stage. From the stage's thread.
+ *
+ * @param   p_pipe
+ * @param   stage
+ *
+ * @return  The items, 0 if p_pipe is NULL or there is no such stage.
+ *
+ */
+size_t cfifo_pipe_size(cfifo_pipe_t p_pipe,
+                       size_t stage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CFIFO_PIPE_H_ */
@@ -0,0 +1,110 @@
+#ifndef _CFIFO_POS_H_
+#define _CFIFO_POS_H_
+
+/**
+ * @file cfifo_pos.h
+ *
+ * Read/write position arithmetic of struct cfifo_s.
+ *
+ * With a power of 2 capacity the positions run freely and wrap at SIZE_MAX,
+ * a slot is found by masking. Other capacities keep the positions in
+ * [0, 2 * capacity), pos_wrap, so that full and empty still differ; moving
+ * a position then takes one conditional subtract and finding a slot
+ * another, there is no division anywhere. pos_wrap is 0 in the first case,
+ * the same code serves both.
+ *
+ * The buffer helpers at the end also handle relative and mirrored buffers,
+ * for modules that hand out slots in place.
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+/* C-Library includes */
+#include <stddef.h> /* for size_t */
+#include <stdint.h> /* for uint8_t, uintptr_t */
+
+/* Local includes */
+#include "cfifo.h"
+
+/*======= Public function declarations ======================================*/
+
+/* Position num_items (at most the capacity) after pos. */
+CFIFO_STATIC_INLINE size_t cfifo_pos_add(cfifo_t p_cfifo,
+                                         size_t pos,
+                                         size_t num_items)
+{
+    pos += num_items;
+    if (0 != p_cfifo->pos_wrap && pos >= p_cfifo->pos_wrap)
+    {
+        pos -= p_cfifo->pos_wrap;
+    }
+    return pos;
+}
+
+/* Position num_items (at most the capacity) before pos. */
+CFIFO_STATIC_INLINE size_t cfifo_pos_sub(cfifo_t p_cfifo,
+                                         size_t pos,
+                                         size_t num_items)
+{
+    if (pos < num_items)
+    {
+        pos += p_cfifo->pos_wrap;
+    }
+    return pos - num_items;
+}
+
+/* Number of items from position start up to position end. */
+CFIFO_STATIC_INLINE size_t cfifo_pos_diff(cfifo_t p_cfifo,
+                                          size_t end,
+                                          size_t start)
+{
+    return (end < start) ? end - start + p_cfifo->pos_wrap : end - start;
+}
+
+/* Slot of position pos, 0 to capacity - 1. */
+CFIFO_STATIC_INLINE size_t cfifo_pos_slot(cfifo_t p_cfifo, size_t pos)
+{
+    if (0 == p_cfifo->pos_wrap)
+    {
+        return pos & p_cfifo->num_items_mask;
+    }
+    return (pos > p_cfifo->num_items_mask) ? pos - p_cfifo->num_items_mask - 1 : pos;
+}
+
+/* Start of the buffer, p_buf is an offset from the struct if relative. */
+CFIFO_STATIC_INLINE uint8_t *cfifo_pos_buf(cfifo_t p_cfifo)
+{
+    if (p_cfifo->flags & CFIFO_FLAG_RELATIVE)
+    {
+        return (uint8_t *) p_cfifo + (uintptr_t) p_cfifo->p_buf;
+    }
+    return p_cfifo->p_buf;
+}
+
+/*
+ * Split num_items items starting at position pos into the part up to the end
+ * of the buffer and the part that wraps around to the start of it. A
+ * mirrored buffer needs no split.
+ */
+CFIFO_STATIC_INLINE void cfifo_pos_spans(cfifo_t p_cfifo,
+                                         size_t pos,
+                                         size_t num_items,
+                                         cfifo_span_t p_spans[2])
+{
+    uint8_t *p_buf = cfifo_pos_buf(p_cfifo);
+    size_t slot = cfifo_pos_slot(p_cfifo, pos);
+    size_t first = p_cfifo->num_items_mask + 1 - slot;
+
+    if ((p_cfifo->flags & CFIFO_FLAG_MIRRORED) || num_items < first)
+    {
+        first = num_items;
+    }
+
+    p_spans[0].p_data = &p_buf[slot * p_cfifo->item_size];
+    p_spans[0].num_items = first;
+    p_spans[1].p_data = p_buf;
+    p_spans[1].num_items = num_items - first;
+}
+
+#endif /* _CFIFO_POS_H_ */
@@ -0,0 +1,282 @@
+/**
+ * @file cfifo_rec.c
+ *
+ * Variable length records in a byte fifo, see cfifo_rec.h.
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+/* C-Library includes */
+#include <string.h> /* For memcpy */
+
+/* Local includes */
+#include "cfifo_rec.h"
+
+/*======= Local Macro Definitions ===========================================*/
+
+#define CFIFO_CAPACITY      (p_cfifo->num_items_mask + 1)
+
+/*
+ * First header word: the payload length, or CFIFO_REC_SKIP plus the size of
+ * the padding up to the end of the buffer. The second word is unused.
+ */
+#define CFIFO_REC_SKIP      0x80000000ul
+#define CFIFO_REC_LEN_MAX   (CFIFO_REC_SKIP - CFIFO_REC_HDR_SIZE)
+
+/*======= Local function prototypes =========================================*/
+
+static int cfifoi_rec_valid(cfifo_t p_cfifo);
+static uint32_t cfifoi_rec_hdr(const uint8_t *p_rec);
+static void cfifoi_rec_set_hdr(uint8_t *p_rec, uint32_t hdr);
+static cfifo_ret_t cfifoi_rec_copy(cfifo_t p_cfifo,
+                                   void *p_data,
+                                   size_t *p_len,
+                                   int release);
+
+/*======= Global function implementations ===================================*/
+
+cfifo_ret_t cfifo_rec_put(cfifo_t p_cfifo,
+                          const void *p_data,
+                          size_t len)
+{
+    cfifo_ret_t ret;
+    void *p_payload;
+
+    if (NULL == p_cfifo || NULL == p_data)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    ret = cfifo_rec_reserve(p_cfifo, len, &p_payload);
+    if (CFIFO_SUCCESS != ret)
+    {
+        return ret;
+    }
+
+    memcpy(p_payload, p_data, len);
+
+    return cfifo_rec_commit(p_cfifo, len);
+}
+
+cfifo_ret_t cfifo_rec_get(cfifo_t p_cfifo,
+                          void *p_data,
+                          size_t *p_len)
+{
+    return cfifoi_rec_copy(p_cfifo, p_data, p_len, 1);
+}
+
+cfifo_ret_t cfifo_rec_peek(cfifo_t p_cfifo,
+                           void *p_data,
+                           size_t *p_len)
+{
+    return cfifoi_rec_copy(p_cfifo, p_data, p_len, 0);
+}
+
+cfifo_ret_t cfifo_rec_reserve(cfifo_t p_cfifo,
+                              size_t len,
+                              void **pp_data)
+{
+    cfifo_span_t spans[2];
+    uint8_t *p_rec;
+    size_t rec_size;
+
+    if (NULL == p_cfifo || NULL == pp_data)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (!cfifoi_rec_valid(p_cfifo) || len > CFIFO_REC_LEN_MAX ||
+        CFIFO_REC_SIZE(len) > CFIFO_CAPACITY)
+    {
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+    if (CFIFO_SUCCESS != cfifo_reserve(p_cfifo, spans))
+    {
+        return CFIFO_ERR_FULL;
+    }
+
+    rec_size = CFIFO_REC_SIZE(len);
+    p_rec = spans[0].p_data;
+    if (spans[0].num_items < rec_size)
+    {
+        /*
+         * Only the end of the buffer stops the record from fitting: the
+         * record can never go there, so skip it now, even if there is no
+         * room at the start yet either. A mirrored buffer has no end.
+         */
+        if ((p_cfifo->flags & CFIFO_FLAG_MIRRORED) ||
+            (&spans[0].p_data[spans[0].num_items] !=
+             &spans[1].p_data[CFIFO_CAPACITY]))
+        {
+            return CFIFO_ERR_FULL;
+        }
+
+        cfifoi_rec_set_hdr(spans[0].p_data,
+                           (uint32_t) (CFIFO_REC_SKIP | spans[0].num_items));
+        (void) cfifo_commit(p_cfifo, spans[0].num_items);
+
+        if (spans[1].num_items < rec_size)
+        {
+            return CFIFO_ERR_FULL;
+        }
+        p_rec = spans[1].p_data;
+    }
+
+    /* Remember the reserved length for cfifo_rec_commit(). */
+    cfifoi_rec_set_hdr(p_rec, (uint32_t) len);
+    *pp_data = &p_rec[CFIFO_REC_HDR_SIZE];
+
+    return CFIFO_SUCCESS;
+}
+
+cfifo_ret_t cfifo_rec_commit(cfifo_t p_cfifo,
+                             size_t len)
+{
+    cfifo_span_t spans[2];
+    uint32_t reserved;
+
+    if (NULL == p_cfifo)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (!cfifoi_rec_valid(p_cfifo) ||
+        CFIFO_SUCCESS != cfifo_reserve(p_cfifo, spans))
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    reserved = cfifoi_rec_hdr(spans[0].p_data);
+    if ((reserved & CFIFO_REC_SKIP) ||
+        spans[0].num_items < CFIFO_REC_SIZE((size_t) reserved))
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    if (len > reserved)
+    {
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+    cfifoi_rec_set_hdr(spans[0].p_data, (uint32_t) len);
+
+    return cfifo_commit(p_cfifo, CFIFO_REC_SIZE(len));
+}
+
+cfifo_ret_t cfifo_rec_acquire(cfifo_t p_cfifo,
+                              void **pp_data,
+                              size_t *p_len)
+{
+    cfifo_span_t spans[2];
+    uint32_t hdr;
+
+    if (NULL == p_cfifo || NULL == pp_data || NULL == p_len)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (!cfifoi_rec_valid(p_cfifo))
+    {
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+    for (;;)
+    {
+        if (CFIFO_SUCCESS != cfifo_acquire(p_cfifo, spans))
+        {
+            return CFIFO_ERR_EMPTY;
+        }
+
+        /* Records are published whole, the header is always there. */
+        hdr = cfifoi_rec_hdr(spans[0].p_data);
+        if (0 == (hdr & CFIFO_REC_SKIP))
+        {
+            break;
+        }
+        (void) cfifo_release(p_cfifo, hdr & ~CFIFO_REC_SKIP);
+    }
+
+    *pp_data = &spans[0].p_data[CFIFO_REC_HDR_SIZE];
+    *p_len = hdr;
+
+    return CFIFO_SUCCESS;
+}
+
+cfifo_ret_t cfifo_rec_release(cfifo_t p_cfifo)
+{
+    cfifo_ret_t ret;
+    void *p_payload;
+    size_t len;
+
+    ret = cfifo_rec_acquire(p_cfifo, &p_payload, &len);
+    if (CFIFO_SUCCESS != ret)
+    {
+        return ret;
+    }
+
+    return cfifo_release(p_cfifo, CFIFO_REC_SIZE(len));
+}
+
+/*======= Local function implementations ====================================*/
+
+/* Byte fifo whose positions stay CFIFO_REC_ALIGN aligned. */
+static int cfifoi_rec_valid(cfifo_t p_cfifo)
+{
+    return (NULL != p_cfifo->p_buf) &&
+           (1 == p_cfifo->item_size) &&
+           (CFIFO_CAPACITY >= CFIFO_REC_ALIGN) &&
+           (0 == (CFIFO_CAPACITY & (CFIFO_REC_ALIGN - 1)));
+}
+
+/* Headers are copied, the buffer need not be aligned for uint32_t. */
+static uint32_t cfifoi_rec_hdr(const uint8_t *p_rec)
+{
+    uint32_t hdr;
+
+    memcpy(&hdr, p_rec, sizeof(hdr));
+    return hdr;
+}
+
+static void cfifoi_rec_set_hdr(uint8_t *p_rec, uint32_t hdr)
+{
+    memcpy(p_rec, &hdr, sizeof(hdr));
+}
+
+static cfifo_ret_t cfifoi_rec_copy(cfifo_t p_cfifo,
+                                   void *p_data,
+                                   size_t *p_len,
+                                   int release)
+{
+    cfifo_ret_t ret;
+    void *p_payload;
+    size_t len;
+
+    if (NULL == p_cfifo || NULL == p_data || NULL == p_len)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    ret = cfifo_rec_acquire(p_cfifo, &p_payload, &len);
+    if (CFIFO_SUCCESS != ret)
+    {
+        return ret;
+    }
+
+    if (len > *p_len)
+    {
+        *p_len = len;
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+    memcpy(p_data, p_payload, len);
+    *p_len = len;
+
+    return release ? cfifo_release(p_cfifo, CFIFO_REC_SIZE(len)) : CFIFO_SUCCESS;
+}
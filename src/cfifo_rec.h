@@ -0,0 +1,167 @@
+#ifndef _CFIFO_REC_H_
+#define _CFIFO_REC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file cfifo_rec.h
+ *
+ * Variable length records in a byte fifo.
+ *
+ * The records are stored in a cfifo_t with an item_size of 1, e.g. one
+ * made with CFIFO_CREATE(fifo, uint8_t, 4096), and use its positions, mask
+ * and handshake unchanged. Every record is a CFIFO_REC_HDR_SIZE byte header
+ * holding the payload length, followed by the payload, padded to a multiple
+ * of CFIFO_REC_ALIGN bytes. A record never wraps around the end of the
+ * buffer: when it does not fit in front of the end, the producer fills the
+ * rest of the buffer with a skip record that the consumer drops. Payloads
+ * are therefore contiguous, and aligned to CFIFO_REC_ALIGN if the buffer is.
+ *
+ * Same single-producer/single-consumer rules as cfifo_t. Do not mix with
+ * the item functions of cfifo.h on the same fifo, except cfifo_size(),
+ * cfifo_available() and cfifo_flush(), which work in bytes.
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+/* C-Library includes */
+#include <stddef.h> /* for size_t */
+#include <stdint.h> /* for uint8_t */
+
+/* Local includes */
+#include "cfifo.h"
+
+/*======= Public macro definitions ==========================================*/
+
+#define CFIFO_REC_ALIGN     8
+#define CFIFO_REC_HDR_SIZE  8
+
+/* Bytes of fifo buffer used by a record with a len bytes payload. */
+#define CFIFO_REC_SIZE(len)                                             \
+        ((CFIFO_REC_HDR_SIZE + (len) + CFIFO_REC_ALIGN - 1) &           \
+         ~((size_t) CFIFO_REC_ALIGN - 1))
+
+/*======= Public function declarations ======================================*/
+
+/**
+ * @brief Store a record, copying len bytes from p_data.
+ *
+ * @param   p_cfifo     Byte fifo, capacity a multiple of CFIFO_REC_ALIGN.
+ * @param   p_data
+ * @param   len         Payload length, CFIFO_REC_SIZE(len) must not be
+ *                      more than the capacity.
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_FULL
+ * @return  CFIFO_ERR_BAD_SIZE
+ *
+ */
+cfifo_ret_t cfifo_rec_put(cfifo_t p_cfifo,
+                          const void *p_data,
+                          size_t len);
+
+/**
+ * @brief Take the oldest record, copying its payload to p_data.
+ *
+ * @param   p_cfifo
+ * @param   p_data
+ * @param   p_len       In: size of p_data, out: payload length.
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_EMPTY
+ * @return  CFIFO_ERR_BAD_SIZE if p_data is too small, *p_len is set to the
+ *          payload length and the record is left in the fifo.
+ *
+ */
+cfifo_ret_t cfifo_rec_get(cfifo_t p_cfifo,
+                          void *p_data,
+                          size_t *p_len);
+
+/**
+ * @brief Copy the oldest record like cfifo_rec_get(), without taking it.
+ *
+ * @param   p_cfifo
+ * @param   p_data
+ * @param   p_len       In: size of p_data, out: payload length.
+ *
+ * @return  See cfifo_rec_get().
+ *
+ */
+cfifo_ret_t cfifo_rec_peek(cfifo_t p_cfifo,
+                           void *p_data,
+                           size_t *p_len);
+
+/**
+ * @brief Reserve room for a record of up to len bytes, to write in place.
+ *
+ * Nothing is visible to the consumer until cfifo_rec_commit() is called.
+ * Producer side only.
+ *
+ * @param   p_cfifo
+ * @param   len
+ * @param   pp_data     Set to the contiguous payload space.
+ *
+ * @return  See cfifo_rec_put().
+ *
+ */
+cfifo_ret_t cfifo_rec_reserve(cfifo_t p_cfifo,
+                              size_t len,
+                              void **pp_data);
+
+/**
+ * @brief Publish the record reserved with cfifo_rec_reserve().
+ *
+ * @param   p_cfifo
+ * @param   len         Payload length written, at most the reserved length.
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_BAD_SIZE if len is more than the reserved length
+ * @return  CFIFO_ERR_INVALID_STATE if nothing is reserved
+ *
+ */
+cfifo_ret_t cfifo_rec_commit(cfifo_t p_cfifo,
+                             size_t len);
+
+/**
+ * @brief Acquire the oldest record for reading in place.
+ *
+ * The record stays in the fifo until cfifo_rec_release() is called.
+ * Consumer side only.
+ *
+ * @param   p_cfifo
+ * @param   pp_data     Set to the payload.
+ * @param   p_len       Set to the payload length.
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_EMPTY
+ * @return  CFIFO_ERR_BAD_SIZE if the fifo is not a record fifo
+ *
+ */
+cfifo_ret_t cfifo_rec_acquire(cfifo_t p_cfifo,
+                              void **pp_data,
+                              size_t *p_len);
+
+/**
+ * @brief Take the oldest record after reading it in place.
+ *
+ * @param   p_cfifo
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_EMPTY
+ *
+ */
+cfifo_ret_t cfifo_rec_release(cfifo_t p_cfifo);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CFIFO_REC_H_ */
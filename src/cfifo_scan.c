@@ -0,0 +1,290 @@
+/**
+ * @file cfifo_scan.c
+ *
+ * Item search kernels, see cfifo_scan.h.
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+/* C-Library includes */
+#include <string.h> /* For memcmp */
+
+/* Local includes */
+#include "cfifo.h"
+#include "cfifo_scan.h"
+#include "cfifo_atomic.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || \
+                          (defined(__i386__) && defined(__SSE2__)))
+#define CFIFO_SCAN_X86  1
+#include <immintrin.h>
+#else
+#define CFIFO_SCAN_X86  0
+#endif
+
+/*======= Local Macro Definitions ===========================================*/
+
+/* Widest key that is repeated over a vector. */
+#define CFIFO_SCAN_MAX_KEY  16
+
+/*======= Local function prototypes =========================================*/
+
+static size_t cfifoi_count_generic(const uint8_t *p_data,
+                                   size_t num_items,
+                                   size_t item_size,
+                                   const void *p_key);
+static size_t cfifoi_find_generic(const uint8_t *p_data,
+                                  size_t num_items,
+                                  size_t item_size,
+                                  const void *p_key);
+
+#if CFIFO_SCAN_X86
+static int cfifoi_vector_size(size_t item_size);
+static uint32_t cfifoi_item_mask(uint32_t mask, size_t item_size);
+static size_t cfifoi_scan_sse2(const uint8_t *p_data,
+                               size_t num_bytes,
+                               size_t item_size,
+                               const uint8_t *p_pattern,
+                               int find);
+static size_t cfifoi_scan_avx2(const uint8_t *p_data,
+                               size_t num_bytes,
+                               size_t item_size,
+                               const uint8_t *p_pattern,
+                               int find);
+#endif
+
+/*======= Global function implementations ===================================*/
+
+size_t cfifo_scan_count(const uint8_t *p_data,
+                        size_t num_items,
+                        size_t item_size,
+                        const void *p_key)
+{
+#if CFIFO_SCAN_X86
+    int vector_size = cfifoi_vector_size(item_size);
+    uint8_t pattern[32];
+    size_t num_bytes;
+    size_t count;
+    size_t i;
+
+    if (0 == vector_size)
+    {
+        return cfifoi_count_generic(p_data, num_items, item_size, p_key);
+    }
+
+    for (i = 0; i < sizeof(pattern); i += item_size)
+    {
+        memcpy(&pattern[i], p_key, item_size);
+    }
+
+    /* Whole vectors first, then the remaining items one by one. */
+    num_bytes = ((num_items * item_size) / (size_t) vector_size) * (size_t) vector_size;
+    count = (32 == vector_size) ?
+            cfifoi_scan_avx2(p_data, num_bytes, item_size, pattern, 0) :
+            cfifoi_scan_sse2(p_data, num_bytes, item_size, pattern, 0);
+
+    return count + cfifoi_count_generic(&p_data[num_bytes],
+                                        num_items - num_bytes / item_size,
+                                        item_size,
+                                        p_key);
+#else
+    return cfifoi_count_generic(p_data, num_items, item_size, p_key);
+#endif
+}
+
+size_t cfifo_scan_find(const uint8_t *p_data,
+                       size_t num_items,
+                       size_t item_size,
+                       const void *p_key)
+{
+#if CFIFO_SCAN_X86
+    int vector_size = cfifoi_vector_size(item_size);
+    uint8_t pattern[32];
+    size_t num_bytes;
+    size_t offset;
+    size_t i;
+
+    if (0 == vector_size)
+    {
+        return cfifoi_find_generic(p_data, num_items, item_size, p_key);
+    }
+
+    for (i = 0; i < sizeof(pattern); i += item_size)
+    {
+        memcpy(&pattern[i], p_key, item_size);
+    }
+
+    num_bytes = ((num_items * item_size) / (size_t) vector_size) * (size_t) vector_size;
+    offset = (32 == vector_size) ?
+             cfifoi_scan_avx2(p_data, num_bytes, item_size, pattern, 1) :
+             cfifoi_scan_sse2(p_data, num_bytes, item_size, pattern, 1);
+    if (offset < num_bytes)
+    {
+        return offset / item_size;
+    }
+
+    return num_bytes / item_size +
+           cfifoi_find_generic(&p_data[num_bytes],
+                               num_items - num_bytes / item_size,
+                               item_size,
+                               p_key);
+#else
+    return cfifoi_find_generic(p_data, num_items, item_size, p_key);
+#endif
+}
+
+/*======= Local function implementations ====================================*/
+
+static size_t cfifoi_count_generic(const uint8_t *p_data,
+                                   size_t num_items,
+                                   size_t item_size,
+                                   const void *p_key)
+{
+    size_t count = 0;
+    size_t i;
+
+    for (i = 0; i < num_items; i++)
+    {
+        if (memcmp(&p_data[i * item_size], p_key, item_size) == 0)
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+static size_t cfifoi_find_generic(const uint8_t *p_data,
+                                  size_t num_items,
+                                  size_t item_size,
+                                  const void *p_key)
+{
+    size_t i;
+
+    for (i = 0; i < num_items; i++)
+    {
+        if (memcmp(&p_data[i * item_size], p_key, item_size) == 0)
+        {
+            break;
+        }
+    }
+    return i;
+}
+
+#if CFIFO_SCAN_X86
+
+/*
+ * Vector width in bytes for item_size, 0 for the generic path. The CPU
+ * check is done once, racing first calls store the same value.
+ */
+static int cfifoi_vector_size(size_t item_size)
+{
+    static int s_vector_size;
+    int vector_size = CFIFO_LOAD_RELAXED(s_vector_size);
+
+    if (item_size > CFIFO_SCAN_MAX_KEY || !CFIFO_IS_POW_2(item_size))
+    {
+        return 0;
+    }
+
+    if (0 == vector_size)
+    {
+        __builtin_cpu_init();
+        vector_size = __builtin_cpu_supports("avx2") ? 32 : 16;
+        CFIFO_STORE_RELAXED(s_vector_size, vector_size);
+    }
+    return vector_size;
+}
+
+/*
+ * Reduce a byte wise equality mask to one bit per item, set on the first
+ * byte of every item whose bytes all matched.
+ */
+static uint32_t cfifoi_item_mask(uint32_t mask, size_t item_size)
+{
+    switch (item_size)
+    {
+    case 1:
+        return mask;
+    case 2:
+        return mask & (mask >> 1) & 0x55555555u;
+    case 4:
+        mask &= mask >> 1;
+        return mask & (mask >> 2) & 0x11111111u;
+    case 8:
+        mask &= mask >> 1;
+        mask &= mask >> 2;
+        return mask & (mask >> 4) & 0x01010101u;
+    default:
+        mask &= mask >> 1;
+        mask &= mask >> 2;
+        mask &= mask >> 4;
+        return mask & (mask >> 8) & 0x00010001u;
+    }
+}
+
+/*
+ * Scan num_bytes (a multiple of 16) of items. Returns the number of
+ * matches, or with find set the byte offset of the first match and
+ * num_bytes if there is none.
+ */
+static size_t cfifoi_scan_sse2(const uint8_t *p_data,
+                               size_t num_bytes,
+                               size_t item_size,
+                               const uint8_t *p_pattern,
+                               int find)
+{
+    __m128i key = _mm_loadu_si128((const __m128i *) (const void *) p_pattern);
+    size_t count = 0;
+    size_t offset;
+    uint32_t mask;
+
+    for (offset = 0; offset < num_bytes; offset += 16)
+    {
+        __m128i data = _mm_loadu_si128((const __m128i *) (const void *) &p_data[offset]);
+
+        mask = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(data, key));
+        mask = cfifoi_item_mask(mask, item_size);
+        if (0 != mask)
+        {
+            if (find)
+            {
+                return offset + (size_t) __builtin_ctz(mask);
+            }
+            count += (size_t) __builtin_popcount(mask);
+        }
+    }
+    return find ? num_bytes : count;
+}
+
+__attribute__((target("avx2")))
+static size_t cfifoi_scan_avx2(const uint8_t *p_data,
+                               size_t num_bytes,
+                               size_t item_size,
+                               const uint8_t *p_pattern,
+                               int find)
+{
+    __m256i key = _mm256_loadu_si256((const __m256i *) (const void *) p_pattern);
+    size_t count = 0;
+    size_t offset;
+    uint32_t mask;
+
+    for (offset = 0; offset < num_bytes; offset += 32)
+    {
+        __m256i data = _mm256_loadu_si256((const __m256i *) (const void *) &p_data[offset]);
+
+        mask = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(data, key));
+        mask = cfifoi_item_mask(mask, item_size);
+        if (0 != mask)
+        {
+            if (find)
+            {
+                return offset + (size_t) __builtin_ctz(mask);
+            }
+            count += (size_t) __builtin_popcount(mask);
+        }
+    }
+    return find ? num_bytes : count;
+}
+
+#endif /* CFIFO_SCAN_X86 */
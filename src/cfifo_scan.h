@@ -0,0 +1,56 @@
+#ifndef _CFIFO_SCAN_H_
+#define _CFIFO_SCAN_H_
+
+/**
+ * @file cfifo_scan.h
+ *
+ * Item search kernels over a contiguous run of items, used by
+ * cfifo_contains() and cfifo_find().
+ *
+ * Items of 1, 2, 4, 8 and 16 bytes are compared 16 or 32 bytes at a time
+ * with SSE2 or AVX2, picked at run time from the CPU features. The key is
+ * repeated over a vector, compared byte wise, and an item matches when all
+ * of its byte lanes do. Other item sizes, and other architectures, compare
+ * item by item with memcmp.
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+/* C-Library includes */
+#include <stddef.h> /* for size_t */
+#include <stdint.h> /* for uint8_t */
+
+/*======= Public function declarations ======================================*/
+
+/**
+ * @brief Number of items in p_data equal to p_key.
+ *
+ * @param   p_data
+ * @param   num_items
+ * @param   item_size
+ * @param   p_key
+ *
+ * @return  Number of matching items.
+ */
+size_t cfifo_scan_count(const uint8_t *p_data,
+                        size_t num_items,
+                        size_t item_size,
+                        const void *p_key);
+
+/**
+ * @brief Index of the first item in p_data equal to p_key.
+ *
+ * @param   p_data
+ * @param   num_items
+ * @param   item_size
+ * @param   p_key
+ *
+ * @return  Index of the match, num_items if there is none.
+ */
+size_t cfifo_scan_find(const uint8_t *p_data,
+                       size_t num_items,
+                       size_t item_size,
+                       const void *p_key);
+
+#endif /* _CFIFO_SCAN_H_ */
@@ -0,0 +1,392 @@
+/**
+ * @file cfifo_seg.c
+ *
+ * Unbounded segmented fifo, see cfifo_seg.h.
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+/* C-Library includes */
+#include <stddef.h> /* For offsetof */
+#include <stdlib.h> /* For malloc */
+
+/* Local includes */
+#include "cfifo_seg.h"
+#include "cfifo_atomic.h"
+
+/*======= Local Macro Definitions ===========================================*/
+
+/* The buffer follows the header, both start on a cache line. */
+#define CFIFO_SEG_HDR_SIZE                                                  \
+        ((sizeof(struct cfifo_segment_s) + CFIFO_CACHE_LINE_SIZE - 1) &     \
+         ~((size_t) CFIFO_CACHE_LINE_SIZE - 1))
+#define CFIFO_SEG_BUF(p_segment)    ((uint8_t *) (p_segment) + CFIFO_SEG_HDR_SIZE)
+#define CFIFO_SEG_BUF_SIZE          (p_seg->seg_items * p_seg->item_size)
+
+/*======= Type Definitions and declarations =================================*/
+
+struct cfifo_segment_s {
+    struct cfifo_s          fifo;
+    /* Set by the producer once fifo is full, read by the consumer. */
+    struct cfifo_segment_s  *p_next;
+    /* What malloc() returned, the segment itself is aligned up from it. */
+    void                    *p_alloc;
+};
+
+#if defined(__GNUC__)
+/* Fails to compile if the cache line layout of cfifo_seg.h is lost. */
+typedef char cfifo_seg_layout_check
+    [(offsetof(struct cfifo_seg_s, p_head) % CFIFO_CACHE_LINE_SIZE == 0 &&
+      offsetof(struct cfifo_seg_s, p_tail) % CFIFO_CACHE_LINE_SIZE == 0 &&
+      sizeof(struct cfifo_seg_s) % CFIFO_CACHE_LINE_SIZE == 0) ?
+     1 : -1];
+#endif
+
+/*======= Local function prototypes =========================================*/
+
+static struct cfifo_segment_s *cfifoi_seg_alloc(cfifo_seg_t p_seg);
+static struct cfifo_segment_s *cfifoi_seg_grow(cfifo_seg_t p_seg);
+static void cfifoi_seg_link(cfifo_seg_t p_seg, struct cfifo_segment_s *p_segment);
+static int cfifoi_seg_advance(cfifo_seg_t p_seg);
+
+/*======= Global function implementations ===================================*/
+
+cfifo_ret_t cfifo_seg_create(cfifo_seg_t p_seg,
+                             size_t seg_items,
+                             size_t item_size,
+                             size_t max_free)
+{
+    uint8_t *p_pool_buf = NULL;
+
+    if (NULL == p_seg)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (!CFIFO_IS_POW_2(seg_items) || 0 == item_size ||
+        (SIZE_MAX - CFIFO_SEG_HDR_SIZE - CFIFO_CACHE_LINE_SIZE) / item_size < seg_items ||
+        SIZE_MAX / sizeof(struct cfifo_segment_s *) < max_free)
+    {
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+    p_seg->seg_items = seg_items;
+    p_seg->item_size = item_size;
+    p_seg->pool.p_buf = NULL;
+    p_seg->unlinked = 0;
+    p_seg->linked = 1;
+
+    /* Without a pool every cfifo_put()/cfifo_get() on it fails. */
+    if (max_free > 0)
+    {
+        p_pool_buf = (uint8_t *) malloc(max_free * sizeof(struct cfifo_segment_s *));
+        if (NULL == p_pool_buf)
+        {
+            return CFIFO_ERR_NO_MEM;
+        }
+        (void) cfifo_init(&p_seg->pool,
+                          p_pool_buf,
+                          max_free,
+                          sizeof(struct cfifo_segment_s *),
+                          max_free * sizeof(struct cfifo_segment_s *));
+    }
+
+    p_seg->p_tail = cfifoi_seg_alloc(p_seg);
+    if (NULL == p_seg->p_tail)
+    {
+        free(p_pool_buf);
+        p_seg->pool.p_buf = NULL;
+        return CFIFO_ERR_NO_MEM;
+    }
+    p_seg->p_head = p_seg->p_tail;
+
+    return CFIFO_SUCCESS;
+}
+
+cfifo_ret_t cfifo_seg_destroy(cfifo_seg_t p_seg)
+{
+    struct cfifo_segment_s *p_segment;
+    struct cfifo_segment_s *p_next;
+
+    if (NULL == p_seg)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (NULL == p_seg->p_head)
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    for (p_segment = p_seg->p_head; NULL != p_segment; p_segment = p_next)
+    {
+        p_next = p_segment->p_next;
+        free(p_segment->p_alloc);
+    }
+
+    if (NULL != p_seg->pool.p_buf)
+    {
+        while (CFIFO_SUCCESS == cfifo_get(&p_seg->pool, &p_segment))
+        {
+            free(p_segment->p_alloc);
+        }
+        free(p_seg->pool.p_buf);
+        p_seg->pool.p_buf = NULL;
+    }
+
+    p_seg->p_head = NULL;
+    p_seg->p_tail = NULL;
+
+    return CFIFO_SUCCESS;
+}
+
+cfifo_ret_t cfifo_seg_put(cfifo_seg_t p_seg,
+                          const void *p_item)
+{
+    struct cfifo_segment_s *p_segment;
+
+    if (NULL == p_seg || NULL == p_item)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (CFIFO_SUCCESS == cfifo_put(&p_seg->p_tail->fifo, p_item))
+    {
+        return CFIFO_SUCCESS;
+    }
+
+    p_segment = cfifoi_seg_grow(p_seg);
+    if (NULL == p_segment)
+    {
+        return CFIFO_ERR_NO_MEM;
+    }
+
+    /* The item goes in first, the consumer never finds the new one empty. */
+    (void) cfifo_put(&p_segment->fifo, p_item);
+    cfifoi_seg_link(p_seg, p_segment);
+
+    return CFIFO_SUCCESS;
+}
+
+cfifo_ret_t cfifo_seg_write(cfifo_seg_t p_seg,
+                            const void *p_items,
+                            size_t *p_num_items)
+{
+    const uint8_t *p_src = (const uint8_t *) p_items;
+    struct cfifo_segment_s *p_segment;
+    size_t written = 0;
+    size_t num;
+
+    if (NULL == p_seg || NULL == p_items || NULL == p_num_items)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    num = (*p_num_items);
+    (void) cfifo_write(&p_seg->p_tail->fifo, p_src, &num);
+    written += num;
+
+    while (written < (*p_num_items))
+    {
+        p_segment = cfifoi_seg_grow(p_seg);
+        if (NULL == p_segment)
+        {
+            (*p_num_items) = written;
+            return CFIFO_ERR_NO_MEM;
+        }
+
+        num = (*p_num_items) - written;
+        (void) cfifo_write(&p_segment->fifo,
+                           &p_src[written * p_seg->item_size],
+                           &num);
+        written += num;
+        cfifoi_seg_link(p_seg, p_segment);
+    }
+
+    return CFIFO_SUCCESS;
+}
+
+cfifo_ret_t cfifo_seg_get(cfifo_seg_t p_seg,
+                          void *p_item)
+{
+    if (NULL == p_seg || NULL == p_item)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    do
+    {
+        if (CFIFO_SUCCESS == cfifo_get(&p_seg->p_head->fifo, p_item))
+        {
+            return CFIFO_SUCCESS;
+        }
+    } while (cfifoi_seg_advance(p_seg));
+
+    return CFIFO_ERR_EMPTY;
+}
+
+cfifo_ret_t cfifo_seg_read(cfifo_seg_t p_seg,
+                           void *p_items,
+                           size_t *p_num_items)
+{
+    uint8_t *p_dest = (uint8_t *) p_items;
+    size_t done = 0;
+    size_t num;
+
+    if (NULL == p_seg || NULL == p_items || NULL == p_num_items)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    do
+    {
+        num = (*p_num_items) - done;
+        (void) cfifo_read(&p_seg->p_head->fifo,
+                          &p_dest[done * p_seg->item_size],
+                          &num);
+        done += num;
+    } while (done < (*p_num_items) && cfifoi_seg_advance(p_seg));
+
+    (*p_num_items) = done;
+
+    return CFIFO_SUCCESS;
+}
+
+size_t cfifo_seg_size(cfifo_seg_t p_seg)
+{
+    struct cfifo_segment_s *p_segment;
+    size_t size = 0;
+
+    if (NULL == p_seg)
+    {
+        return 0;
+    }
+
+    /* Only the consumer unlinks segments, they stay valid during the walk. */
+    for (p_segment = p_seg->p_head;
+         NULL != p_segment;
+         p_segment = CFIFO_LOAD_ACQUIRE(p_segment->p_next))
+    {
+        size += cfifo_size(&p_segment->fifo);
+    }
+
+    return size;
+}
+
+size_t cfifo_seg_segments(cfifo_seg_t p_seg)
+{
+    size_t unlinked;
+
+    if (NULL == p_seg)
+    {
+        return 0;
+    }
+
+    /* unlinked first, linked only grows meanwhile. */
+    unlinked = CFIFO_LOAD_ACQUIRE(p_seg->unlinked);
+    return CFIFO_LOAD_ACQUIRE(p_seg->linked) - unlinked;
+}
+
+/*======= Local function implementations ====================================*/
+
+static struct cfifo_segment_s *cfifoi_seg_alloc(cfifo_seg_t p_seg)
+{
+    void *p_alloc = malloc(CFIFO_CACHE_LINE_SIZE - 1 + CFIFO_SEG_HDR_SIZE +
+                           CFIFO_SEG_BUF_SIZE);
+    struct cfifo_segment_s *p_segment;
+
+    if (NULL == p_alloc)
+    {
+        return NULL;
+    }
+
+    p_segment = (struct cfifo_segment_s *) (void *)
+                (((uintptr_t) p_alloc + CFIFO_CACHE_LINE_SIZE - 1) &
+                 ~((uintptr_t) CFIFO_CACHE_LINE_SIZE - 1));
+    p_segment->p_alloc = p_alloc;
+    p_segment->p_next = NULL;
+    (void) cfifo_init(&p_segment->fifo,
+                      CFIFO_SEG_BUF(p_segment),
+                      p_seg->seg_items,
+                      p_seg->item_size,
+                      CFIFO_SEG_BUF_SIZE);
+
+    return p_segment;
+}
+
+/*
+ * Producer side, an empty segment from the pool or malloc(). A pooled one
+ * was drained and unlinked by the consumer before it went into the pool,
+ * so it is reset here without racing anyone.
+ */
+static struct cfifo_segment_s *cfifoi_seg_grow(cfifo_seg_t p_seg)
+{
+    struct cfifo_segment_s *p_segment;
+
+    if (NULL == p_seg->pool.p_buf ||
+        CFIFO_SUCCESS != cfifo_get(&p_seg->pool, &p_segment))
+    {
+        return cfifoi_seg_alloc(p_seg);
+    }
+
+    p_segment->p_next = NULL;
+    (void) cfifo_init(&p_segment->fifo,
+                      CFIFO_SEG_BUF(p_segment),
+                      p_seg->seg_items,
+                      p_seg->item_size,
+                      CFIFO_SEG_BUF_SIZE);
+
+    return p_segment;
+}
+
+/*
+ * Link the next segment behind the full tail. The release store comes
+ * after the last item of the old tail, so a consumer that sees the link
+ * also sees all of those items.
+ */
+static void cfifoi_seg_link(cfifo_seg_t p_seg, struct cfifo_segment_s *p_segment)
+{
+    CFIFO_STORE_RELEASE(p_seg->p_tail->p_next, p_segment);
+    p_seg->p_tail = p_segment;
+    CFIFO_STORE_RELAXED(p_seg->linked, p_seg->linked + 1);
+}
+
+/*
+ * Consumer side, called when the head segment looked empty. Returns 0 if
+ * there is nothing more to get, 1 if the caller should retry: either the
+ * head was drained and the next segment took its place, or the head got
+ * its last items in the meantime.
+ */
+static int cfifoi_seg_advance(cfifo_seg_t p_seg)
+{
+    struct cfifo_segment_s *p_head = p_seg->p_head;
+    struct cfifo_segment_s *p_next = CFIFO_LOAD_ACQUIRE(p_head->p_next);
+
+    if (NULL == p_next)
+    {
+        return 0;
+    }
+
+    if (cfifo_size(&p_head->fifo) > 0)
+    {
+        return 1;
+    }
+
+    p_seg->p_head = p_next;
+    CFIFO_STORE_RELAXED(p_seg->unlinked, p_seg->unlinked + 1);
+
+    if (NULL == p_seg->pool.p_buf ||
+        CFIFO_SUCCESS != cfifo_put(&p_seg->pool, &p_head))
+    {
+        free(p_head->p_alloc);
+    }
+
+    return 1;
+}
@@ -0,0 +1,181 @@
+#ifndef _CFIFO_SEG_H_
+#define _CFIFO_SEG_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file cfifo_seg.h
+ *
+ * Unbounded fifo made of a linked list of fixed size cfifo_t segments.
+ *
+ * For bursts far larger than the steady state. The producer puts into the
+ * last segment; when it is full, the producer takes another segment and
+ * links it behind. Items are never copied to grow. The consumer gets from
+ * the first segment, and once that is drained and a next one is linked, it
+ * unlinks it. Up to max_free drained segments are kept in a pool for the
+ * producer to reuse, the rest go back to free(). The queue grows during a
+ * burst and shrinks back to one segment plus the pool afterwards.
+ *
+ * Each segment is a plain cfifo_t with its own positions and handshake.
+ * One producer thread and one consumer thread may use the queue
+ * concurrently. The only new shared state is the link to the next segment,
+ * stored by the producer with release semantics after the last item of the
+ * full segment. The pool is a cfifo_t of segment pointers that the consumer
+ * fills and the producer drains.
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+/* C-Library includes */
+#include <stddef.h> /* for size_t */
+#include <stdint.h> /* for uint8_t */
+
+/* Local includes */
+#include "cfifo.h"
+
+/*======= Type Definitions and declarations =================================*/
+
+typedef struct cfifo_seg_s *cfifo_seg_t;
+
+struct cfifo_segment_s;
+
+/*
+ * The consumer's and the producer's fields each start a cache line of their
+ * own, with or without CFIFO_SEPARATE_CACHE_LINES, apart from the pool.
+ */
+struct cfifo_seg_s {
+    size_t          seg_items;
+    size_t          item_size;
+    /* Drained segments for reuse, pointers, see cfifo_seg_create(). */
+    struct cfifo_s  pool;
+    /* Consumer owned, the segment it gets from. */
+    struct cfifo_segment_s *p_head CFIFO_ALIGNED(CFIFO_CACHE_LINE_SIZE);
+    volatile size_t unlinked;
+    /* Producer owned, the segment it puts into. */
+    struct cfifo_segment_s *p_tail CFIFO_ALIGNED(CFIFO_CACHE_LINE_SIZE);
+    volatile size_t linked;
+};
+
+/*======= Public function declarations ======================================*/
+
+/**
+ * @brief Create an empty segmented fifo with one segment.
+ *
+ * @param   p_seg
+ * @param   seg_items   Capacity of each segment, a power of 2.
+ * @param   item_size
+ * @param   max_free    Drained segments kept for reuse, 0 frees them all.
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_BAD_SIZE
+ * @return  CFIFO_ERR_NO_MEM
+ *
+ */
+cfifo_ret_t cfifo_seg_create(cfifo_seg_t p_seg,
+                             size_t seg_items,
+                             size_t item_size,
+                             size_t max_free);
+
+/**
+ * @brief Free all segments and the pool, the items still stored are lost.
+ *
+ * Neither side may use the fifo meanwhile.
+ *
+ * @param   p_seg
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_INVALID_STATE if not created
+ *
+ */
+cfifo_ret_t cfifo_seg_destroy(cfifo_seg_t p_seg);
+
+/**
+ * @brief Store an item, adding a segment if the last one is full.
+ *
+ * @param   p_seg
+ * @param   p_item
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_NO_MEM if a new segment was needed and malloc() failed
+ *
+ */
+cfifo_ret_t cfifo_seg_put(cfifo_seg_t p_seg,
+                          const void *p_item);
+
+/**
+ * @brief Store num_items items, adding as many segments as needed.
+ *
+ * @param   p_seg
+ * @param   p_items
+ * @param   p_num_items In: items to store. Out: items stored, less than
+ *                      requested only with CFIFO_ERR_NO_MEM.
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_NO_MEM
+ *
+ */
+cfifo_ret_t cfifo_seg_write(cfifo_seg_t p_seg,
+                            const void *p_items,
+                            size_t *p_num_items);
+
+/**
+ * @brief Take the oldest item.
+ *
+ * @param   p_seg
+ * @param   p_item
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_EMPTY
+ *
+ */
+cfifo_ret_t cfifo_seg_get(cfifo_seg_t p_seg,
+                          void *p_item);
+
+/**
+ * @brief Take up to *p_num_items of the oldest items.
+ *
+ * @param   p_seg
+ * @param   p_items
+ * @param   p_num_items In: room in p_items. Out: items taken.
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ *
+ */
+cfifo_ret_t cfifo_seg_read(cfifo_seg_t p_seg,
+                           void *p_items,
+                           size_t *p_num_items);
+
+/**
+ * @brief Number of stored items, consumer side.
+ *
+ * @param   p_seg
+ *
+ * @return  Items in all linked segments, 0 if p_seg is NULL.
+ *
+ */
+size_t cfifo_seg_size(cfifo_seg_t p_seg);
+
+/**
+ * @brief Number of linked segments, from any thread.
+ *
+ * @param   p_seg
+ *
+ * @return  Segments in use, not counting the pool, 0 if p_seg is NULL.
+ *
+ */
+size_t cfifo_seg_segments(cfifo_seg_t p_seg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CFIFO_SEG_H_ */
@@ -0,0 +1,228 @@
+/**
+ * @file cfifo_shm.c
+ *
+ * cfifo_t in POSIX shared memory, see cfifo_shm.h.
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+#define _POSIX_C_SOURCE 200809L
+
+/* C-Library includes */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Local includes */
+#include "cfifo_shm.h"
+#include "cfifo_atomic.h"
+
+#if !CFIFO_HAS_ATOMICS
+#error "cfifo_shm requires the __atomic builtins"
+#endif
+
+/*======= Local Macro Definitions ===========================================*/
+
+/* The buffer starts on its own cache line after the header. */
+#define CFIFO_SHM_BUF_OFFSET                                            \
+        (((sizeof(struct cfifo_shm_hdr_s) + CFIFO_CACHE_LINE_SIZE - 1)  \
+          / CFIFO_CACHE_LINE_SIZE) * CFIFO_CACHE_LINE_SIZE)
+
+#define CFIFO_SHM_HDR(p_cfifo)                                          \
+        ((struct cfifo_shm_hdr_s *) (void *)                            \
+         ((uint8_t *) (p_cfifo) - offsetof(struct cfifo_shm_hdr_s, fifo)))
+
+/*======= Local function prototypes =========================================*/
+
+static int cfifoi_shm_fits(const struct cfifo_shm_hdr_s *p_hdr);
+
+/*======= Global function implementations ===================================*/
+
+cfifo_ret_t cfifo_shm_create(const char *p_name,
+                             size_t num_items,
+                             size_t item_size,
+                             cfifo_t *pp_cfifo)
+{
+    struct cfifo_shm_hdr_s *p_hdr;
+    size_t buf_size = num_items * item_size;
+    size_t map_size = CFIFO_SHM_BUF_OFFSET + buf_size;
+    void *p_map;
+    int fd;
+
+    if (NULL == p_name || NULL == pp_cfifo)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (!CFIFO_IS_CAPACITY(num_items) || 0 == item_size ||
+        buf_size / item_size != num_items || map_size < buf_size)
+    {
+        return CFIFO_ERR_BAD_SIZE;
+    }
+
+    fd = shm_open(p_name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0)
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    if (ftruncate(fd, (off_t) map_size) != 0)
+    {
+        close(fd);
+        shm_unlink(p_name);
+        return CFIFO_ERR_NO_MEM;
+    }
+
+    p_map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == p_map)
+    {
+        shm_unlink(p_name);
+        return CFIFO_ERR_NO_MEM;
+    }
+
+    /* ftruncate() zero filled the segment, so magic reads 0 until below. */
+    p_hdr = (struct cfifo_shm_hdr_s *) p_map;
+    p_hdr->version = CFIFO_SHM_VERSION;
+    p_hdr->hdr_size = (uint32_t) sizeof(struct cfifo_shm_hdr_s);
+    p_hdr->word_size = (uint32_t) sizeof(size_t);
+    p_hdr->map_size = map_size;
+    p_hdr->buf_offset = CFIFO_SHM_BUF_OFFSET;
+    (void) cfifo_init_relative(&p_hdr->fifo,
+                               (uint8_t *) p_map + CFIFO_SHM_BUF_OFFSET,
+                               num_items,
+                               item_size,
+                               buf_size);
+
+    /* Publish the initialized segment to attaching processes. */
+    CFIFO_STORE_RELEASE(p_hdr->magic, CFIFO_SHM_MAGIC);
+
+    *pp_cfifo = &p_hdr->fifo;
+
+    return CFIFO_SUCCESS;
+}
+
+cfifo_ret_t cfifo_shm_attach(const char *p_name,
+                             size_t item_size,
+                             cfifo_t *pp_cfifo)
+{
+    struct cfifo_shm_hdr_s *p_hdr;
+    struct stat st;
+    uint32_t magic;
+    void *p_map;
+    int fd;
+
+    if (NULL == p_name || NULL == pp_cfifo)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    fd = shm_open(p_name, O_RDWR, 0);
+    if (fd < 0)
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    if (fstat(fd, &st) != 0 ||
+        (size_t) st.st_size < sizeof(struct cfifo_shm_hdr_s))
+    {
+        /* Not sized by the creator yet. */
+        close(fd);
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    p_map = mmap(NULL, (size_t) st.st_size, PROT_READ | PROT_WRITE,
+                 MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == p_map)
+    {
+        return CFIFO_ERR_NO_MEM;
+    }
+
+    p_hdr = (struct cfifo_shm_hdr_s *) p_map;
+    magic = CFIFO_LOAD_ACQUIRE(p_hdr->magic);
+    if (0 == magic)
+    {
+        munmap(p_map, (size_t) st.st_size);
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    if (CFIFO_SHM_MAGIC != magic ||
+        CFIFO_SHM_VERSION != p_hdr->version ||
+        sizeof(struct cfifo_shm_hdr_s) != p_hdr->hdr_size ||
+        sizeof(size_t) != p_hdr->word_size ||
+        (size_t) st.st_size != p_hdr->map_size ||
+        CFIFO_SHM_BUF_OFFSET != p_hdr->buf_offset ||
+        item_size != p_hdr->fifo.item_size ||
+        !(p_hdr->fifo.flags & CFIFO_FLAG_RELATIVE) ||
+        !cfifoi_shm_fits(p_hdr))
+    {
+        munmap(p_map, (size_t) st.st_size);
+        return CFIFO_ERR_MISMATCH;
+    }
+
+    *pp_cfifo = &p_hdr->fifo;
+
+    return CFIFO_SUCCESS;
+}
+
+cfifo_ret_t cfifo_shm_detach(cfifo_t p_cfifo)
+{
+    struct cfifo_shm_hdr_s *p_hdr;
+
+    if (NULL == p_cfifo)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    p_hdr = CFIFO_SHM_HDR(p_cfifo);
+    munmap(p_hdr, p_hdr->map_size);
+
+    return CFIFO_SUCCESS;
+}
+
+cfifo_ret_t cfifo_shm_unlink(const char *p_name)
+{
+    if (NULL == p_name)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    return (shm_unlink(p_name) == 0) ? CFIFO_SUCCESS : CFIFO_ERR_INVALID_STATE;
+}
+
+/*======= Local function implementations ====================================*/
+
+/*
+ * Whether the fifo in a segment with a matching stamp stays inside the
+ * mapping, so a stale or corrupt header cannot make the attacher index past
+ * its end. Called after map_size, buf_offset and item_size are checked.
+ */
+static int cfifoi_shm_fits(const struct cfifo_shm_hdr_s *p_hdr)
+{
+    const struct cfifo_s *p_fifo = &p_hdr->fifo;
+    size_t capacity = p_fifo->num_items_mask + 1;
+
+    if (0 == p_fifo->item_size ||
+        p_hdr->map_size < p_hdr->buf_offset ||
+        p_fifo->num_items_mask >= (p_hdr->map_size - p_hdr->buf_offset) /
+                                  p_fifo->item_size)
+    {
+        return 0;
+    }
+
+    if (0 != p_fifo->pos_wrap && 2 * capacity != p_fifo->pos_wrap)
+    {
+        return 0;
+    }
+
+    /* p_buf is the offset of the buffer from the fifo. */
+    return (uintptr_t) p_fifo->p_buf ==
+           p_hdr->buf_offset - offsetof(struct cfifo_shm_hdr_s, fifo);
+}
@@ -0,0 +1,131 @@
+#ifndef _CFIFO_SHM_H_
+#define _CFIFO_SHM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file cfifo_shm.h
+ *
+ * cfifo_t in POSIX shared memory, for passing items between processes.
+ *
+ * The segment holds a small header, the struct cfifo_s and the buffer. The
+ * fifo is initialized with cfifo_init_relative(), so it does not matter at
+ * which address each process maps the segment, and the pointer returned by
+ * cfifo_shm_create()/cfifo_shm_attach() works with the regular cfifo API.
+ * One process may be the producer and one the consumer, with the same
+ * ordering guarantees as between threads: the position handshake uses
+ * lock-free atomics, which work on memory shared between processes.
+ * cfifo_put_wait()/cfifo_get_wait() work across processes as well, the
+ * eventfd notifier does not.
+ *
+ * The header carries a magic number, a layout version and the sizes the
+ * creator was built with. cfifo_shm_attach() refuses segments created with
+ * a different layout, e.g. another library version, word size or
+ * CFIFO_SEPARATE_CACHE_LINES setting.
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+/* C-Library includes */
+#include <stddef.h> /* for size_t */
+#include <stdint.h> /* for uint32_t */
+
+/* Local includes */
+#include "cfifo.h"
+
+/*======= Public macro definitions ==========================================*/
+
+#define CFIFO_SHM_MAGIC     0x43465348u /* "CFSH" */
+
+/* Bump when struct cfifo_shm_hdr_s or struct cfifo_s changes meaning. */
+#define CFIFO_SHM_VERSION   3u
+
+/*======= Type Definitions and declarations =================================*/
+
+/* Start of the shared memory segment, the buffer follows at buf_offset. */
+struct cfifo_shm_hdr_s {
+    /* Written last by the creator, 0 until the segment is ready. */
+    volatile uint32_t   magic;
+    uint32_t            version;
+    uint32_t            hdr_size;
+    uint32_t            word_size;
+    size_t              map_size;
+    size_t              buf_offset;
+    struct cfifo_s      fifo CFIFO_ALIGNED(CFIFO_CACHE_LINE_SIZE);
+};
+
+/*======= Public function declarations ======================================*/
+
+/**
+ * @brief Create a shared memory fifo and map it.
+ *
+ * Fails if a segment with the same name exists already.
+ *
+ * @param   p_name      shm_open() name, e.g. "/capture"
+ * @param   num_items   Capacity, a power of 2 is the fastest.
+ * @param   item_size
+ * @param   pp_cfifo    Set to the fifo inside the mapping.
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_BAD_SIZE
+ * @return  CFIFO_ERR_INVALID_STATE if the segment could not be created
+ * @return  CFIFO_ERR_NO_MEM
+ *
+ */
+cfifo_ret_t cfifo_shm_create(const char *p_name,
+                             size_t num_items,
+                             size_t item_size,
+                             cfifo_t *pp_cfifo);
+
+/**
+ * @brief Map a shared memory fifo created by another process.
+ *
+ * @param   p_name
+ * @param   item_size   Expected item size.
+ * @param   pp_cfifo    Set to the fifo inside the mapping.
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_INVALID_STATE if the segment does not exist or is not
+ *          completely set up yet
+ * @return  CFIFO_ERR_MISMATCH if the segment has a different layout or
+ *          item size
+ * @return  CFIFO_ERR_NO_MEM
+ *
+ */
+cfifo_ret_t cfifo_shm_attach(const char *p_name,
+                             size_t item_size,
+                             cfifo_t *pp_cfifo);
+
+/**
+ * @brief Unmap a fifo from cfifo_shm_create() or cfifo_shm_attach().
+ *
+ * @param   p_cfifo
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ *
+ */
+cfifo_ret_t cfifo_shm_detach(cfifo_t p_cfifo);
+
+/**
+ * @brief Remove the segment name, existing mappings stay valid.
+ *
+ * @param   p_name
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_INVALID_STATE if there is no such segment
+ *
+ */
+cfifo_ret_t cfifo_shm_unlink(const char *p_name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CFIFO_SHM_H_ */
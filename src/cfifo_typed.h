@@ -0,0 +1,178 @@
+#ifndef _CFIFO_TYPED_H_
+#define _CFIFO_TYPED_H_
+
+/**
+ * @file cfifo_typed.h
+ *
+ * Header-only fifos specialized for one item type and capacity.
+ *
+ * CFIFO_DECLARE_TYPED(name, type, capacity) declares the type name_t and
+ * static inline functions operating on it:
+ *
+ *   void        name_init(name_t *p_fifo);
+ *   cfifo_ret_t name_put(name_t *p_fifo, const type *p_item);
+ *   cfifo_ret_t name_get(name_t *p_fifo, type *p_item);
+ *   cfifo_ret_t name_peek(name_t *p_fifo, type *p_item);
+ *   cfifo_ret_t name_write(name_t *p_fifo, const type *p_items,
+ *                          size_t *p_num_items);
+ *   cfifo_ret_t name_read(name_t *p_fifo, type *p_items,
+ *                         size_t *p_num_items);
+ *   size_t      name_size(name_t *p_fifo);
+ *   size_t      name_available(name_t *p_fifo);
+ *
+ * Since the item type and the capacity are compile time constants, items are
+ * moved with plain assignments and slots are indexed with a constant mask
+ * instead of the memcpy and multiply of the generic cfifo. The functions
+ * follow the same semantics, return codes and single-producer/single-consumer
+ * rules as their cfifo_* counterparts, but do not check for NULL pointers.
+ *
+ * The capacity must be a power of 2, otherwise the declaration does not
+ * compile. A name_t can also be initialized statically with
+ * CFIFO_TYPED_INIT.
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+/* Local includes */
+#include "cfifo.h"
+#include "cfifo_atomic.h"
+
+/*======= Public macro definitions ==========================================*/
+
+#define CFIFO_TYPED_INIT    { { 0 }, 0, 0, 0, 0 }
+
+#define CFIFO_DECLARE_TYPED(name, type, capacity)                           \
+    typedef struct name##_s {                                               \
+        type            buf[capacity];                                      \
+        volatile size_t read_pos CFIFO_CACHE_ALIGNED;                       \
+        size_t          write_pos_cache;                                    \
+        volatile size_t write_pos CFIFO_CACHE_ALIGNED;                      \
+        size_t          read_pos_cache;                                     \
+    } name##_t;                                                             \
+                                                                            \
+    CFIFO_STATIC_INLINE void name##_init(name##_t *p_fifo)                  \
+    {                                                                       \
+        p_fifo->read_pos = 0;                                               \
+        p_fifo->write_pos_cache = 0;                                        \
+        p_fifo->write_pos = 0;                                              \
+        p_fifo->read_pos_cache = 0;                                         \
+    }                                                                       \
+                                                                            \
+    CFIFO_STATIC_INLINE size_t name##_write_available(name##_t *p_fifo,     \
+                                                      size_t num_items)     \
+    {                                                                       \
+        size_t write_pos = CFIFO_LOAD_RELAXED(p_fifo->write_pos);           \
+        size_t used = write_pos - p_fifo->read_pos_cache;                   \
+        if (used > (capacity) || (capacity) - used < num_items)             \
+        {                                                                   \
+            p_fifo->read_pos_cache = CFIFO_LOAD_ACQUIRE(p_fifo->read_pos);  \
+            used = write_pos - p_fifo->read_pos_cache;                      \
+        }                                                                   \
+        return (capacity) - used;                                           \
+    }                                                                       \
+                                                                            \
+    CFIFO_STATIC_INLINE size_t name##_read_size(name##_t *p_fifo,           \
+                                                size_t num_items)           \
+    {                                                                       \
+        size_t read_pos = CFIFO_LOAD_RELAXED(p_fifo->read_pos);             \
+        size_t size = p_fifo->write_pos_cache - read_pos;                   \
+        if (size > (capacity) || size < num_items)                          \
+        {                                                                   \
+            p_fifo->write_pos_cache = CFIFO_LOAD_ACQUIRE(p_fifo->write_pos);\
+            size = p_fifo->write_pos_cache - read_pos;                      \
+        }                                                                   \
+        return size;                                                        \
+    }                                                                       \
+                                                                            \
+    CFIFO_STATIC_INLINE cfifo_ret_t name##_put(name##_t *p_fifo,            \
+                                               const type *p_item)          \
+    {                                                                       \
+        size_t write_pos = CFIFO_LOAD_RELAXED(p_fifo->write_pos);           \
+        if (name##_write_available(p_fifo, 1) == 0)                         \
+        {                                                                   \
+            return CFIFO_ERR_FULL;                                          \
+        }                                                                   \
+        p_fifo->buf[write_pos & ((capacity) - 1)] = *p_item;                \
+        CFIFO_STORE_RELEASE(p_fifo->write_pos, write_pos + 1);              \
+        return CFIFO_SUCCESS;                                               \
+    }                                                                       \
+                                                                            \
+    CFIFO_STATIC_INLINE cfifo_ret_t name##_get(name##_t *p_fifo,            \
+                                               type *p_item)                \
+    {                                                                       \
+        size_t read_pos = CFIFO_LOAD_RELAXED(p_fifo->read_pos);             \
+        if (name##_read_size(p_fifo, 1) == 0)                               \
+        {                                                                   \
+            return CFIFO_ERR_EMPTY;                                         \
+        }                                                                   \
+        *p_item = p_fifo->buf[read_pos & ((capacity) - 1)];                 \
+        CFIFO_STORE_RELEASE(p_fifo->read_pos, read_pos + 1);                \
+        return CFIFO_SUCCESS;                                               \
+    }                                                                       \
+                                                                            \
+    CFIFO_STATIC_INLINE cfifo_ret_t name##_peek(name##_t *p_fifo,           \
+                                                type *p_item)               \
+    {                                                                       \
+        size_t read_pos = CFIFO_LOAD_RELAXED(p_fifo->read_pos);             \
+        if (name##_read_size(p_fifo, 1) == 0)                               \
+        {                                                                   \
+            return CFIFO_ERR_EMPTY;                                         \
+        }                                                                   \
+        *p_item = p_fifo->buf[read_pos & ((capacity) - 1)];                 \
+        return CFIFO_SUCCESS;                                               \
+    }                                                                       \
+                                                                            \
+    CFIFO_STATIC_INLINE cfifo_ret_t name##_write(name##_t *p_fifo,          \
+                                                 const type *p_items,       \
+                                                 size_t *p_num_items)       \
+    {                                                                       \
+        size_t write_pos = CFIFO_LOAD_RELAXED(p_fifo->write_pos);           \
+        size_t available = name##_write_available(p_fifo, *p_num_items);    \
+        size_t i;                                                           \
+        if (*p_num_items > available)                                       \
+        {                                                                   \
+            *p_num_items = available;                                       \
+        }                                                                   \
+        for (i = 0; i < *p_num_items; i++)                                  \
+        {                                                                   \
+            p_fifo->buf[(write_pos + i) & ((capacity) - 1)] = p_items[i];   \
+        }                                                                   \
+        CFIFO_STORE_RELEASE(p_fifo->write_pos, write_pos + *p_num_items);   \
+        return CFIFO_SUCCESS;                                               \
+    }                                                                       \
+                                                                            \
+    CFIFO_STATIC_INLINE cfifo_ret_t name##_read(name##_t *p_fifo,           \
+                                                type *p_items,              \
+                                                size_t *p_num_items)        \
+    {                                                                       \
+        size_t read_pos = CFIFO_LOAD_RELAXED(p_fifo->read_pos);             \
+        size_t size = name##_read_size(p_fifo, *p_num_items);               \
+        size_t i;                                                           \
+        if (*p_num_items > size)                                            \
+        {                                                                   \
+            *p_num_items = size;                                            \
+        }                                                                   \
+        for (i = 0; i < *p_num_items; i++)                                  \
+        {                                                                   \
+            p_items[i] = p_fifo->buf[(read_pos + i) & ((capacity) - 1)];    \
+        }                                                                   \
+        CFIFO_STORE_RELEASE(p_fifo->read_pos, read_pos + *p_num_items);     \
+        return CFIFO_SUCCESS;                                               \
+    }                                                                       \
+                                                                            \
+    CFIFO_STATIC_INLINE size_t name##_size(name##_t *p_fifo)                \
+    {                                                                       \
+        size_t tmp = CFIFO_LOAD_ACQUIRE(p_fifo->read_pos);                  \
+        return CFIFO_LOAD_ACQUIRE(p_fifo->write_pos) - tmp;                 \
+    }                                                                       \
+                                                                            \
+    CFIFO_STATIC_INLINE size_t name##_available(name##_t *p_fifo)           \
+    {                                                                       \
+        return (capacity) - name##_size(p_fifo);                            \
+    }                                                                       \
+                                                                            \
+    typedef char name##_capacity_must_be_pow_2                              \
+            [CFIFO_IS_POW_2(capacity) ? 1 : -1]
+
+#endif /* _CFIFO_TYPED_H_ */
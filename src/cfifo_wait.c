@@ -0,0 +1,268 @@
+/**
+ * @file cfifo_wait.c
+ *
+ * Blocking and timed put/get, see cfifo_wait.h.
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+#if defined(__linux__)
+#define _GNU_SOURCE
+#else
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+/* C-Library includes */
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <sched.h>
+#endif
+
+/* Local includes */
+#include "cfifo_wait.h"
+#include "cfifo_atomic.h"
+#include "cfifo_pos.h"
+
+#if !CFIFO_HAS_ATOMICS
+#error "cfifo_wait requires the __atomic builtins"
+#endif
+
+/*======= Local Macro Definitions ===========================================*/
+
+/*
+ * The futex word is the low half of a position, the part that changes on
+ * every put or get. Positions are compared with (uint32_t) casts, which is
+ * exact as long as the other side does not move by a multiple of 2^32 items
+ * between the check and going to sleep.
+ */
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define CFIFO_FUTEX_WORD(p_pos) \
+        ((volatile uint32_t *) (p_pos) + (sizeof(size_t) / sizeof(uint32_t) - 1))
+#else
+#define CFIFO_FUTEX_WORD(p_pos) ((volatile uint32_t *) (p_pos))
+#endif
+
+/*======= Local function prototypes =========================================*/
+
+static cfifo_ret_t cfifoi_sleep(volatile size_t *p_pos,
+                                size_t pos,
+                                volatile unsigned int *p_waiters,
+                                const struct timespec *p_deadline);
+static int cfifoi_has_space(cfifo_t p_cfifo);
+static int cfifoi_has_items(cfifo_t p_cfifo);
+
+/*======= Global function implementations ===================================*/
+
+cfifo_ret_t cfifo_enable_wait(cfifo_t p_cfifo)
+{
+    if (NULL == p_cfifo)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    p_cfifo->put_waiters = 0;
+    p_cfifo->get_waiters = 0;
+    p_cfifo->flags |= CFIFO_FLAG_WAIT;
+
+    return CFIFO_SUCCESS;
+}
+
+cfifo_ret_t cfifo_put_wait(cfifo_t p_cfifo,
+                           const void * const p_item,
+                           const struct timespec *p_deadline)
+{
+    cfifo_ret_t ret;
+    size_t read_pos;
+    unsigned int spins;
+
+    if (NULL == p_cfifo || NULL == p_item)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (!(p_cfifo->flags & CFIFO_FLAG_WAIT))
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    /*
+     * One cfifo_put() up front and one once there is space, so a blocked
+     * call counts as a single full reject with CFIFO_STATS.
+     */
+    ret = cfifo_put(p_cfifo, p_item);
+    if (CFIFO_ERR_FULL != ret)
+    {
+        return ret;
+    }
+
+    for (;;)
+    {
+        for (spins = 0; spins < CFIFO_WAIT_SPINS; spins++)
+        {
+            if (cfifoi_has_space(p_cfifo))
+            {
+                return cfifo_put(p_cfifo, p_item);
+            }
+            CFIFO_CPU_RELAX();
+        }
+
+        /* Full means read_pos is a whole lap behind write_pos. */
+        read_pos = cfifo_pos_sub(p_cfifo,
+                                 CFIFO_LOAD_RELAXED(p_cfifo->write_pos),
+                                 p_cfifo->num_items_mask + 1);
+        if (CFIFO_ERR_TIMEOUT == cfifoi_sleep(&p_cfifo->read_pos,
+                                              read_pos,
+                                              &p_cfifo->put_waiters,
+                                              p_deadline))
+        {
+            return cfifoi_has_space(p_cfifo) ?
+                   cfifo_put(p_cfifo, p_item) : CFIFO_ERR_TIMEOUT;
+        }
+    }
+}
+
+cfifo_ret_t cfifo_get_wait(cfifo_t p_cfifo,
+                           void *p_item,
+                           const struct timespec *p_deadline)
+{
+    cfifo_ret_t ret;
+    unsigned int spins;
+
+    if (NULL == p_cfifo || NULL == p_item)
+    {
+        /* Error, null pointers. */
+        return CFIFO_ERR_NULL;
+    }
+
+    if (!(p_cfifo->flags & CFIFO_FLAG_WAIT))
+    {
+        return CFIFO_ERR_INVALID_STATE;
+    }
+
+    /* As in cfifo_put_wait(), a blocked call is a single empty reject. */
+    ret = cfifo_get(p_cfifo, p_item);
+    if (CFIFO_ERR_EMPTY != ret)
+    {
+        return ret;
+    }
+
+    for (;;)
+    {
+        for (spins = 0; spins < CFIFO_WAIT_SPINS; spins++)
+        {
+            if (cfifoi_has_items(p_cfifo))
+            {
+                return cfifo_get(p_cfifo, p_item);
+            }
+            CFIFO_CPU_RELAX();
+        }
+
+        /* Empty means write_pos equals read_pos. */
+        if (CFIFO_ERR_TIMEOUT == cfifoi_sleep(&p_cfifo->write_pos,
+                                              CFIFO_LOAD_RELAXED(p_cfifo->read_pos),
+                                              &p_cfifo->get_waiters,
+                                              p_deadline))
+        {
+            return cfifoi_has_items(p_cfifo) ?
+                   cfifo_get(p_cfifo, p_item) : CFIFO_ERR_TIMEOUT;
+        }
+    }
+}
+
+/*
+ * The waker stores the position, then checks the waiter count. The sleeper
+ * registers in the waiter count, then checks the position. All four
+ * accesses are sequentially consistent, so at least one side sees the
+ * other's store and a wakeup can not get lost. The futex call itself
+ * rechecks the position atomically against the kernel's wake queue.
+ */
+void cfifo_wait_wake(volatile size_t *p_pos,
+                     volatile unsigned int *p_waiters)
+{
+    if (0 != CFIFO_LOAD_SEQ_CST(*p_waiters))
+    {
+#if defined(__linux__)
+        (void) syscall(SYS_futex, CFIFO_FUTEX_WORD(p_pos),
+                       FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#else
+        (void) p_pos;
+#endif
+    }
+}
+
+/*======= Local function implementations ====================================*/
+
+/*
+ * Sleep while *p_pos still equals pos, until woken or the deadline passes.
+ * Returns CFIFO_ERR_TIMEOUT at the deadline and CFIFO_SUCCESS otherwise,
+ * including spurious wakeups; the caller retries in that case.
+ */
+static cfifo_ret_t cfifoi_sleep(volatile size_t *p_pos,
+                                size_t pos,
+                                volatile unsigned int *p_waiters,
+                                const struct timespec *p_deadline)
+{
+    cfifo_ret_t ret = CFIFO_SUCCESS;
+
+    (void) CFIFO_FETCH_ADD(*p_waiters, 1);
+
+    if (CFIFO_LOAD_SEQ_CST(*p_pos) == pos)
+    {
+#if defined(__linux__)
+        /* FUTEX_WAIT_BITSET takes an absolute CLOCK_MONOTONIC timeout. Not
+         * the private variant, so fifos in shared memory work too. */
+        if (0 != syscall(SYS_futex, CFIFO_FUTEX_WORD(p_pos),
+                         FUTEX_WAIT_BITSET, (uint32_t) pos, p_deadline,
+                         NULL, FUTEX_BITSET_MATCH_ANY) &&
+            ETIMEDOUT == errno)
+        {
+            ret = CFIFO_ERR_TIMEOUT;
+        }
+#else
+        struct timespec now;
+
+        sched_yield();
+        if (NULL != p_deadline &&
+            0 == clock_gettime(CLOCK_MONOTONIC, &now) &&
+            (now.tv_sec > p_deadline->tv_sec ||
+             (now.tv_sec == p_deadline->tv_sec &&
+              now.tv_nsec >= p_deadline->tv_nsec)))
+        {
+            ret = CFIFO_ERR_TIMEOUT;
+        }
+#endif
+    }
+
+    (void) CFIFO_FETCH_ADD(*p_waiters, (unsigned int) -1);
+
+    return ret;
+}
+
+/*
+ * Whether the next put or get would succeed, without going through
+ * cfifo_put() or cfifo_get() and their statistics. Only the calling side
+ * can take the space or the items away, so the answer stays true.
+ */
+static int cfifoi_has_space(cfifo_t p_cfifo)
+{
+    return cfifo_pos_diff(p_cfifo,
+                          CFIFO_LOAD_RELAXED(p_cfifo->write_pos),
+                          CFIFO_LOAD_ACQUIRE(p_cfifo->read_pos)) <
+           p_cfifo->num_items_mask + 1;
+}
+
+static int cfifoi_has_items(cfifo_t p_cfifo)
+{
+    return CFIFO_LOAD_ACQUIRE(p_cfifo->write_pos) !=
+           CFIFO_LOAD_RELAXED(p_cfifo->read_pos);
+}
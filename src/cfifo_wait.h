@@ -0,0 +1,110 @@
+#ifndef _CFIFO_WAIT_H_
+#define _CFIFO_WAIT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file cfifo_wait.h
+ *
+ * Blocking and timed put/get for cfifo_t.
+ *
+ * A waiting thread first spins for a short while, retrying the operation
+ * with a CPU pause hint in between, and then sleeps on a Linux futex on the
+ * low 32 bits of the position the other side moves. The other side only
+ * makes the wake syscall when a sleeper has registered itself, so puts and
+ * gets that do not block never enter the kernel.
+ *
+ * Waiting must be enabled with cfifo_enable_wait() before the fifo is shared
+ * between threads. Without it the regular put/get functions skip the wake
+ * check entirely. The non-blocking API keeps working on a fifo with waiting
+ * enabled and wakes sleepers as well.
+ *
+ * Other platforms fall back to yielding the CPU instead of sleeping.
+ *
+ */
+
+/*======= Includes ==========================================================*/
+
+/* C-Library includes */
+#include <stddef.h> /* for size_t */
+
+/* Local includes */
+#include "cfifo.h"
+
+/*======= Public macro definitions ==========================================*/
+
+/* Number of retries with a CPU pause hint before going to sleep. */
+#ifndef CFIFO_WAIT_SPINS
+#define CFIFO_WAIT_SPINS    100
+#endif
+
+/*======= Type Definitions and declarations =================================*/
+
+struct timespec;
+
+/*======= Public function declarations ======================================*/
+
+/**
+ * @brief Enable cfifo_put_wait() and cfifo_get_wait() on a fifo.
+ *
+ * Must be called after cfifo_init() and before the fifo is used from more
+ * than one thread.
+ *
+ * @param   p_cfifo
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ *
+ */
+cfifo_ret_t cfifo_enable_wait(cfifo_t p_cfifo);
+
+/**
+ * @brief Put one item, wait for a free slot if the fifo is full.
+ *
+ * @param   p_cfifo
+ * @param   p_item
+ * @param   p_deadline  Absolute CLOCK_MONOTONIC time to give up at, or NULL
+ *                      to wait forever.
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_INVALID_STATE if waiting is not enabled
+ * @return  CFIFO_ERR_TIMEOUT if the fifo was still full at the deadline
+ *
+ */
+cfifo_ret_t cfifo_put_wait(cfifo_t p_cfifo,
+                           const void * const p_item,
+                           const struct timespec *p_deadline);
+
+/**
+ * @brief Get one item, wait for one if the fifo is empty.
+ *
+ * @param   p_cfifo
+ * @param   p_item
+ * @param   p_deadline  Absolute CLOCK_MONOTONIC time to give up at, or NULL
+ *                      to wait forever.
+ *
+ * @return  CFIFO_SUCCESS
+ * @return  CFIFO_ERR_NULL
+ * @return  CFIFO_ERR_INVALID_STATE if waiting is not enabled
+ * @return  CFIFO_ERR_TIMEOUT if the fifo was still empty at the deadline
+ *
+ */
+cfifo_ret_t cfifo_get_wait(cfifo_t p_cfifo,
+                           void *p_item,
+                           const struct timespec *p_deadline);
+
+/*
+ * Used by cfifo.c after storing a new position in *p_pos with a seq_cst
+ * store: wakes the threads sleeping on it if *p_waiters shows there are any.
+ */
+void cfifo_wait_wake(volatile size_t *p_pos,
+                     volatile unsigned int *p_waiters);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CFIFO_WAIT_H_ */
@@ -0,0 +1,260 @@
+#include <stdio.h>
+#include <assert.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "cfifo_bcast.h"
+
+#define NUM_ITEMS   200000
+#define NUM_READERS 4
+#define CAPACITY    256
+
+static struct cfifo_bcast_s shared;
+static uint32_t shared_buf[CAPACITY];
+static int producer_done;
+
+static void api_test(void)
+{
+    struct cfifo_bcast_s bcast;
+    cfifo_bcast_reader_t p_readers[CFIFO_BCAST_MAX_READERS];
+    cfifo_bcast_reader_t p_r1;
+    cfifo_bcast_reader_t p_r2;
+    uint32_t buf[8];
+    uint32_t items[20];
+    uint32_t out[20];
+    uint32_t item;
+    size_t num;
+    uint32_t i;
+
+    assert(cfifo_bcast_init(NULL, (uint8_t *) buf, 8, 4, sizeof(buf)) == CFIFO_ERR_NULL);
+    assert(cfifo_bcast_init(&bcast, (uint8_t *) buf, 6, 4, 24) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_bcast_init(&bcast, (uint8_t *) buf, 8, 4, 16) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_bcast_init(&bcast, (uint8_t *) buf, 8, 4, sizeof(buf)) == CFIFO_SUCCESS);
+    for (i = 0; i < 20; i++)
+    {
+        items[i] = i;
+    }
+
+    /* Nobody listens, nothing is ever full. */
+    for (i = 0; i < 20; i++)
+    {
+        assert(cfifo_bcast_put(&bcast, &items[i]) == CFIFO_SUCCESS);
+    }
+
+    /* A reader starts with the first put after it attached. */
+    assert(cfifo_bcast_attach(&bcast, &p_r1) == CFIFO_SUCCESS);
+    assert(cfifo_bcast_get(&bcast, p_r1, &item) == CFIFO_ERR_EMPTY);
+    for (i = 0; i < 8; i++)
+    {
+        assert(cfifo_bcast_put(&bcast, &items[i]) == CFIFO_SUCCESS);
+    }
+    assert(cfifo_bcast_put(&bcast, &items[8]) == CFIFO_ERR_FULL);
+    assert(cfifo_bcast_size(&bcast, p_r1) == 8);
+
+    /* The second one joins at the write position. */
+    assert(cfifo_bcast_attach(&bcast, &p_r2) == CFIFO_SUCCESS);
+    assert(cfifo_bcast_put(&bcast, &items[8]) == CFIFO_ERR_FULL);
+    assert(cfifo_bcast_size(&bcast, p_r2) == 0);
+
+    num = 3;
+    assert(cfifo_bcast_read(&bcast, p_r1, out, &num) == CFIFO_SUCCESS);
+    assert(num == 3 && out[0] == 0 && out[2] == 2);
+    num = 5;
+    assert(cfifo_bcast_write(&bcast, &items[8], &num) == CFIFO_SUCCESS);
+    assert(num == 3);
+    assert(cfifo_bcast_size(&bcast, p_r2) == 3);
+
+    /* Both readers see the same items, across the end of the buffer. */
+    for (i = 3; i < 11; i++)
+    {
+        assert(cfifo_bcast_get(&bcast, p_r1, &item) == CFIFO_SUCCESS);
+        assert(item == i);
+    }
+    assert(cfifo_bcast_get(&bcast, p_r1, &item) == CFIFO_ERR_EMPTY);
+    num = 20;
+    assert(cfifo_bcast_read(&bcast, p_r2, out, &num) == CFIFO_SUCCESS);
+    assert(num == 3 && out[0] == 8 && out[2] == 10);
+
+    /* The slowest attached reader bounds the producer, detached ones don't. */
+    num = 6;
+    assert(cfifo_bcast_write(&bcast, items, &num) == CFIFO_SUCCESS);
+    assert(num == 6);
+    num = 6;
+    assert(cfifo_bcast_read(&bcast, p_r2, out, &num) == CFIFO_SUCCESS);
+    num = 20;
+    assert(cfifo_bcast_write(&bcast, items, &num) == CFIFO_SUCCESS);
+    assert(num == 2);
+    assert(cfifo_bcast_detach(&bcast, p_r1) == CFIFO_SUCCESS);
+    assert(cfifo_bcast_detach(&bcast, p_r1) == CFIFO_ERR_INVALID_STATE);
+    assert(cfifo_bcast_size(&bcast, p_r1) == 0);
+    num = 20;
+    assert(cfifo_bcast_write(&bcast, items, &num) == CFIFO_SUCCESS);
+    assert(num == 6);
+    assert(cfifo_bcast_size(&bcast, p_r2) == 8);
+    assert(cfifo_bcast_detach(&bcast, p_r2) == CFIFO_SUCCESS);
+
+    /* Reader slots are reused. */
+    for (i = 0; i < CFIFO_BCAST_MAX_READERS; i++)
+    {
+        assert(cfifo_bcast_attach(&bcast, &p_readers[i]) == CFIFO_SUCCESS);
+    }
+    assert(cfifo_bcast_attach(&bcast, &p_r1) == CFIFO_ERR_FULL);
+    assert(cfifo_bcast_detach(&bcast, p_readers[3]) == CFIFO_SUCCESS);
+    assert(cfifo_bcast_attach(&bcast, &p_r1) == CFIFO_SUCCESS);
+    assert(p_r1 == p_readers[3]);
+
+    assert(cfifo_bcast_attach(NULL, &p_r1) == CFIFO_ERR_NULL);
+    assert(cfifo_bcast_get(&bcast, NULL, &item) == CFIFO_ERR_NULL);
+    assert(cfifo_bcast_put(&bcast, NULL) == CFIFO_ERR_NULL);
+    assert(cfifo_bcast_size(NULL, p_r1) == 0);
+}
+
+static void *producer(void *p_arg)
+{
+    uint32_t batch[16];
+    uint32_t i = 0;
+    size_t num;
+    size_t j;
+
+    (void) p_arg;
+    while (i < NUM_ITEMS)
+    {
+        if (i % 3 == 0)
+        {
+            if (cfifo_bcast_put(&shared, &i) == CFIFO_SUCCESS)
+            {
+                i++;
+            }
+            else
+            {
+                sched_yield();
+            }
+        }
+        else
+        {
+            for (j = 0; j < 16; j++)
+            {
+                batch[j] = i + (uint32_t) j;
+            }
+            num = 16;
+            assert(cfifo_bcast_write(&shared, batch, &num) == CFIFO_SUCCESS);
+            i += (uint32_t) num;
+            if (0 == num)
+            {
+                sched_yield();
+            }
+        }
+    }
+    __atomic_store_n(&producer_done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+/* Attached before the producer started, gets every item. */
+static void *reader(void *p_arg)
+{
+    cfifo_bcast_reader_t p_reader = (cfifo_bcast_reader_t) p_arg;
+    uint32_t out[7];
+    uint32_t expected = 0;
+    size_t num;
+    size_t j;
+
+    while (expected < NUM_ITEMS)
+    {
+        if (expected % 2)
+        {
+            if (cfifo_bcast_get(&shared, p_reader, &out[0]) == CFIFO_SUCCESS)
+            {
+                assert(out[0] == expected);
+                expected++;
+            }
+            else
+            {
+                sched_yield();
+            }
+        }
+        else
+        {
+            num = 7;
+            assert(cfifo_bcast_read(&shared, p_reader, out, &num) == CFIFO_SUCCESS);
+            for (j = 0; j < num; j++)
+            {
+                assert(out[j] == expected);
+                expected++;
+            }
+            if (0 == num)
+            {
+                sched_yield();
+            }
+        }
+    }
+    assert(cfifo_bcast_detach(&shared, p_reader) == CFIFO_SUCCESS);
+    return NULL;
+}
+
+/* Attaches and detaches while the stream is running. */
+static void *late_reader(void *p_arg)
+{
+    cfifo_bcast_reader_t p_reader;
+    uint32_t item;
+    uint32_t last;
+    int have_last;
+    int got;
+
+    (void) p_arg;
+    while (!__atomic_load_n(&producer_done, __ATOMIC_ACQUIRE))
+    {
+        assert(cfifo_bcast_attach(&shared, &p_reader) == CFIFO_SUCCESS);
+        have_last = 0;
+        got = 0;
+        while (got < 100 && !__atomic_load_n(&producer_done, __ATOMIC_ACQUIRE))
+        {
+            if (cfifo_bcast_get(&shared, p_reader, &item) == CFIFO_SUCCESS)
+            {
+                /* No gaps from wherever it joined. */
+                assert(!have_last || item == last + 1);
+                last = item;
+                have_last = 1;
+                got++;
+            }
+            else
+            {
+                sched_yield();
+            }
+        }
+        assert(cfifo_bcast_detach(&shared, p_reader) == CFIFO_SUCCESS);
+    }
+    return NULL;
+}
+
+static void concurrent_test(void)
+{
+    cfifo_bcast_reader_t p_readers[NUM_READERS];
+    pthread_t threads[NUM_READERS + 2];
+    int i;
+
+    assert(cfifo_bcast_init(&shared, (uint8_t *) shared_buf, CAPACITY,
+                            sizeof(uint32_t), sizeof(shared_buf)) == CFIFO_SUCCESS);
+    for (i = 0; i < NUM_READERS; i++)
+    {
+        assert(cfifo_bcast_attach(&shared, &p_readers[i]) == CFIFO_SUCCESS);
+        assert(pthread_create(&threads[i], NULL, reader, p_readers[i]) == 0);
+    }
+    assert(pthread_create(&threads[NUM_READERS], NULL, late_reader, NULL) == 0);
+    assert(pthread_create(&threads[NUM_READERS + 1], NULL, producer, NULL) == 0);
+
+    for (i = 0; i < NUM_READERS + 2; i++)
+    {
+        assert(pthread_join(threads[i], NULL) == 0);
+    }
+}
+
+int main(void)
+{
+    api_test();
+    concurrent_test();
+
+    printf("Tests passed!\n");
+
+    return 0;
+}
@@ -1,13 +1,23 @@
 #include "cfifo.h"
+#include "cfifo_typed.h"
 
 CFIFO_CREATE(test_non_static, uint8_t, 8);
 CFIFO_CREATE_STATIC(test_static, uint8_t, 8);
 
+CFIFO_DECLARE_TYPED(u16_fifo, uint16_t, 8);
+static u16_fifo_t test_typed = CFIFO_TYPED_INIT;
+
 int main(void)
 {
+	uint16_t item = 1;
 	CFIFO_CREATE_STATIC(fifo, uint8_t, 16);
 	(void) fifo;
 	(void) test_non_static;
 	(void) test_static;
+	if (u16_fifo_put(&test_typed, &item) != CFIFO_SUCCESS ||
+	    u16_fifo_get(&test_typed, &item) != CFIFO_SUCCESS)
+	{
+		return 1;
+	}
 	return 0;
 }
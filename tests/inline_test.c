@@ -0,0 +1,179 @@
+#ifndef CFIFO_INLINE
+#define CFIFO_INLINE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "cfifo.h"
+
+#define NUM_OPS     100000
+#define NUM_ITEMS   1000000
+
+/*
+ * Not assert(), this file is also built with CFIFO_UNCHECKED and NDEBUG as
+ * inline_unchecked_test, where an assert() would drop the call under test.
+ */
+#define CHECK(x)                                                            \
+    do                                                                      \
+    {                                                                       \
+        if (!(x))                                                           \
+        {                                                                   \
+            fprintf(stderr, "%s:%d: check failed: %s\n",                    \
+                    __FILE__, __LINE__, #x);                                \
+            abort();                                                        \
+        }                                                                   \
+    } while (0)
+
+static struct cfifo_s shared;
+static uint32_t shared_buf[60];
+
+/*
+ * The same random mix of calls on two fifos, through the inline versions
+ * and through the out-of-line functions, gives the same results.
+ */
+static void equivalence_test(size_t capacity)
+{
+    uint32_t buf_a[8];
+    uint32_t buf_b[8];
+    uint32_t items[8];
+    uint32_t out_a[8];
+    uint32_t out_b[8];
+    struct cfifo_s fifo_a;
+    struct cfifo_s fifo_b;
+    uint32_t next = 0;
+    uint32_t seed = 1;
+    size_t num_a;
+    size_t num_b;
+    size_t i;
+    int op;
+
+    CHECK(cfifo_init(&fifo_a, (uint8_t *) buf_a, capacity, 4, capacity * 4) == CFIFO_SUCCESS);
+    CHECK(cfifo_init(&fifo_b, (uint8_t *) buf_b, capacity, 4, capacity * 4) == CFIFO_SUCCESS);
+
+    for (op = 0; op < NUM_OPS; op++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        num_a = (seed >> 8) % 9;
+        num_b = num_a;
+        switch ((seed >> 16) % 4)
+        {
+        case 0:
+            CHECK(cfifo_put(&fifo_a, &next) == (cfifo_put)(&fifo_b, &next));
+            next++;
+            break;
+        case 1:
+            CHECK(cfifo_get(&fifo_a, &out_a[0]) == (cfifo_get)(&fifo_b, &out_b[0]));
+            CHECK(out_a[0] == out_b[0]);
+            break;
+        case 2:
+            for (i = 0; i < num_a; i++)
+            {
+                items[i] = next++;
+            }
+            CHECK(cfifo_write(&fifo_a, items, &num_a) == CFIFO_SUCCESS);
+            CHECK((cfifo_write)(&fifo_b, items, &num_b) == CFIFO_SUCCESS);
+            CHECK(num_a == num_b);
+            break;
+        default:
+            CHECK(cfifo_read(&fifo_a, out_a, &num_a) == CFIFO_SUCCESS);
+            CHECK((cfifo_read)(&fifo_b, out_b, &num_b) == CFIFO_SUCCESS);
+            CHECK(num_a == num_b);
+            CHECK(memcmp(out_a, out_b, num_a * sizeof(uint32_t)) == 0);
+            break;
+        }
+        CHECK(cfifo_size(&fifo_a) == cfifo_size(&fifo_b));
+    }
+}
+
+static void api_test(void)
+{
+    uint32_t buf[4];
+    uint32_t items[6] = {1, 2, 3, 4, 5, 6};
+    uint32_t item = 0;
+    struct cfifo_s fifo;
+    size_t num = 0;
+
+#if CFIFO_CHECKED
+    CHECK(cfifo_put(NULL, &item) == CFIFO_ERR_NULL);
+    CHECK(cfifo_get(NULL, &item) == CFIFO_ERR_NULL);
+    CHECK(cfifo_write(NULL, items, &num) == CFIFO_ERR_NULL);
+    CHECK(cfifo_read(NULL, items, &num) == CFIFO_ERR_NULL);
+    fifo.p_buf = NULL;
+    CHECK(cfifo_put(&fifo, &item) == CFIFO_ERR_INVALID_STATE);
+#endif
+
+    /* A fifo with flags set takes the out-of-line path. */
+    CHECK(cfifo_init(&fifo, (uint8_t *) buf, 4, 4, sizeof(buf)) == CFIFO_SUCCESS);
+    CHECK(cfifo_enable_overwrite(&fifo) == CFIFO_SUCCESS);
+    num = 6;
+    CHECK(cfifo_write(&fifo, items, &num) == CFIFO_SUCCESS);
+    CHECK(num == 6);
+    CHECK(cfifo_overwritten(&fifo) == 2);
+    CHECK(cfifo_get(&fifo, &item) == CFIFO_SUCCESS);
+    CHECK(item == 3);
+}
+
+static void *producer(void *p_arg)
+{
+    uint32_t i = 0;
+
+    (void) p_arg;
+    while (i < NUM_ITEMS)
+    {
+        if (cfifo_put(&shared, &i) == CFIFO_SUCCESS)
+        {
+            i++;
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void concurrent_test(void)
+{
+    pthread_t thread;
+    uint32_t out[7];
+    uint32_t expected = 0;
+    size_t num;
+    size_t j;
+
+    CHECK(cfifo_init(&shared, (uint8_t *) shared_buf, 60, sizeof(uint32_t),
+                     sizeof(shared_buf)) == CFIFO_SUCCESS);
+    CHECK(pthread_create(&thread, NULL, producer, NULL) == 0);
+
+    while (expected < NUM_ITEMS)
+    {
+        num = 7;
+        CHECK(cfifo_read(&shared, out, &num) == CFIFO_SUCCESS);
+        for (j = 0; j < num; j++)
+        {
+            CHECK(out[j] == expected);
+            expected++;
+        }
+        if (0 == num)
+        {
+            sched_yield();
+        }
+    }
+    CHECK(pthread_join(thread, NULL) == 0);
+}
+
+int main(void)
+{
+    equivalence_test(8);
+    equivalence_test(6);
+    api_test();
+    concurrent_test();
+
+    printf("Tests passed!\n");
+
+    return 0;
+}
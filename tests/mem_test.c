@@ -0,0 +1,213 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "cfifo_mem.h"
+
+static void mirror_test(void)
+{
+    struct cfifo_s fifo;
+    size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+    uint8_t in[256];
+    uint8_t out[256];
+    cfifo_span_t spans[2];
+    size_t num;
+    size_t i;
+
+    for (i = 0; i < sizeof(in); i++)
+    {
+        in[i] = (uint8_t) i;
+    }
+
+    assert(cfifo_mirror_create(NULL, page_size, 1) == CFIFO_ERR_NULL);
+    assert(cfifo_mirror_create(&fifo, 0, 1) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_mirror_create(&fifo, page_size, 1) == CFIFO_SUCCESS);
+#if defined(__linux__)
+    assert(fifo.flags & CFIFO_FLAG_MIRRORED);
+
+    /* Both halves alias the same memory. */
+    fifo.p_buf[3] = 0xA5;
+    assert(fifo.p_buf[page_size + 3] == 0xA5);
+#endif
+
+    /* Move the positions close to the end of the buffer. */
+    for (i = 0; i < page_size - 100; i += sizeof(out))
+    {
+        num = page_size - 100 - i;
+        num = (num > sizeof(out)) ? sizeof(out) : num;
+        assert(cfifo_write(&fifo, in, &num) == CFIFO_SUCCESS);
+        assert(cfifo_read(&fifo, out, &num) == CFIFO_SUCCESS);
+    }
+
+    /* Wrapping write and read. */
+    num = sizeof(in);
+    assert(cfifo_write(&fifo, in, &num) == CFIFO_SUCCESS);
+    assert(num == sizeof(in));
+
+    assert(cfifo_acquire(&fifo, spans) == CFIFO_SUCCESS);
+    assert(spans[0].num_items + spans[1].num_items == sizeof(in));
+    if (fifo.flags & CFIFO_FLAG_MIRRORED)
+    {
+        /* One contiguous span across the end of the buffer. */
+        assert(spans[0].num_items == sizeof(in));
+        assert(spans[1].num_items == 0);
+        assert(memcmp(spans[0].p_data, in, sizeof(in)) == 0);
+    }
+    assert(cfifo_release(&fifo, 0) == CFIFO_SUCCESS);
+
+    num = sizeof(out);
+    assert(cfifo_read(&fifo, out, &num) == CFIFO_SUCCESS);
+    assert(num == sizeof(out));
+    assert(memcmp(in, out, sizeof(in)) == 0);
+
+    assert(cfifo_mirror_destroy(&fifo) == CFIFO_SUCCESS);
+    assert(cfifo_mirror_destroy(&fifo) == CFIFO_ERR_INVALID_STATE);
+    assert(cfifo_mirror_destroy(NULL) == CFIFO_ERR_NULL);
+}
+
+static void fallback_test(void)
+{
+    struct cfifo_s fifo;
+    uint32_t a = 0x12345678;
+    uint32_t b;
+    uint8_t *p_buf;
+
+    assert(cfifo_mirror_alloc(NULL, 4096) == CFIFO_ERR_NULL);
+    assert(cfifo_mirror_alloc(&p_buf, 100) == CFIFO_ERR_BAD_SIZE);
+
+    /* Too small to be mirrored, gets a flat buffer. */
+    assert(cfifo_mirror_create(&fifo, 16, sizeof(uint32_t)) == CFIFO_SUCCESS);
+    assert(!(fifo.flags & CFIFO_FLAG_MIRRORED));
+    assert(cfifo_put(&fifo, &a) == CFIFO_SUCCESS);
+    assert(cfifo_get(&fifo, &b) == CFIFO_SUCCESS);
+    assert(a == b);
+    assert(cfifo_mirror_destroy(&fifo) == CFIFO_SUCCESS);
+}
+
+static void provision_test(void)
+{
+    static const unsigned int options[] = {
+        0,
+        CFIFO_MEM_PREFAULT,
+        CFIFO_MEM_THP | CFIFO_MEM_PREFAULT,
+        CFIFO_MEM_HUGETLB | CFIFO_MEM_THP | CFIFO_MEM_LOCK | CFIFO_MEM_PREFAULT
+    };
+    static uint8_t in[2048];
+    static uint8_t out[2048];
+    struct cfifo_s fifo;
+    unsigned int flags = 0;
+    uint8_t *p_buf;
+    uint32_t a;
+    uint32_t b;
+    size_t i;
+
+    assert(cfifo_mem_alloc(NULL, 4096, &flags) == CFIFO_ERR_NULL);
+    assert(cfifo_mem_alloc(&p_buf, 4096, NULL) == CFIFO_ERR_NULL);
+    assert(cfifo_mem_alloc(&p_buf, 0, &flags) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_mem_alloc(&p_buf, SIZE_MAX, &flags) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_mem_create(NULL, 16, 4, &flags) == CFIFO_ERR_NULL);
+    assert(cfifo_mem_create(&fifo, 0, 4, &flags) == CFIFO_ERR_BAD_SIZE);
+
+    for (i = 0; i < sizeof(options) / sizeof(options[0]); i++)
+    {
+        /* Whatever the system grants is a subset of the request. */
+        flags = options[i];
+        assert(cfifo_mem_alloc(&p_buf, 3 * 1024 * 1024 + 5, &flags) == CFIFO_SUCCESS);
+        assert((flags & ~options[i]) == 0);
+        assert((options[i] & CFIFO_MEM_PREFAULT) == (flags & CFIFO_MEM_PREFAULT));
+        assert(!((flags & CFIFO_MEM_HUGETLB) && (flags & CFIFO_MEM_THP)));
+#if defined(__linux__)
+        assert(((uintptr_t) p_buf & (CFIFO_MEM_HUGE_PAGE_SIZE - 1)) == 0);
+#endif
+        memset(p_buf, 0xA5, 3 * 1024 * 1024 + 5);
+        cfifo_mem_free(p_buf, 3 * 1024 * 1024 + 5);
+
+        /* 600 slots of 2 KB. */
+        flags = options[i];
+        assert(cfifo_mem_create(&fifo, 600, sizeof(in), &flags) == CFIFO_SUCCESS);
+        for (a = 0; a < 1000; a++)
+        {
+            memcpy(in, &a, sizeof(a));
+            assert(cfifo_put(&fifo, in) == CFIFO_SUCCESS);
+            assert(cfifo_get(&fifo, out) == CFIFO_SUCCESS);
+            memcpy(&b, out, sizeof(b));
+            assert(a == b);
+        }
+        assert(cfifo_mem_destroy(&fifo) == CFIFO_SUCCESS);
+        assert(cfifo_mem_destroy(&fifo) == CFIFO_ERR_INVALID_STATE);
+    }
+    assert(cfifo_mem_destroy(NULL) == CFIFO_ERR_NULL);
+    cfifo_mem_free(NULL, 4096);
+}
+
+static void numa_test(void)
+{
+    static uint8_t in[64];
+    static uint8_t out[64];
+    struct cfifo_s fifo;
+    int num_nodes = cfifo_mem_num_nodes();
+    int node = cfifo_mem_cpu_node(0);
+    unsigned int flags;
+    cfifo_ret_t ret;
+    uint8_t *p_buf;
+
+    assert(num_nodes >= 1 && num_nodes <= CFIFO_MEM_MAX_NODES);
+    assert(node >= -1 && node < num_nodes);
+    assert(cfifo_mem_cpu_node(-1) == -1);
+    if (node < 0)
+    {
+        node = 0;
+    }
+
+    assert(CFIFO_MEM_GET_NODE(0) == -1);
+    assert(CFIFO_MEM_GET_NODE(CFIFO_MEM_NODE(0) | CFIFO_MEM_PREFAULT) == 0);
+    assert(CFIFO_MEM_GET_NODE(CFIFO_MEM_NODE(CFIFO_MEM_MAX_NODES - 1)) ==
+           CFIFO_MEM_MAX_NODES - 1);
+
+    assert(cfifo_mem_bind(NULL, 4096, 0) == CFIFO_ERR_NULL);
+    assert(cfifo_mem_bind(in, 0, 0) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_mem_bind(in, sizeof(in), -1) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_mem_bind(in, sizeof(in), CFIFO_MEM_MAX_NODES) == CFIFO_ERR_BAD_SIZE);
+
+    /* Not every kernel has NUMA support, the node is then dropped. */
+    flags = CFIFO_MEM_NODE(node) | CFIFO_MEM_PREFAULT;
+    assert(cfifo_mem_create(&fifo, 1000, sizeof(in), &flags) == CFIFO_SUCCESS);
+    assert((flags & CFIFO_MEM_NODE_MASK) == 0 ||
+           CFIFO_MEM_GET_NODE(flags) == node);
+    ret = cfifo_mem_bind(fifo.p_buf, 1000 * sizeof(in), node);
+    assert(CFIFO_SUCCESS == ret || CFIFO_ERR_INVALID_STATE == ret);
+    if (CFIFO_MEM_GET_NODE(flags) == node)
+    {
+        assert(CFIFO_SUCCESS == ret);
+    }
+    memset(in, 0x3C, sizeof(in));
+    assert(cfifo_put(&fifo, in) == CFIFO_SUCCESS);
+    assert(cfifo_get(&fifo, out) == CFIFO_SUCCESS);
+    assert(memcmp(in, out, sizeof(in)) == 0);
+    assert(cfifo_mem_destroy(&fifo) == CFIFO_SUCCESS);
+
+    /* A node past the last online one is refused. */
+    if (num_nodes < CFIFO_MEM_MAX_NODES)
+    {
+        flags = CFIFO_MEM_NODE(num_nodes);
+        assert(cfifo_mem_alloc(&p_buf, 4096, &flags) == CFIFO_SUCCESS);
+        assert(0 == flags);
+        assert(cfifo_mem_bind(p_buf, 4096, num_nodes) == CFIFO_ERR_INVALID_STATE);
+        cfifo_mem_free(p_buf, 4096);
+    }
+}
+
+int main(void)
+{
+    mirror_test();
+    fallback_test();
+    provision_test();
+    numa_test();
+
+    printf("Tests passed!\n");
+
+    return 0;
+}
@@ -0,0 +1,178 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "cfifo_mpmc.h"
+
+#define NUM_PRODUCERS   4
+#define NUM_CONSUMERS   4
+#define ITEMS_PER_PRODUCER 20000
+
+struct item {
+    uint32_t producer;
+    uint32_t seq;
+    uint32_t check;
+};
+
+static uint8_t seen[NUM_PRODUCERS][ITEMS_PER_PRODUCER];
+static uint32_t last_seq[NUM_CONSUMERS][NUM_PRODUCERS];
+static volatile int consumed;
+static pthread_mutex_t consumed_lock = PTHREAD_MUTEX_INITIALIZER;
+
+CFIFO_MPMC_CREATE_STATIC(shared, struct item, 64);
+
+static void *producer(void *arg)
+{
+    struct item item;
+    uint32_t i;
+
+    item.producer = (uint32_t) (size_t) arg;
+    for (i = 0; i < ITEMS_PER_PRODUCER; i++)
+    {
+        item.seq = i;
+        item.check = ~(item.producer ^ i);
+        while (cfifo_mpmc_put(shared, &item) != CFIFO_SUCCESS)
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void *consumer(void *arg)
+{
+    size_t id = (size_t) arg;
+    struct item item;
+    int done = 0;
+
+    while (!done)
+    {
+        if (cfifo_mpmc_get(shared, &item) != CFIFO_SUCCESS)
+        {
+            pthread_mutex_lock(&consumed_lock);
+            done = (consumed == NUM_PRODUCERS * ITEMS_PER_PRODUCER);
+            pthread_mutex_unlock(&consumed_lock);
+            sched_yield();
+            continue;
+        }
+        assert(item.producer < NUM_PRODUCERS);
+        assert(item.seq < ITEMS_PER_PRODUCER);
+        assert(item.check == ~(item.producer ^ item.seq));
+        /* Items from one producer arrive in order at each consumer. */
+        assert(item.seq + 1 > last_seq[id][item.producer]);
+        last_seq[id][item.producer] = item.seq + 1;
+        /* Every item is seen exactly once, each entry is only written by
+         * the consumer that got the item. */
+        assert(seen[item.producer][item.seq] == 0);
+        seen[item.producer][item.seq] = 1;
+
+        pthread_mutex_lock(&consumed_lock);
+        consumed++;
+        pthread_mutex_unlock(&consumed_lock);
+    }
+    return NULL;
+}
+
+static void api_test(void)
+{
+    struct cfifo_mpmc_s fifo;
+    size_t buf[CFIFO_MPMC_BUF_WORDS(sizeof(uint16_t), 4)];
+    uint16_t a;
+    uint16_t i;
+
+    CFIFO_MPMC_CREATE(fifo8, uint8_t, 2);
+    assert(sizeof(buf) == 4 * CFIFO_MPMC_SLOT_SIZE(sizeof(uint16_t)));
+
+    assert(cfifo_mpmc_init(NULL, (uint8_t *) buf, 4, 2, sizeof(buf)) == CFIFO_ERR_NULL);
+    assert(cfifo_mpmc_init(&fifo, NULL, 4, 2, sizeof(buf)) == CFIFO_ERR_NULL);
+    assert(cfifo_mpmc_init(&fifo, (uint8_t *) buf, 3, 2, sizeof(buf)) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_mpmc_init(&fifo, (uint8_t *) buf, 1, 2, sizeof(buf)) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_mpmc_init(&fifo, (uint8_t *) buf, 4, 0, sizeof(buf)) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_mpmc_init(&fifo, (uint8_t *) buf, 4, 2, sizeof(buf) - 1) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_mpmc_init(&fifo, (uint8_t *) buf + 1, 4, 2, sizeof(buf)) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_mpmc_init(&fifo, (uint8_t *) buf, 4, 2, sizeof(buf)) == CFIFO_SUCCESS);
+
+    assert(cfifo_mpmc_put(NULL, &a) == CFIFO_ERR_NULL);
+    assert(cfifo_mpmc_put(&fifo, NULL) == CFIFO_ERR_NULL);
+    assert(cfifo_mpmc_get(NULL, &a) == CFIFO_ERR_NULL);
+    assert(cfifo_mpmc_get(&fifo, NULL) == CFIFO_ERR_NULL);
+    assert(cfifo_mpmc_size(NULL) == 0);
+
+    /* Several laps around the ring. */
+    for (i = 0; i < 40; i++)
+    {
+        a = i;
+        assert(cfifo_mpmc_put(&fifo, &a) == CFIFO_SUCCESS);
+        if (i % 4 == 3)
+        {
+            assert(cfifo_mpmc_size(&fifo) == 4);
+            assert(cfifo_mpmc_put(&fifo, &a) == CFIFO_ERR_FULL);
+            for (a = 0; a < 4; a++)
+            {
+                uint16_t b;
+                assert(cfifo_mpmc_get(&fifo, &b) == CFIFO_SUCCESS);
+                assert(b == i - 3 + a);
+            }
+            assert(cfifo_mpmc_get(&fifo, &a) == CFIFO_ERR_EMPTY);
+            assert(cfifo_mpmc_size(&fifo) == 0);
+        }
+    }
+
+    /* Statically created fifo needs no init. */
+    a = 7;
+    assert(cfifo_mpmc_put(fifo8, &a) == CFIFO_SUCCESS);
+    assert(cfifo_mpmc_put(fifo8, &a) == CFIFO_SUCCESS);
+    assert(cfifo_mpmc_put(fifo8, &a) == CFIFO_ERR_FULL);
+    a = 0;
+    assert(cfifo_mpmc_get(fifo8, &a) == CFIFO_SUCCESS);
+    assert(a == 7);
+
+    memset(&fifo, 0, sizeof(fifo));
+    assert(cfifo_mpmc_put(&fifo, &a) == CFIFO_ERR_INVALID_STATE);
+    assert(cfifo_mpmc_get(&fifo, &a) == CFIFO_ERR_INVALID_STATE);
+    assert(cfifo_mpmc_size(&fifo) == 0);
+}
+
+int main(void)
+{
+    pthread_t prod[NUM_PRODUCERS];
+    pthread_t cons[NUM_CONSUMERS];
+    size_t i;
+    size_t j;
+
+    api_test();
+
+    for (i = 0; i < NUM_CONSUMERS; i++)
+    {
+        assert(pthread_create(&cons[i], NULL, consumer, (void *) i) == 0);
+    }
+    for (i = 0; i < NUM_PRODUCERS; i++)
+    {
+        assert(pthread_create(&prod[i], NULL, producer, (void *) i) == 0);
+    }
+    for (i = 0; i < NUM_PRODUCERS; i++)
+    {
+        assert(pthread_join(prod[i], NULL) == 0);
+    }
+    for (i = 0; i < NUM_CONSUMERS; i++)
+    {
+        assert(pthread_join(cons[i], NULL) == 0);
+    }
+
+    for (i = 0; i < NUM_PRODUCERS; i++)
+    {
+        for (j = 0; j < ITEMS_PER_PRODUCER; j++)
+        {
+            assert(seen[i][j] == 1);
+        }
+    }
+    assert(cfifo_mpmc_size(shared) == 0);
+
+    printf("cfifo mpmc test passed!\r\n");
+
+    return 0;
+}
@@ -0,0 +1,143 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "cfifo_mpsc.h"
+
+#define NUM_PRODUCERS       4
+#define ITEMS_PER_PRODUCER  20000
+#define BATCH_SIZE          16
+
+struct record {
+    uint32_t producer;
+    uint32_t seq;
+    uint32_t check;
+};
+
+CFIFO_MPSC_CREATE_STATIC(shared, struct record, 64);
+
+static void *producer(void *arg)
+{
+    struct record rec;
+    uint32_t i;
+
+    rec.producer = (uint32_t) (size_t) arg;
+    for (i = 0; i < ITEMS_PER_PRODUCER; i++)
+    {
+        rec.seq = i;
+        rec.check = ~(rec.producer ^ i);
+        while (cfifo_mpsc_put(shared, &rec) != CFIFO_SUCCESS)
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void api_test(void)
+{
+    struct cfifo_mpsc_s fifo;
+    size_t buf[CFIFO_MPSC_BUF_WORDS(sizeof(uint16_t), 4)];
+    uint16_t items[8];
+    uint16_t a;
+    size_t num;
+    uint16_t i;
+
+    assert(cfifo_mpsc_init(NULL, (uint8_t *) buf, 4, 2, sizeof(buf)) == CFIFO_ERR_NULL);
+    assert(cfifo_mpsc_init(&fifo, NULL, 4, 2, sizeof(buf)) == CFIFO_ERR_NULL);
+    assert(cfifo_mpsc_init(&fifo, (uint8_t *) buf, 3, 2, sizeof(buf)) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_mpsc_init(&fifo, (uint8_t *) buf, 4, 2, sizeof(buf) - 1) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_mpsc_init(&fifo, (uint8_t *) buf + 2, 4, 2, sizeof(buf)) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_mpsc_init(&fifo, (uint8_t *) buf, 4, 2, sizeof(buf)) == CFIFO_SUCCESS);
+
+    assert(cfifo_mpsc_put(NULL, &a) == CFIFO_ERR_NULL);
+    assert(cfifo_mpsc_put(&fifo, NULL) == CFIFO_ERR_NULL);
+    assert(cfifo_mpsc_get(NULL, &a) == CFIFO_ERR_NULL);
+    assert(cfifo_mpsc_get(&fifo, NULL) == CFIFO_ERR_NULL);
+    assert(cfifo_mpsc_read(&fifo, NULL, &num) == CFIFO_ERR_NULL);
+    assert(cfifo_mpsc_read(&fifo, items, NULL) == CFIFO_ERR_NULL);
+
+    assert(cfifo_mpsc_get(&fifo, &a) == CFIFO_ERR_EMPTY);
+    num = 8;
+    assert(cfifo_mpsc_read(&fifo, items, &num) == CFIFO_SUCCESS);
+    assert(num == 0);
+
+    for (i = 0; i < 4; i++)
+    {
+        assert(cfifo_mpsc_put(&fifo, &i) == CFIFO_SUCCESS);
+    }
+    assert(cfifo_mpsc_put(&fifo, &i) == CFIFO_ERR_FULL);
+    assert(cfifo_mpsc_size(&fifo) == 4);
+    assert(cfifo_mpsc_get(&fifo, &a) == CFIFO_SUCCESS);
+    assert(a == 0);
+    assert(cfifo_mpsc_put(&fifo, &i) == CFIFO_SUCCESS);
+    assert(cfifo_mpsc_put(&fifo, &i) == CFIFO_ERR_FULL);
+    assert(cfifo_mpsc_size(&fifo) == 4);
+
+    /* Output buffer limits the batch. */
+    num = 2;
+    assert(cfifo_mpsc_read(&fifo, items, &num) == CFIFO_SUCCESS);
+    assert(num == 2 && items[0] == 1 && items[1] == 2);
+    /* Drain everything published, across the wrap. */
+    num = 8;
+    assert(cfifo_mpsc_read(&fifo, items, &num) == CFIFO_SUCCESS);
+    assert(num == 2 && items[0] == 3 && items[1] == 4);
+    assert(cfifo_mpsc_size(&fifo) == 0);
+
+    memset(&fifo, 0, sizeof(fifo));
+    assert(cfifo_mpsc_put(&fifo, &a) == CFIFO_ERR_INVALID_STATE);
+    assert(cfifo_mpsc_get(&fifo, &a) == CFIFO_ERR_INVALID_STATE);
+    assert(cfifo_mpsc_read(&fifo, items, &num) == CFIFO_ERR_INVALID_STATE);
+    assert(cfifo_mpsc_size(&fifo) == 0);
+}
+
+int main(void)
+{
+    pthread_t prod[NUM_PRODUCERS];
+    uint32_t next_seq[NUM_PRODUCERS] = {0};
+    struct record batch[BATCH_SIZE];
+    size_t total = 0;
+    size_t num;
+    size_t i;
+
+    api_test();
+
+    for (i = 0; i < NUM_PRODUCERS; i++)
+    {
+        assert(pthread_create(&prod[i], NULL, producer, (void *) i) == 0);
+    }
+
+    while (total < NUM_PRODUCERS * ITEMS_PER_PRODUCER)
+    {
+        num = BATCH_SIZE;
+        assert(cfifo_mpsc_read(shared, batch, &num) == CFIFO_SUCCESS);
+        for (i = 0; i < num; i++)
+        {
+            assert(batch[i].producer < NUM_PRODUCERS);
+            assert(batch[i].check == ~(batch[i].producer ^ batch[i].seq));
+            /* Records of one producer arrive in order and none is lost. */
+            assert(batch[i].seq == next_seq[batch[i].producer]);
+            next_seq[batch[i].producer]++;
+        }
+        total += num;
+        if (0 == num)
+        {
+            sched_yield();
+        }
+    }
+
+    for (i = 0; i < NUM_PRODUCERS; i++)
+    {
+        assert(pthread_join(prod[i], NULL) == 0);
+        assert(next_seq[i] == ITEMS_PER_PRODUCER);
+    }
+    assert(cfifo_mpsc_size(shared) == 0);
+
+    printf("cfifo mpsc test passed!\r\n");
+
+    return 0;
+}
@@ -0,0 +1,162 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <assert.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include "cfifo_notify.h"
+
+#define NUM_ITEMS   100000
+
+CFIFO_CREATE_STATIC(shared, uint32_t, 64);
+
+static int ready(int fd)
+{
+    int epfd = epoll_create1(0);
+    struct epoll_event ev;
+    int n;
+
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    assert(epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) == 0);
+    n = epoll_wait(epfd, &ev, 1, 0);
+    close(epfd);
+    return n;
+}
+
+static uint64_t count(int fd)
+{
+    uint64_t value = 0;
+
+    if (read(fd, &value, sizeof(value)) != sizeof(value))
+    {
+        return 0;
+    }
+    return value;
+}
+
+static void *producer(void *arg)
+{
+    uint32_t i;
+
+    (void) arg;
+    for (i = 0; i < NUM_ITEMS; i++)
+    {
+        while (cfifo_put(shared, &i) != CFIFO_SUCCESS)
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void api_test(void)
+{
+    struct cfifo_s fifo;
+    uint32_t buf[4];
+    uint32_t items[4] = { 1, 2, 3, 4 };
+    size_t num;
+
+    assert(cfifo_init(&fifo, (uint8_t *) buf, 4, sizeof(uint32_t), sizeof(buf)) == CFIFO_SUCCESS);
+
+    assert(cfifo_data_fd(&fifo) == -1);
+    assert(cfifo_space_fd(&fifo) == -1);
+    assert(cfifo_enable_notify(NULL, CFIFO_NOTIFY_DATA) == CFIFO_ERR_NULL);
+    assert(cfifo_enable_notify(&fifo, 0) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_enable_notify(&fifo, 0x10) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_enable_notify(&fifo, CFIFO_NOTIFY_DATA | CFIFO_NOTIFY_SPACE) == CFIFO_SUCCESS);
+    assert(cfifo_enable_notify(&fifo, CFIFO_NOTIFY_DATA) == CFIFO_ERR_INVALID_STATE);
+    assert(cfifo_data_fd(&fifo) >= 0);
+    assert(cfifo_space_fd(&fifo) >= 0);
+
+    /* Empty fifo: no data signal, but the space fd is signalled right away. */
+    assert(ready(cfifo_data_fd(&fifo)) == 0);
+    assert(ready(cfifo_space_fd(&fifo)) == 1);
+
+    /* One signal for the empty to non-empty edge, none for the next puts. */
+    assert(cfifo_put(&fifo, &items[0]) == CFIFO_SUCCESS);
+    assert(ready(cfifo_data_fd(&fifo)) == 1);
+    assert(cfifo_put(&fifo, &items[1]) == CFIFO_SUCCESS);
+    assert(cfifo_put(&fifo, &items[2]) == CFIFO_SUCCESS);
+    assert(count(cfifo_data_fd(&fifo)) == 1);
+
+    /* Not drained yet, rearm reports the items and stays quiet. */
+    assert(cfifo_rearm_data(&fifo) == 3);
+    assert(cfifo_put(&fifo, &items[3]) == CFIFO_SUCCESS);
+    assert(ready(cfifo_data_fd(&fifo)) == 0);
+
+    /* Full, the producer arms the space fd. */
+    assert(cfifo_rearm_space(&fifo) == 0);
+    assert(ready(cfifo_space_fd(&fifo)) == 0);
+
+    num = 4;
+    assert(cfifo_read(&fifo, items, &num) == CFIFO_SUCCESS);
+    assert(num == 4);
+    assert(count(cfifo_space_fd(&fifo)) == 1);
+
+    /* Drained, rearm and the next put signals again. */
+    assert(cfifo_rearm_data(&fifo) == 0);
+    assert(ready(cfifo_data_fd(&fifo)) == 0);
+    assert(cfifo_put(&fifo, &items[0]) == CFIFO_SUCCESS);
+    assert(count(cfifo_data_fd(&fifo)) == 1);
+
+    assert(cfifo_disable_notify(&fifo) == CFIFO_SUCCESS);
+    assert(cfifo_data_fd(&fifo) == -1);
+    assert(cfifo_put(&fifo, &items[1]) == CFIFO_SUCCESS);
+    assert(cfifo_disable_notify(NULL) == CFIFO_ERR_NULL);
+}
+
+/* Consumer event loop against a producer thread using the plain API. */
+static void epoll_test(void)
+{
+    pthread_t thread;
+    struct epoll_event ev;
+    int epfd = epoll_create1(0);
+    uint32_t items[16];
+    uint32_t expected = 0;
+    size_t num;
+    size_t i;
+
+    assert(cfifo_enable_notify(shared, CFIFO_NOTIFY_DATA) == CFIFO_SUCCESS);
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.fd = cfifo_data_fd(shared);
+    assert(epoll_ctl(epfd, EPOLL_CTL_ADD, cfifo_data_fd(shared), &ev) == 0);
+
+    pthread_create(&thread, NULL, producer, NULL);
+    while (expected < NUM_ITEMS)
+    {
+        assert(epoll_wait(epfd, &ev, 1, 5000) == 1);
+        do
+        {
+            do
+            {
+                num = sizeof(items) / sizeof(items[0]);
+                assert(cfifo_read(shared, items, &num) == CFIFO_SUCCESS);
+                for (i = 0; i < num; i++)
+                {
+                    
+                    assert(items[i] == expected);
+                    expected++;
+                }
+            } while (num > 0);
+        } while (cfifo_rearm_data(shared) > 0);
+    }
+    pthread_join(thread, NULL);
+
+    close(epfd);
+    assert(cfifo_disable_notify(shared) == CFIFO_SUCCESS);
+}
+
+int main(void)
+{
+    api_test();
+    epoll_test();
+
+    printf("Tests passed!\n");
+
+    return 0;
+}
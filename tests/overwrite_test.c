@@ -0,0 +1,143 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <assert.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "cfifo.h"
+#include "cfifo_index.h"
+
+#define NUM_ITEMS   1000000
+
+/* Both words are written together, a torn copy has them disagree. */
+struct sample {
+    uint64_t seq;
+    uint64_t check;
+};
+
+CFIFO_CREATE_STATIC(shared, struct sample, 64);
+
+static int done;
+
+static void api_test(void)
+{
+    CFIFO_CREATE(fifo, uint32_t, 4);
+    struct cfifo_index_s index;
+    size_t table[CFIFO_INDEX_BUF_WORDS(sizeof(uint32_t), 8)];
+    cfifo_span_t spans[2];
+    uint32_t items[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    uint32_t out[4];
+    size_t num;
+    uint32_t i;
+
+    assert(cfifo_enable_overwrite(NULL) == CFIFO_ERR_NULL);
+    assert(cfifo_index_init(&index, (uint8_t *) table, 8, 4, sizeof(table)) == CFIFO_SUCCESS);
+    assert(cfifo_attach_index(fifo, &index) == CFIFO_SUCCESS);
+    assert(cfifo_enable_overwrite(fifo) == CFIFO_ERR_INVALID_STATE);
+    assert(cfifo_detach_index(fifo) == CFIFO_SUCCESS);
+    assert(cfifo_enable_overwrite(fifo) == CFIFO_SUCCESS);
+    assert(cfifo_attach_index(fifo, &index) == CFIFO_ERR_INVALID_STATE);
+    assert(cfifo_reserve(fifo, spans) == CFIFO_ERR_INVALID_STATE);
+    assert(cfifo_acquire(fifo, spans) == CFIFO_ERR_INVALID_STATE);
+
+    /* Puts never fail, the oldest items go. */
+    for (i = 0; i < 6; i++)
+    {
+        assert(cfifo_put(fifo, &items[i]) == CFIFO_SUCCESS);
+    }
+    assert(cfifo_size(fifo) == 4);
+    assert(cfifo_overwritten(fifo) == 2);
+    assert(cfifo_peek(fifo, &out[0]) == CFIFO_SUCCESS);
+    assert(out[0] == 2);
+    assert(cfifo_get(fifo, &out[0]) == CFIFO_SUCCESS);
+    assert(out[0] == 2);
+
+    /* 3 stored, 3 written: 2 overwritten. */
+    assert(cfifo_write_bulk(fifo, &items[6], 3) == CFIFO_SUCCESS);
+    assert(cfifo_overwritten(fifo) == 4);
+    assert(cfifo_write_bulk(fifo, items, 5) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_read_bulk(fifo, out, 4) == CFIFO_SUCCESS);
+    assert(out[0] == 5 && out[1] == 6 && out[2] == 7 && out[3] == 8);
+    assert(cfifo_read_bulk(fifo, out, 1) == CFIFO_ERR_EMPTY);
+    assert(cfifo_get(fifo, &out[0]) == CFIFO_ERR_EMPTY);
+
+    /* Only the last capacity items of a larger batch are kept. */
+    num = 10;
+    assert(cfifo_write(fifo, items, &num) == CFIFO_SUCCESS);
+    assert(num == 10);
+    assert(cfifo_overwritten(fifo) == 10);
+    num = 4;
+    assert(cfifo_read(fifo, out, &num) == CFIFO_SUCCESS);
+    assert(num == 4);
+    assert(out[0] == 6 && out[1] == 7 && out[2] == 8 && out[3] == 9);
+
+    assert(cfifo_put(fifo, &items[0]) == CFIFO_SUCCESS);
+    assert(cfifo_flush(fifo) == CFIFO_SUCCESS);
+    assert(cfifo_size(fifo) == 0);
+}
+
+static void *producer(void *arg)
+{
+    struct sample sample;
+    uint64_t i;
+
+    (void) arg;
+    for (i = 0; i < NUM_ITEMS; i++)
+    {
+        sample.seq = i;
+        sample.check = ~i;
+        assert(cfifo_put(shared, &sample) == CFIFO_SUCCESS);
+    }
+    __atomic_store_n(&done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void spsc_test(void)
+{
+    pthread_t thread;
+    struct sample sample;
+    uint64_t received = 0;
+    uint64_t last = 0;
+    int finished;
+
+    assert(cfifo_enable_overwrite(shared) == CFIFO_SUCCESS);
+    assert(pthread_create(&thread, NULL, producer, NULL) == 0);
+    for (;;)
+    {
+        /* Checked before the get, so an empty fifo after it is final. */
+        finished = __atomic_load_n(&done, __ATOMIC_ACQUIRE);
+        if (cfifo_get(shared, &sample) != CFIFO_SUCCESS)
+        {
+            if (finished)
+            {
+                break;
+            }
+            sched_yield();
+            continue;
+        }
+        assert(sample.check == ~sample.seq);
+        assert(0 == received || sample.seq > last);
+        last = sample.seq;
+        received++;
+    }
+    assert(pthread_join(thread, NULL) == 0);
+
+    /* Everything is either received or counted as overwritten. */
+    assert(cfifo_get(shared, &sample) == CFIFO_ERR_EMPTY);
+    assert(last == NUM_ITEMS - 1);
+    assert(received + cfifo_overwritten(shared) == NUM_ITEMS);
+    printf("received %llu, overwritten %llu\n",
+           (unsigned long long) received,
+           (unsigned long long) cfifo_overwritten(shared));
+}
+
+int main(void)
+{
+    api_test();
+    spsc_test();
+
+    printf("cfifo overwrite test passed!\n");
+    return 0;
+}
@@ -0,0 +1,217 @@
+#include <stdio.h>
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "cfifo_pipe.h"
+
+#define NUM_ITEMS   300000
+#define NUM_STAGES  3
+#define CAPACITY    100
+
+static struct cfifo_pipe_s shared;
+static uint32_t shared_buf[CAPACITY];
+
+static void api_test(void)
+{
+    struct cfifo_pipe_s pipe;
+    uint32_t buf[6];
+    uint32_t items[6] = {0, 1, 2, 3, 4, 5};
+    cfifo_span_t spans[2];
+    uint32_t item;
+    uint32_t *p_item;
+    size_t num;
+
+    assert(cfifo_pipe_init(NULL, (uint8_t *) buf, 6, 4, sizeof(buf), 2) == CFIFO_ERR_NULL);
+    assert(cfifo_pipe_init(&pipe, (uint8_t *) buf, 6, 4, sizeof(buf), 0) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_pipe_init(&pipe, (uint8_t *) buf, 6, 4, sizeof(buf),
+                           CFIFO_PIPE_MAX_STAGES + 1) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_pipe_init(&pipe, (uint8_t *) buf, 6, 4, 8, 2) == CFIFO_ERR_BAD_SIZE);
+    /* Capacity 6 also covers positions that are not masked. */
+    assert(cfifo_pipe_init(&pipe, (uint8_t *) buf, 6, 4, sizeof(buf), 2) == CFIFO_SUCCESS);
+    assert(cfifo_pipe_claim(&pipe, 0, spans) == CFIFO_ERR_EMPTY);
+    assert(cfifo_pipe_claim(&pipe, 2, spans) == CFIFO_ERR_BAD_SIZE);
+
+    num = 4;
+    assert(cfifo_write(&pipe.fifo, items, &num) == CFIFO_SUCCESS);
+    assert(cfifo_pipe_size(&pipe, 0) == 4);
+    assert(cfifo_pipe_claim(&pipe, 1, spans) == CFIFO_ERR_EMPTY);
+
+    /* Stage 0 works in place and hands on half of its batch. */
+    assert(cfifo_pipe_claim(&pipe, 0, spans) == CFIFO_SUCCESS);
+    assert(spans[0].num_items == 4 && spans[1].num_items == 0);
+    p_item = (uint32_t *) (void *) spans[0].p_data;
+    p_item[0] += 100;
+    p_item[1] += 100;
+    assert(cfifo_pipe_release(&pipe, 0, 5) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_pipe_release(&pipe, 0, 2) == CFIFO_SUCCESS);
+    assert(cfifo_pipe_size(&pipe, 0) == 2);
+    assert(cfifo_pipe_size(&pipe, 1) == 2);
+    assert(cfifo_pipe_release(&pipe, 1, 3) == CFIFO_ERR_BAD_SIZE);
+
+    /* The fifo itself still shows everything in the pipeline. */
+    assert(cfifo_size(&pipe.fifo) == 4);
+    assert(cfifo_peek(&pipe.fifo, &item) == CFIFO_SUCCESS);
+    assert(item == 100);
+
+    /* Only the last stage gives slots back to the producer. */
+    num = 6;
+    assert(cfifo_write(&pipe.fifo, items, &num) == CFIFO_SUCCESS);
+    assert(num == 2);
+    assert(cfifo_put(&pipe.fifo, &items[0]) == CFIFO_ERR_FULL);
+    assert(cfifo_pipe_claim(&pipe, 1, spans) == CFIFO_SUCCESS);
+    assert(spans[0].num_items == 2);
+    assert(memcmp(spans[0].p_data, &(uint32_t[]){100, 101}, 8) == 0);
+    assert(cfifo_pipe_release(&pipe, 1, 2) == CFIFO_SUCCESS);
+    assert(cfifo_size(&pipe.fifo) == 4);
+    num = 2;
+    assert(cfifo_write(&pipe.fifo, &items[4], &num) == CFIFO_SUCCESS);
+    assert(num == 2);
+
+    /* Claims that wrap around the end of the buffer. */
+    assert(cfifo_pipe_release(&pipe, 0, 6) == CFIFO_SUCCESS);
+    assert(cfifo_pipe_claim(&pipe, 1, spans) == CFIFO_SUCCESS);
+    assert(spans[0].num_items == 4 && spans[1].num_items == 2);
+    assert(spans[1].p_data == (uint8_t *) buf);
+    assert(memcmp(spans[0].p_data, &(uint32_t[]){2, 3, 0, 1}, 16) == 0);
+    assert(memcmp(spans[1].p_data, &(uint32_t[]){4, 5}, 8) == 0);
+    assert(cfifo_pipe_release(&pipe, 1, 6) == CFIFO_SUCCESS);
+    assert(cfifo_size(&pipe.fifo) == 0);
+    assert(cfifo_pipe_claim(&pipe, 0, spans) == CFIFO_ERR_EMPTY);
+
+    assert(cfifo_pipe_release(NULL, 0, 1) == CFIFO_ERR_NULL);
+    assert(cfifo_pipe_claim(&pipe, 0, NULL) == CFIFO_ERR_NULL);
+    assert(cfifo_pipe_size(NULL, 0) == 0);
+    assert(cfifo_pipe_size(&pipe, 2) == 0);
+}
+
+/* Claims go through the buffer offset of a relative fifo. */
+static void relative_test(void)
+{
+    struct {
+        struct cfifo_pipe_s pipe;
+        uint32_t buf[4];
+    } shm;
+    uint32_t items[3] = {7, 8, 9};
+    cfifo_span_t spans[2];
+    size_t num = 3;
+
+    assert(cfifo_pipe_init(&shm.pipe, (uint8_t *) shm.buf, 4, 4, sizeof(shm.buf), 2) == CFIFO_SUCCESS);
+    assert(cfifo_init_relative(&shm.pipe.fifo, (uint8_t *) shm.buf, 4, 4,
+                               sizeof(shm.buf)) == CFIFO_SUCCESS);
+    assert(cfifo_write(&shm.pipe.fifo, items, &num) == CFIFO_SUCCESS);
+    assert(cfifo_pipe_claim(&shm.pipe, 0, spans) == CFIFO_SUCCESS);
+    assert(spans[0].p_data == (uint8_t *) shm.buf && spans[0].num_items == 3);
+    assert(cfifo_pipe_release(&shm.pipe, 0, 3) == CFIFO_SUCCESS);
+    assert(cfifo_pipe_claim(&shm.pipe, 1, spans) == CFIFO_SUCCESS);
+    assert(memcmp(spans[0].p_data, items, sizeof(items)) == 0);
+    assert(cfifo_pipe_release(&shm.pipe, 1, 3) == CFIFO_SUCCESS);
+    assert(cfifo_size(&shm.pipe.fifo) == 0);
+}
+
+static void *producer(void *p_arg)
+{
+    uint32_t batch[16];
+    uint32_t i = 0;
+    size_t num;
+    size_t j;
+
+    (void) p_arg;
+    while (i < NUM_ITEMS)
+    {
+        for (j = 0; j < 16; j++)
+        {
+            batch[j] = i + (uint32_t) j;
+        }
+        num = (NUM_ITEMS - i < 16) ? NUM_ITEMS - i : 1 + i % 16;
+        assert(cfifo_write(&shared.fifo, batch, &num) == CFIFO_SUCCESS);
+        i += (uint32_t) num;
+        if (0 == num)
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+/* Stage 0 doubles, stage 1 adds 1, the last stage checks. */
+static void *stage(void *p_arg)
+{
+    size_t stage_num = (size_t) (uintptr_t) p_arg;
+    cfifo_span_t spans[2];
+    uint32_t expected = 0;
+    uint32_t *p_items;
+    size_t s;
+    size_t j;
+    size_t num;
+
+    while (expected < NUM_ITEMS)
+    {
+        if (cfifo_pipe_claim(&shared, stage_num, spans) != CFIFO_SUCCESS)
+        {
+            sched_yield();
+            continue;
+        }
+
+        num = 0;
+        for (s = 0; s < 2; s++)
+        {
+            p_items = (uint32_t *) (void *) spans[s].p_data;
+            for (j = 0; j < spans[s].num_items; j++)
+            {
+                if (0 == stage_num)
+                {
+                    assert(p_items[j] == expected);
+                    p_items[j] *= 2;
+                }
+                else if (1 == stage_num)
+                {
+                    assert(p_items[j] == 2 * expected);
+                    p_items[j] += 1;
+                }
+                else
+                {
+                    assert(p_items[j] == 2 * expected + 1);
+                }
+                expected++;
+            }
+            num += spans[s].num_items;
+        }
+        assert(cfifo_pipe_release(&shared, stage_num, num) == CFIFO_SUCCESS);
+    }
+    return NULL;
+}
+
+static void concurrent_test(void)
+{
+    pthread_t threads[NUM_STAGES + 1];
+    size_t i;
+
+    assert(cfifo_pipe_init(&shared, (uint8_t *) shared_buf, CAPACITY,
+                           sizeof(uint32_t), sizeof(shared_buf),
+                           NUM_STAGES) == CFIFO_SUCCESS);
+    for (i = 0; i < NUM_STAGES; i++)
+    {
+        assert(pthread_create(&threads[i], NULL, stage, (void *) (uintptr_t) i) == 0);
+    }
+    assert(pthread_create(&threads[NUM_STAGES], NULL, producer, NULL) == 0);
+
+    for (i = 0; i < NUM_STAGES + 1; i++)
+    {
+        assert(pthread_join(threads[i], NULL) == 0);
+    }
+    assert(cfifo_size(&shared.fifo) == 0);
+}
+
+int main(void)
+{
+    api_test();
+    relative_test();
+    concurrent_test();
+
+    printf("Tests passed!\n");
+
+    return 0;
+}
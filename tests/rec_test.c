@@ -0,0 +1,155 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "cfifo_rec.h"
+
+#define NUM_RECORDS 100000
+#define MAX_LEN     300
+
+CFIFO_CREATE_STATIC(shared, uint8_t, 1024);
+
+/* Record n has length n % MAX_LEN and bytes n + i. */
+static size_t fill(uint8_t *p_data, uint32_t n)
+{
+    size_t len = n % MAX_LEN;
+    size_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        p_data[i] = (uint8_t) (n + i);
+    }
+    return len;
+}
+
+static void api_test(void)
+{
+    CFIFO_CREATE(fifo, uint8_t, 64);
+    CFIFO_CREATE(words, uint32_t, 64);
+    uint8_t in[64];
+    uint8_t out[64];
+    void *p_data;
+    size_t len;
+
+    memset(in, 0xA5, sizeof(in));
+
+    assert(cfifo_rec_put(NULL, in, 1) == CFIFO_ERR_NULL);
+    assert(cfifo_rec_put(words, in, 1) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_rec_put(fifo, in, 64 - CFIFO_REC_HDR_SIZE + 1) == CFIFO_ERR_BAD_SIZE);
+    len = sizeof(out);
+    assert(cfifo_rec_get(fifo, out, &len) == CFIFO_ERR_EMPTY);
+
+    /* Sizes are rounded up to CFIFO_REC_ALIGN. */
+    assert(cfifo_rec_put(fifo, in, 0) == CFIFO_SUCCESS);
+    assert(cfifo_rec_put(fifo, in, 20) == CFIFO_SUCCESS);
+    assert(cfifo_size(fifo) == CFIFO_REC_SIZE(0) + CFIFO_REC_SIZE(20));
+    assert(cfifo_size(fifo) == 8 + 32);
+
+    /*
+     * 24 bytes left before the end, the start is taken. The record can only
+     * go to the start, the end is skipped right away.
+     */
+    assert(cfifo_rec_put(fifo, in, 20) == CFIFO_ERR_FULL);
+    assert(cfifo_size(fifo) == 64);
+
+    len = sizeof(out);
+    assert(cfifo_rec_get(fifo, out, &len) == CFIFO_SUCCESS);
+    assert(len == 0);
+
+    /* Too small a buffer leaves the record. */
+    len = 10;
+    assert(cfifo_rec_peek(fifo, out, &len) == CFIFO_ERR_BAD_SIZE);
+    assert(len == 20);
+    len = 10;
+    assert(cfifo_rec_get(fifo, out, &len) == CFIFO_ERR_BAD_SIZE);
+    len = sizeof(out);
+    assert(cfifo_rec_peek(fifo, out, &len) == CFIFO_SUCCESS);
+    assert(len == 20 && memcmp(in, out, len) == 0);
+    assert(cfifo_rec_get(fifo, out, &len) == CFIFO_SUCCESS);
+    assert(len == 20 && memcmp(in, out, len) == 0);
+
+    /* The skip record is dropped by the consumer. */
+    assert(cfifo_size(fifo) == 24);
+    assert(cfifo_rec_put(fifo, in, 20) == CFIFO_SUCCESS);
+    assert(cfifo_rec_acquire(fifo, &p_data, &len) == CFIFO_SUCCESS);
+    assert(len == 20 && memcmp(in, p_data, len) == 0);
+    assert(cfifo_size(fifo) == 32);
+    assert(cfifo_rec_release(fifo) == CFIFO_SUCCESS);
+    assert(cfifo_rec_release(fifo) == CFIFO_ERR_EMPTY);
+    assert(cfifo_size(fifo) == 0);
+
+    /* A record of the whole capacity needs the positions at the start. */
+    assert(cfifo_rec_put(fifo, in, 64 - CFIFO_REC_HDR_SIZE) == CFIFO_ERR_FULL);
+    len = sizeof(out);
+    assert(cfifo_rec_get(fifo, out, &len) == CFIFO_ERR_EMPTY);
+    assert(cfifo_rec_put(fifo, in, 64 - CFIFO_REC_HDR_SIZE) == CFIFO_SUCCESS);
+    assert(cfifo_available(fifo) == 0);
+    assert(cfifo_rec_get(fifo, out, &len) == CFIFO_SUCCESS);
+    assert(len == 64 - CFIFO_REC_HDR_SIZE && memcmp(in, out, len) == 0);
+
+    /* Reserve the most, commit what was written. */
+    assert(cfifo_rec_reserve(fifo, 56, &p_data) == CFIFO_SUCCESS);
+    assert(((uintptr_t) p_data % CFIFO_REC_ALIGN) == 0);
+    memcpy(p_data, "abc", 3);
+    assert(cfifo_rec_commit(fifo, 57) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_rec_commit(fifo, 3) == CFIFO_SUCCESS);
+    assert(cfifo_size(fifo) == 16);
+    assert(cfifo_rec_acquire(fifo, &p_data, &len) == CFIFO_SUCCESS);
+    assert(len == 3 && memcmp(p_data, "abc", 3) == 0);
+    assert(cfifo_rec_release(fifo) == CFIFO_SUCCESS);
+}
+
+static void *producer(void *arg)
+{
+    uint8_t data[MAX_LEN];
+    size_t len;
+    uint32_t n;
+
+    (void) arg;
+    for (n = 0; n < NUM_RECORDS; n++)
+    {
+        len = fill(data, n);
+        while (cfifo_rec_put(shared, data, len) != CFIFO_SUCCESS)
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void spsc_test(void)
+{
+    pthread_t thread;
+    uint8_t expected[MAX_LEN];
+    void *p_data;
+    size_t len;
+    uint32_t n;
+
+    assert(pthread_create(&thread, NULL, producer, NULL) == 0);
+    for (n = 0; n < NUM_RECORDS; n++)
+    {
+        while (cfifo_rec_acquire(shared, &p_data, &len) != CFIFO_SUCCESS)
+        {
+            sched_yield();
+        }
+        assert(len == fill(expected, n));
+        assert(memcmp(p_data, expected, len) == 0);
+        assert(cfifo_rec_release(shared) == CFIFO_SUCCESS);
+    }
+    assert(pthread_join(thread, NULL) == 0);
+    assert(cfifo_size(shared) == 0);
+}
+
+int main(void)
+{
+    api_test();
+    spsc_test();
+
+    printf("cfifo record test passed!\n");
+    return 0;
+}
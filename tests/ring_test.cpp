@@ -0,0 +1,142 @@
+#include <cassert>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cfifo.hpp"
+
+struct counted {
+    static int alive;
+    int value;
+
+    explicit counted(int v) : value(v) { alive++; }
+    counted(const counted &other) : value(other.value) { alive++; }
+    counted(counted &&other) noexcept : value(other.value) { alive++; }
+    counted &operator=(const counted &) = default;
+    counted &operator=(counted &&) = default;
+    ~counted() { alive--; }
+};
+
+int counted::alive = 0;
+
+static_assert(cfifo::ring<int, 16>::capacity() == 16, "capacity");
+
+static void unique_ptr_test()
+{
+    cfifo::ring<std::unique_ptr<int>, 4> ring;
+    std::unique_ptr<int> p;
+    int i;
+
+    assert(ring.empty());
+    assert(ring.available() == 4);
+    assert(ring.front() == nullptr);
+    assert(!ring.try_pop(p));
+
+    for (i = 0; i < 4; i++)
+    {
+        p.reset(new int(i));
+        assert(ring.try_push(std::move(p)));
+        assert(!p);
+    }
+    p.reset(new int(4));
+    assert(!ring.try_push(std::move(p)));
+    /* A failed push leaves the argument alone. */
+    assert(p && *p == 4);
+    assert(ring.size() == 4);
+
+    assert(ring.front() != nullptr && **ring.front() == 0);
+    for (i = 0; i < 4; i++)
+    {
+        assert(ring.try_pop(p));
+        assert(*p == i);
+    }
+    assert(ring.empty());
+}
+
+static void emplace_test()
+{
+    {
+        cfifo::ring<counted, 8> ring;
+        counted c(0);
+
+        assert(counted::alive == 1);
+        assert(ring.emplace(1));
+        assert(ring.emplace(2));
+        assert(ring.try_push(counted(3)));
+        assert(counted::alive == 4);
+
+        assert(ring.try_pop(c));
+        assert(c.value == 1);
+        assert(counted::alive == 3);
+        ring.pop();
+        assert(counted::alive == 2);
+        /* Item 3 is destroyed with the ring. */
+    }
+    assert(counted::alive == 0);
+
+    {
+        cfifo::ring<std::vector<std::string>, 2> ring;
+        std::vector<std::string> v;
+
+        assert(ring.emplace(3, "abc"));
+        assert(ring.emplace(std::vector<std::string>{"x", "y"}));
+        assert(!ring.emplace(1, "z"));
+        assert(ring.try_pop(v));
+        assert(v.size() == 3 && v[2] == "abc");
+        assert(ring.try_pop(v));
+        assert(v.size() == 2 && v[1] == "y");
+    }
+}
+
+static void spsc_test()
+{
+    const int num_items = 100000;
+    cfifo::ring<std::unique_ptr<int>, 64> ring;
+
+    std::thread producer([&ring, num_items]() {
+        std::unique_ptr<int> item(new int(0));
+        int i = 0;
+        while (i < num_items)
+        {
+            if (ring.try_push(std::move(item)))
+            {
+                i++;
+                item.reset(new int(i));
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    std::unique_ptr<int> p;
+    int expected = 0;
+    while (expected < num_items)
+    {
+        if (ring.try_pop(p))
+        {
+            assert(*p == expected);
+            expected++;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    assert(ring.empty());
+}
+
+int main()
+{
+    unique_ptr_test();
+    emplace_test();
+    spsc_test();
+
+    std::printf("cfifo ring test passed!\r\n");
+
+    return 0;
+}
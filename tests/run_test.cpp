@@ -3,6 +3,8 @@
 #include <string.h>
 
 #include "cfifo.h"
+#include "cfifo_typed.h"
+#include "cfifo_index.h"
 
 struct test {
     uint8_t a;
@@ -11,13 +13,16 @@ struct test {
     uint8_t *d;
 };
 
+CFIFO_DECLARE_TYPED(test_fifo, struct test, 4);
+CFIFO_DECLARE_TYPED(u32_fifo, uint32_t, 16);
+
 void struct_test(void)
 {
     uint8_t b = 4;
     struct test s;
     struct test h;
     CFIFO_CREATE(fifo, struct test, 16);
-    assert(CFIFO_BUF_SIZE(sizeof(struct test), 7) == -1);
+    assert(CFIFO_BUF_SIZE(sizeof(struct test), 7) == (sizeof(struct test)*7));
     assert(CFIFO_BUF_SIZE(sizeof(struct test), 16) == (sizeof(struct test)*16));
     assert((fifo->num_items_mask + 1) == 16);
     
@@ -68,6 +73,490 @@ void contains_test(void) {
     assert(h.d == &b);
 }
 
+void bulk_test(void)
+{
+    uint8_t data[32];
+    uint8_t rdata[32];
+    size_t size;
+    size_t i;
+
+    CFIFO_CREATE(fifo, uint8_t, 16);
+
+    for (i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t) (i + 1);
+    }
+
+    /* Batches that wrap around the end of the buffer. */
+    size = 10;
+    assert(cfifo_write(fifo, data, &size) == CFIFO_SUCCESS);
+    assert(size == 10);
+    size = 10;
+    assert(cfifo_read(fifo, rdata, &size) == CFIFO_SUCCESS);
+    assert(size == 10);
+    size = 12;
+    assert(cfifo_write(fifo, data, &size) == CFIFO_SUCCESS);
+    assert(size == 12);
+    assert(cfifo_size(fifo) == 12);
+    size = 12;
+    assert(cfifo_read(fifo, rdata, &size) == CFIFO_SUCCESS);
+    assert(size == 12);
+    assert(memcmp(rdata, data, 12) == 0);
+
+    /* All-or-nothing variants. */
+    assert(cfifo_write_bulk(NULL, data, 1) == CFIFO_ERR_NULL);
+    assert(cfifo_write_bulk(fifo, NULL, 1) == CFIFO_ERR_NULL);
+    assert(cfifo_read_bulk(NULL, rdata, 1) == CFIFO_ERR_NULL);
+    assert(cfifo_read_bulk(fifo, NULL, 1) == CFIFO_ERR_NULL);
+    assert(cfifo_write_bulk(fifo, data, 17) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_read_bulk(fifo, rdata, 17) == CFIFO_ERR_BAD_SIZE);
+
+    assert(cfifo_read_bulk(fifo, rdata, 1) == CFIFO_ERR_EMPTY);
+    assert(cfifo_write_bulk(fifo, data, 11) == CFIFO_SUCCESS);
+    assert(cfifo_write_bulk(fifo, &data[11], 6) == CFIFO_ERR_FULL);
+    assert(cfifo_size(fifo) == 11);
+    assert(cfifo_write_bulk(fifo, &data[11], 5) == CFIFO_SUCCESS);
+    assert(cfifo_available(fifo) == 0);
+    assert(cfifo_write_bulk(fifo, data, 0) == CFIFO_SUCCESS);
+
+    memset(rdata, 0, sizeof(rdata));
+    assert(cfifo_read_bulk(fifo, rdata, 3) == CFIFO_SUCCESS);
+    assert(memcmp(rdata, data, 3) == 0);
+    assert(cfifo_read_bulk(fifo, &rdata[3], 14) == CFIFO_ERR_EMPTY);
+    assert(cfifo_read_bulk(fifo, &rdata[3], 13) == CFIFO_SUCCESS);
+    assert(memcmp(rdata, data, 16) == 0);
+    assert(cfifo_size(fifo) == 0);
+}
+
+void span_test(void)
+{
+    cfifo_span_t spans[2];
+    uint8_t a;
+    size_t i;
+
+    CFIFO_CREATE(fifo, uint8_t, 8);
+
+    assert(cfifo_reserve(NULL, spans) == CFIFO_ERR_NULL);
+    assert(cfifo_reserve(fifo, NULL) == CFIFO_ERR_NULL);
+    assert(cfifo_acquire(NULL, spans) == CFIFO_ERR_NULL);
+    assert(cfifo_acquire(fifo, NULL) == CFIFO_ERR_NULL);
+    assert(cfifo_commit(NULL, 1) == CFIFO_ERR_NULL);
+    assert(cfifo_release(NULL, 1) == CFIFO_ERR_NULL);
+
+    assert(cfifo_acquire(fifo, spans) == CFIFO_ERR_EMPTY);
+    assert(spans[0].num_items == 0 && spans[1].num_items == 0);
+    assert(cfifo_release(fifo, 1) == CFIFO_ERR_BAD_SIZE);
+
+    /* Whole buffer free, one span. */
+    assert(cfifo_reserve(fifo, spans) == CFIFO_SUCCESS);
+    assert(spans[0].p_data == fifo->p_buf);
+    assert(spans[0].num_items == 8);
+    assert(spans[1].num_items == 0);
+    for (i = 0; i < 5; i++)
+    {
+        spans[0].p_data[i] = (uint8_t) (10 + i);
+    }
+    assert(cfifo_size(fifo) == 0);
+    assert(cfifo_commit(fifo, 9) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_commit(fifo, 5) == CFIFO_SUCCESS);
+    assert(cfifo_size(fifo) == 5);
+
+    /* Read two in place, then one through the copying API. */
+    assert(cfifo_acquire(fifo, spans) == CFIFO_SUCCESS);
+    assert(spans[0].num_items == 5);
+    assert(spans[1].num_items == 0);
+    assert(spans[0].p_data[0] == 10 && spans[0].p_data[1] == 11);
+    assert(cfifo_release(fifo, 2) == CFIFO_SUCCESS);
+    assert(cfifo_get(fifo, &a) == CFIFO_SUCCESS);
+    assert(a == 12);
+
+    /* Free slots wrap: positions 5..7 and 0..2. */
+    assert(cfifo_reserve(fifo, spans) == CFIFO_SUCCESS);
+    assert(spans[0].p_data == &fifo->p_buf[5]);
+    assert(spans[0].num_items == 3);
+    assert(spans[1].p_data == fifo->p_buf);
+    assert(spans[1].num_items == 3);
+    spans[0].p_data[0] = 20;
+    spans[0].p_data[1] = 21;
+    spans[0].p_data[2] = 22;
+    spans[1].p_data[0] = 23;
+    assert(cfifo_commit(fifo, 4) == CFIFO_SUCCESS);
+    assert(cfifo_reserve(fifo, spans) == CFIFO_SUCCESS);
+    assert(spans[0].num_items == 2 && spans[1].num_items == 0);
+    assert(cfifo_commit(fifo, 2) == CFIFO_SUCCESS);
+    assert(cfifo_reserve(fifo, spans) == CFIFO_ERR_FULL);
+
+    /* Stored items wrap: 13, 14, 20, 21, 22 | 23, x, x. */
+    assert(cfifo_acquire(fifo, spans) == CFIFO_SUCCESS);
+    assert(spans[0].num_items == 5);
+    assert(spans[1].num_items == 3);
+    assert(spans[0].p_data[0] == 13 && spans[0].p_data[4] == 22);
+    assert(spans[1].p_data[0] == 23);
+    assert(cfifo_release(fifo, 6) == CFIFO_SUCCESS);
+    assert(cfifo_size(fifo) == 2);
+}
+
+void typed_test(void)
+{
+    test_fifo_t fifo;
+    u32_fifo_t u32 = CFIFO_TYPED_INIT;
+    struct test s;
+    struct test h;
+    uint32_t data[20];
+    uint32_t rdata[20];
+    size_t size;
+    uint32_t i;
+
+    test_fifo_init(&fifo);
+    assert(test_fifo_size(&fifo) == 0);
+    assert(test_fifo_available(&fifo) == 4);
+    assert(test_fifo_get(&fifo, &h) == CFIFO_ERR_EMPTY);
+    assert(test_fifo_peek(&fifo, &h) == CFIFO_ERR_EMPTY);
+
+    s.a = 1;
+    s.b = 2;
+    s.c = 3;
+    s.d = NULL;
+    for (i = 0; i < 4; i++)
+    {
+        s.c = i;
+        assert(test_fifo_put(&fifo, &s) == CFIFO_SUCCESS);
+    }
+    assert(test_fifo_put(&fifo, &s) == CFIFO_ERR_FULL);
+    assert(test_fifo_size(&fifo) == 4);
+    assert(test_fifo_peek(&fifo, &h) == CFIFO_SUCCESS);
+    assert(h.c == 0);
+    for (i = 0; i < 4; i++)
+    {
+        assert(test_fifo_get(&fifo, &h) == CFIFO_SUCCESS);
+        assert(h.a == 1 && h.b == 2 && h.c == i && h.d == NULL);
+    }
+    assert(test_fifo_get(&fifo, &h) == CFIFO_ERR_EMPTY);
+
+    for (i = 0; i < 20; i++)
+    {
+        data[i] = i * 3;
+    }
+    size = 10;
+    assert(u32_fifo_write(&u32, data, &size) == CFIFO_SUCCESS);
+    assert(size == 10);
+    size = 8;
+    assert(u32_fifo_read(&u32, rdata, &size) == CFIFO_SUCCESS);
+    assert(size == 8);
+    /* Wraps around the end of the buffer. */
+    size = 10;
+    assert(u32_fifo_write(&u32, &data[10], &size) == CFIFO_SUCCESS);
+    assert(size == 10);
+    size = 16;
+    assert(u32_fifo_write(&u32, data, &size) == CFIFO_SUCCESS);
+    assert(size == 4);
+    assert(u32_fifo_available(&u32) == 0);
+    size = 20;
+    assert(u32_fifo_read(&u32, rdata, &size) == CFIFO_SUCCESS);
+    assert(size == 16);
+    assert(rdata[0] == data[8] && rdata[1] == data[9]);
+    for (i = 0; i < 10; i++)
+    {
+        assert(rdata[2 + i] == data[10 + i]);
+    }
+    for (i = 0; i < 4; i++)
+    {
+        assert(rdata[12 + i] == data[i]);
+    }
+    assert(u32_fifo_size(&u32) == 0);
+}
+
+/* Reference count, walking the stored items like the unindexed version. */
+static size_t index_test_count(cfifo_t fifo, uint32_t key)
+{
+    cfifo_span_t spans[2];
+    size_t count = 0;
+    size_t i;
+    size_t j;
+
+    if (cfifo_acquire(fifo, spans) != CFIFO_SUCCESS)
+    {
+        return 0;
+    }
+    for (i = 0; i < 2; i++)
+    {
+        for (j = 0; j < spans[i].num_items; j++)
+        {
+            count += (memcmp(&spans[i].p_data[j * sizeof(key)], &key, sizeof(key)) == 0);
+        }
+    }
+    return count;
+}
+
+void index_test(void)
+{
+    struct cfifo_index_s index;
+    size_t table[CFIFO_INDEX_BUF_WORDS(sizeof(uint32_t), 16)];
+    uint32_t items[8];
+    uint32_t seed = 1;
+    uint32_t key;
+    cfifo_span_t spans[2];
+    size_t num;
+    size_t i;
+    int round;
+
+    CFIFO_CREATE(fifo, uint32_t, 8);
+
+    assert(cfifo_index_init(NULL, (uint8_t *) table, 16, 4, sizeof(table)) == CFIFO_ERR_NULL);
+    assert(cfifo_index_init(&index, (uint8_t *) table, 12, 4, sizeof(table)) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_index_init(&index, (uint8_t *) table, 16, 4, sizeof(table) - 1) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_index_init(&index, (uint8_t *) table, 8, 4, sizeof(table) / 2) == CFIFO_SUCCESS);
+    /* Not more entries than the capacity. */
+    assert(cfifo_attach_index(fifo, &index) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_index_init(&index, (uint8_t *) table, 16, 2, sizeof(table)) == CFIFO_SUCCESS);
+    assert(cfifo_attach_index(fifo, &index) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_attach_index(NULL, &index) == CFIFO_ERR_NULL);
+    assert(cfifo_attach_index(fifo, NULL) == CFIFO_ERR_NULL);
+
+    /* Items stored before attaching are counted. */
+    key = 7;
+    assert(cfifo_put(fifo, &key) == CFIFO_SUCCESS);
+    assert(cfifo_index_init(&index, (uint8_t *) table, 16, 4, sizeof(table)) == CFIFO_SUCCESS);
+    assert(cfifo_attach_index(fifo, &index) == CFIFO_SUCCESS);
+    assert(cfifo_contains(fifo, &key) == 1);
+
+    /* Random mix of all producer and consumer calls. */
+    for (round = 0; round < 20000; round++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        key = (seed >> 16) % ((round < 10000) ? 5 : 40);
+        switch ((seed >> 8) % 8)
+        {
+        case 0:
+        case 1:
+            (void) cfifo_put(fifo, &key);
+            break;
+        case 2:
+            for (i = 0; i < 8; i++)
+            {
+                items[i] = key + (uint32_t) (i & 1);
+            }
+            num = (seed >> 4) % 8;
+            assert(cfifo_write(fifo, items, &num) == CFIFO_SUCCESS);
+            break;
+        case 3:
+            if (cfifo_reserve(fifo, spans) == CFIFO_SUCCESS)
+            {
+                memcpy(spans[0].p_data, &key, sizeof(key));
+                assert(cfifo_commit(fifo, 1) == CFIFO_SUCCESS);
+            }
+            break;
+        case 4:
+            (void) cfifo_get(fifo, &items[0]);
+            break;
+        case 5:
+            num = (seed >> 4) % 8;
+            assert(cfifo_read(fifo, items, &num) == CFIFO_SUCCESS);
+            break;
+        case 6:
+            if ((seed >> 4) % 8 == 0)
+            {
+                assert(cfifo_flush(fifo) == CFIFO_SUCCESS);
+            }
+            break;
+        default:
+            break;
+        }
+
+        for (key = 0; key < 41; key++)
+        {
+            assert(cfifo_contains(fifo, &key) == index_test_count(fifo, key));
+        }
+        assert(index.num_keys == cfifo_size(fifo));
+    }
+
+    assert(cfifo_detach_index(fifo) == CFIFO_SUCCESS);
+    assert(cfifo_detach_index(NULL) == CFIFO_ERR_NULL);
+}
+
+struct scan_test_arg {
+    const uint8_t *p_key;
+    size_t item_size;
+};
+
+static int scan_test_pred(const void *p_item, void *p_arg)
+{
+    const struct scan_test_arg *p_scan = (const struct scan_test_arg *) p_arg;
+
+    return memcmp(p_item, p_scan->p_key, p_scan->item_size) == 0;
+}
+
+void scan_test(void)
+{
+    static const size_t item_sizes[] = {1, 2, 4, 8, 16, 3};
+    uint64_t buf_words[64 * 16 / sizeof(uint64_t)];
+    uint8_t *p_buf = (uint8_t *) buf_words;
+    struct cfifo_s fifo;
+    struct scan_test_arg arg;
+    uint8_t sink[16 * 16];
+    uint8_t item[16];
+    uint8_t key[16];
+    cfifo_span_t spans[2];
+    uint32_t seed = 1;
+    size_t item_size;
+    size_t count;
+    size_t first;
+    size_t num;
+    size_t s;
+    size_t i;
+    size_t j;
+    int round;
+
+    for (s = 0; s < sizeof(item_sizes) / sizeof(item_sizes[0]); s++)
+    {
+        item_size = item_sizes[s];
+        assert(cfifo_init(&fifo, p_buf, 64, item_size, 64 * item_size) == CFIFO_SUCCESS);
+        assert(cfifo_find(&fifo, key) == CFIFO_NOT_FOUND);
+
+        for (round = 0; round < 2000; round++)
+        {
+            /* Items differ from the key in at most one byte, wrapped around. */
+            seed = seed * 1103515245u + 12345u;
+            memset(item, 0x5a, item_size);
+            if ((seed >> 16) % 4 != 0)
+            {
+                item[(seed >> 8) % item_size] ^= (uint8_t) (1 + (seed >> 20) % 2);
+            }
+            if (cfifo_put(&fifo, item) == CFIFO_ERR_FULL || (seed >> 4) % 3 == 0)
+            {
+                num = (seed >> 12) % 16;
+                assert(cfifo_read(&fifo, sink, &num) == CFIFO_SUCCESS);
+            }
+
+            for (i = 0; i < 3; i++)
+            {
+                memset(key, 0x5a, item_size);
+                key[0] ^= (uint8_t) i;
+                arg.p_key = key;
+                arg.item_size = item_size;
+                count = cfifo_count_if(&fifo, scan_test_pred, &arg);
+                first = cfifo_find(&fifo, key);
+                assert(cfifo_contains(&fifo, key) == count);
+
+                /* Reference walk over the stored items, oldest first. */
+                num = 0;
+                j = CFIFO_NOT_FOUND;
+                if (cfifo_acquire(&fifo, spans) == CFIFO_SUCCESS)
+                {
+                    size_t k;
+                    size_t n = 0;
+
+                    for (k = 0; k < 2; k++)
+                    {
+                        size_t m;
+
+                        for (m = 0; m < spans[k].num_items; m++, n++)
+                        {
+                            if (memcmp(&spans[k].p_data[m * item_size], key, item_size) == 0)
+                            {
+                                j = (0 == num) ? n : j;
+                                num++;
+                            }
+                        }
+                    }
+                }
+                assert(count == num);
+                assert(first == j);
+            }
+        }
+    }
+
+    assert(cfifo_find(NULL, key) == CFIFO_NOT_FOUND);
+    assert(cfifo_find(&fifo, NULL) == CFIFO_NOT_FOUND);
+    assert(cfifo_count_if(&fifo, NULL, NULL) == 0);
+}
+
+/*
+ * A capacity that is not a power of 2, the positions wrap at twice the
+ * capacity. Every operation is checked against a plain reference copy.
+ */
+void odd_capacity_test(void)
+{
+    CFIFO_CREATE(fifo, uint32_t, 7);
+    struct cfifo_index_s index;
+    size_t table[CFIFO_INDEX_BUF_WORDS(sizeof(uint32_t), 8)];
+    cfifo_span_t spans[2];
+    uint32_t ref[7];
+    uint32_t items[7];
+    uint32_t next_in = 0;
+    uint32_t next_out = 0;
+    uint32_t seed = 7;
+    size_t num;
+    size_t i;
+    int round;
+
+    assert(fifo->pos_wrap == 14);
+    assert(cfifo_available(fifo) == 7);
+    assert(cfifo_enable_overwrite(fifo) == CFIFO_ERR_INVALID_STATE);
+    assert(cfifo_index_init(&index, (uint8_t *) table, 8, 4, sizeof(table)) == CFIFO_SUCCESS);
+    assert(cfifo_attach_index(fifo, &index) == CFIFO_SUCCESS);
+
+    for (round = 0; round < 5000; round++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        num = (seed >> 16) % 8;
+        for (i = 0; i < num; i++)
+        {
+            items[i] = next_in + (uint32_t) i;
+        }
+        if ((seed >> 8) % 2)
+        {
+            assert(cfifo_write(fifo, items, &num) == CFIFO_SUCCESS);
+        }
+        else if (cfifo_write_bulk(fifo, items, num) != CFIFO_SUCCESS)
+        {
+            num = 0;
+        }
+        next_in += (uint32_t) num;
+        assert(cfifo_size(fifo) == next_in - next_out);
+        assert(cfifo_available(fifo) == 7 - cfifo_size(fifo));
+        assert(fifo->write_pos < 14 && fifo->read_pos < 14);
+
+        /* The spans cover the stored items in order. */
+        assert(cfifo_acquire(fifo, spans) == (next_in != next_out ?
+                                              CFIFO_SUCCESS : CFIFO_ERR_EMPTY));
+        assert(spans[0].num_items + spans[1].num_items == next_in - next_out);
+        if (next_in != next_out)
+        {
+            assert(*(uint32_t *) spans[0].p_data == next_out);
+            assert(cfifo_find(fifo, &next_out) == 0);
+            assert(cfifo_contains(fifo, &next_out) == 1);
+        }
+
+        num = (seed >> 20) % 8;
+        assert(cfifo_read(fifo, ref, &num) == CFIFO_SUCCESS);
+        for (i = 0; i < num; i++)
+        {
+            assert(ref[i] == next_out + i);
+        }
+        next_out += (uint32_t) num;
+        assert(cfifo_contains(fifo, &next_in) == 0);
+    }
+
+    /* Fill up across the wrap point, then drain one at a time. */
+    assert(cfifo_flush(fifo) == CFIFO_SUCCESS);
+    next_out = next_in;
+    for (i = 0; i < 7; i++)
+    {
+        assert(cfifo_put(fifo, &next_in) == CFIFO_SUCCESS);
+        next_in++;
+    }
+    assert(cfifo_put(fifo, &next_in) == CFIFO_ERR_FULL);
+    assert(cfifo_reserve(fifo, spans) == CFIFO_ERR_FULL);
+    for (i = 0; i < 7; i++)
+    {
+        assert(cfifo_get(fifo, &ref[0]) == CFIFO_SUCCESS);
+        assert(ref[0] == next_out++);
+    }
+    assert(cfifo_get(fifo, &ref[0]) == CFIFO_ERR_EMPTY);
+    assert(cfifo_detach_index(fifo) == CFIFO_SUCCESS);
+}
+
 int main(void)
 {
 
@@ -81,6 +570,12 @@ int main(void)
 
     struct_test();
     contains_test();
+    bulk_test();
+    span_test();
+    typed_test();
+    index_test();
+    scan_test();
+    odd_capacity_test();
 
     CFIFO_CREATE(fifo, uint8_t, 16);
     assert(cfifo_available(fifo) == 16);
@@ -244,7 +739,7 @@ int main(void)
     memset(fifo, 0x00, sizeof(struct cfifo_s));
     assert(cfifo_init(fifo, rdata, 16, 1, 16) == CFIFO_SUCCESS);
     memset(fifo, 0x00, sizeof(struct cfifo_s));
-    assert(cfifo_init(fifo, rdata, 15, 1, 15) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_init(fifo, rdata, 0, 1, 0) == CFIFO_ERR_BAD_SIZE);
     memset(fifo, 0x00, sizeof(struct cfifo_s));
     assert(cfifo_init(fifo, rdata, 16, 1, 15) == CFIFO_ERR_BAD_SIZE);
     assert(cfifo_put(fifo, &a) == CFIFO_ERR_INVALID_STATE);
@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <assert.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "cfifo_seg.h"
+
+#define NUM_ITEMS   1000000
+#define BURST       5000
+
+static struct cfifo_seg_s shared;
+
+static void api_test(void)
+{
+    struct cfifo_seg_s seg;
+    uint32_t items[100];
+    uint32_t out[100];
+    uint32_t item;
+    size_t num;
+    uint32_t i;
+
+    assert(cfifo_seg_create(NULL, 8, 4, 2) == CFIFO_ERR_NULL);
+    assert(cfifo_seg_create(&seg, 6, 4, 2) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_seg_create(&seg, 8, 0, 2) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_seg_create(&seg, 8, 4, 2) == CFIFO_SUCCESS);
+    assert(cfifo_seg_segments(&seg) == 1);
+    assert(cfifo_seg_get(&seg, &item) == CFIFO_ERR_EMPTY);
+
+    /* 100 items need 13 segments of 8, nothing is ever full. */
+    for (i = 0; i < 100; i++)
+    {
+        items[i] = i;
+        assert(cfifo_seg_put(&seg, &items[i]) == CFIFO_SUCCESS);
+    }
+    assert(cfifo_seg_segments(&seg) == 13);
+    assert(cfifo_seg_size(&seg) == 100);
+
+    /* Draining shrinks it back, keeping two segments in the pool. */
+    num = 100;
+    assert(cfifo_seg_read(&seg, out, &num) == CFIFO_SUCCESS);
+    assert(num == 100);
+    for (i = 0; i < 100; i++)
+    {
+        assert(out[i] == i);
+    }
+    assert(cfifo_seg_get(&seg, &item) == CFIFO_ERR_EMPTY);
+    assert(cfifo_seg_segments(&seg) == 1);
+    assert(cfifo_size(&seg.pool) == 2);
+    assert(cfifo_seg_size(&seg) == 0);
+
+    /* Growing again takes the pooled segments first. */
+    num = 20;
+    assert(cfifo_seg_write(&seg, items, &num) == CFIFO_SUCCESS);
+    assert(num == 20);
+    assert(cfifo_seg_segments(&seg) == 3);
+    assert(cfifo_size(&seg.pool) == 0);
+    for (i = 0; i < 20; i++)
+    {
+        assert(cfifo_seg_get(&seg, &item) == CFIFO_SUCCESS);
+        assert(item == i);
+    }
+    num = 5;
+    assert(cfifo_seg_read(&seg, out, &num) == CFIFO_SUCCESS);
+    assert(num == 0);
+
+    assert(cfifo_seg_destroy(&seg) == CFIFO_SUCCESS);
+    assert(cfifo_seg_destroy(&seg) == CFIFO_ERR_INVALID_STATE);
+
+    /* Without a pool, and destroyed while still holding items. */
+    assert(cfifo_seg_create(&seg, 4, 4, 0) == CFIFO_SUCCESS);
+    num = 50;
+    assert(cfifo_seg_write(&seg, items, &num) == CFIFO_SUCCESS);
+    num = 30;
+    assert(cfifo_seg_read(&seg, out, &num) == CFIFO_SUCCESS);
+    assert(num == 30 && out[29] == 29);
+    assert(cfifo_seg_segments(&seg) == 6);
+    assert(cfifo_seg_destroy(&seg) == CFIFO_SUCCESS);
+}
+
+/* Bursts of BURST items, then a pause until the consumer caught up. */
+static void *producer(void *p_arg)
+{
+    uint32_t batch[16];
+    uint32_t i = 0;
+    size_t num;
+    size_t j;
+
+    (void) p_arg;
+    while (i < NUM_ITEMS)
+    {
+        if (i % 3 == 0)
+        {
+            assert(cfifo_seg_put(&shared, &i) == CFIFO_SUCCESS);
+            i++;
+        }
+        else
+        {
+            for (j = 0; j < 16; j++)
+            {
+                batch[j] = i + (uint32_t) j;
+            }
+            num = 16;
+            assert(cfifo_seg_write(&shared, batch, &num) == CFIFO_SUCCESS);
+            i += 16;
+        }
+        if (i % BURST < 17)
+        {
+            while (cfifo_seg_segments(&shared) > 1)
+            {
+                sched_yield();
+            }
+        }
+    }
+    return NULL;
+}
+
+static void concurrent_test(void)
+{
+    pthread_t thread;
+    uint32_t out[7];
+    uint32_t expected = 0;
+    size_t num;
+    size_t j;
+
+    assert(cfifo_seg_create(&shared, 64, sizeof(uint32_t), 4) == CFIFO_SUCCESS);
+    assert(pthread_create(&thread, NULL, producer, NULL) == 0);
+
+    while (expected < NUM_ITEMS)
+    {
+        if (expected % 2)
+        {
+            if (cfifo_seg_get(&shared, &out[0]) == CFIFO_SUCCESS)
+            {
+                assert(out[0] == expected);
+                expected++;
+            }
+        }
+        else
+        {
+            num = 7;
+            assert(cfifo_seg_read(&shared, out, &num) == CFIFO_SUCCESS);
+            for (j = 0; j < num; j++)
+            {
+                assert(out[j] == expected);
+                expected++;
+            }
+        }
+    }
+
+    assert(pthread_join(thread, NULL) == 0);
+    assert(cfifo_seg_size(&shared) == 0);
+    assert(cfifo_seg_destroy(&shared) == CFIFO_SUCCESS);
+}
+
+int main(void)
+{
+    api_test();
+    concurrent_test();
+    printf("seg_test passed\n");
+    return 0;
+}
@@ -0,0 +1,135 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "cfifo_shm.h"
+#include "cfifo_wait.h"
+
+#define NUM_ITEMS   100000
+
+struct record {
+    uint32_t seq;
+    uint32_t check;
+};
+
+static char name[64];
+
+/* Runs in a child process, with its own mapping of the segment. */
+static int consumer(void)
+{
+    cfifo_t fifo;
+    struct record rec;
+    uint32_t i;
+
+    if (cfifo_shm_attach(name, sizeof(struct record), &fifo) != CFIFO_SUCCESS)
+    {
+        return 1;
+    }
+    for (i = 0; i < NUM_ITEMS; i++)
+    {
+        if (cfifo_get_wait(fifo, &rec, NULL) != CFIFO_SUCCESS ||
+            rec.seq != i || rec.check != ~i)
+        {
+            return 2;
+        }
+    }
+    cfifo_shm_detach(fifo);
+    return 0;
+}
+
+static void api_test(void)
+{
+    struct cfifo_shm_hdr_s *p_hdr;
+    cfifo_t fifo;
+    cfifo_t other;
+    uint32_t a = 42;
+    uint32_t b = 0;
+
+    assert(cfifo_shm_create(NULL, 16, 4, &fifo) == CFIFO_ERR_NULL);
+    assert(cfifo_shm_create(name, 16, 4, NULL) == CFIFO_ERR_NULL);
+    assert(cfifo_shm_create(name, 0, 4, &fifo) == CFIFO_ERR_BAD_SIZE);
+    assert(cfifo_shm_attach(name, 4, &fifo) == CFIFO_ERR_INVALID_STATE);
+
+    assert(cfifo_shm_create(name, 16, 4, &fifo) == CFIFO_SUCCESS);
+    assert(cfifo_shm_create(name, 16, 4, &other) == CFIFO_ERR_INVALID_STATE);
+
+    /* Second mapping at another address sees the same fifo. */
+    assert(cfifo_shm_attach(name, 4, &other) == CFIFO_SUCCESS);
+    assert(other != fifo);
+    assert(cfifo_put(fifo, &a) == CFIFO_SUCCESS);
+    assert(cfifo_size(other) == 1);
+    assert(cfifo_get(other, &b) == CFIFO_SUCCESS);
+    assert(a == b);
+    assert(cfifo_shm_detach(other) == CFIFO_SUCCESS);
+
+    /* Layout checks. */
+    assert(cfifo_shm_attach(name, 8, &other) == CFIFO_ERR_MISMATCH);
+    p_hdr = (struct cfifo_shm_hdr_s *) (void *)
+            ((uint8_t *) fifo - offsetof(struct cfifo_shm_hdr_s, fifo));
+    p_hdr->version++;
+    assert(cfifo_shm_attach(name, 4, &other) == CFIFO_ERR_MISMATCH);
+    p_hdr->version--;
+    /* A matching stamp with a fifo that would not fit in the mapping. */
+    p_hdr->fifo.num_items_mask = 2 * 16 - 1;
+    assert(cfifo_shm_attach(name, 4, &other) == CFIFO_ERR_MISMATCH);
+    p_hdr->fifo.num_items_mask = 16 - 1;
+    p_hdr->fifo.pos_wrap = 16;
+    assert(cfifo_shm_attach(name, 4, &other) == CFIFO_ERR_MISMATCH);
+    p_hdr->fifo.pos_wrap = 0;
+    assert(cfifo_shm_attach(name, 4, &other) == CFIFO_SUCCESS);
+    assert(cfifo_shm_detach(other) == CFIFO_SUCCESS);
+
+    assert(cfifo_shm_detach(fifo) == CFIFO_SUCCESS);
+    assert(cfifo_shm_unlink(name) == CFIFO_SUCCESS);
+    assert(cfifo_shm_unlink(name) == CFIFO_ERR_INVALID_STATE);
+    assert(cfifo_shm_detach(NULL) == CFIFO_ERR_NULL);
+}
+
+static void process_test(void)
+{
+    cfifo_t fifo;
+    struct record rec;
+    pid_t pid;
+    int status;
+    uint32_t i;
+
+    assert(cfifo_shm_create(name, 64, sizeof(struct record), &fifo) == CFIFO_SUCCESS);
+    assert(cfifo_enable_wait(fifo) == CFIFO_SUCCESS);
+
+    pid = fork();
+    assert(pid >= 0);
+    if (0 == pid)
+    {
+        _exit(consumer());
+    }
+
+    for (i = 0; i < NUM_ITEMS; i++)
+    {
+        rec.seq = i;
+        rec.check = ~i;
+        assert(cfifo_put_wait(fifo, &rec, NULL) == CFIFO_SUCCESS);
+    }
+
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    assert(cfifo_shm_detach(fifo) == CFIFO_SUCCESS);
+    assert(cfifo_shm_unlink(name) == CFIFO_SUCCESS);
+}
+
+int main(void)
+{
+    snprintf(name, sizeof(name), "/cfifo_shm_test_%ld", (long) getpid());
+
+    api_test();
+    process_test();
+
+    printf("Tests passed!\n");
+
+    return 0;
+}
@@ -0,0 +1,149 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "cfifo.h"
+
+#define NUM_ITEMS   200000
+#define BATCH_SIZE  7
+
+struct item {
+    uint32_t seq;
+    uint32_t check;
+    uint8_t payload[24];
+};
+
+static void item_fill(struct item *p_item, uint32_t seq)
+{
+    p_item->seq = seq;
+    p_item->check = ~seq;
+    memset(p_item->payload, (int) (seq & 0xff), sizeof(p_item->payload));
+}
+
+static void item_verify(const struct item *p_item, uint32_t seq)
+{
+    size_t i;
+    assert(p_item->seq == seq);
+    assert(p_item->check == ~seq);
+    for (i = 0; i < sizeof(p_item->payload); i++)
+    {
+        assert(p_item->payload[i] == (seq & 0xff));
+    }
+}
+
+static void *producer(void *arg)
+{
+    cfifo_t fifo = (cfifo_t) arg;
+    struct item batch[BATCH_SIZE];
+    uint32_t seq = 0;
+    size_t num;
+    size_t i;
+
+    while (seq < NUM_ITEMS)
+    {
+        if (seq & 1)
+        {
+            /* Single item path. */
+            item_fill(&batch[0], seq);
+            if (cfifo_put(fifo, &batch[0]) == CFIFO_SUCCESS)
+            {
+                seq++;
+            }
+            else
+            {
+                sched_yield();
+            }
+            continue;
+        }
+
+        /* Batch path. */
+        num = BATCH_SIZE;
+        if (NUM_ITEMS - seq < num)
+        {
+            num = NUM_ITEMS - seq;
+        }
+        for (i = 0; i < num; i++)
+        {
+            item_fill(&batch[i], seq + (uint32_t) i);
+        }
+        assert(cfifo_write(fifo, batch, &num) == CFIFO_SUCCESS);
+        seq += (uint32_t) num;
+        if (0 == num)
+        {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+static void *consumer(void *arg)
+{
+    cfifo_t fifo = (cfifo_t) arg;
+    struct item batch[BATCH_SIZE];
+    uint32_t seq = 0;
+    size_t num;
+    size_t i;
+
+    while (seq < NUM_ITEMS)
+    {
+        if (seq & 1)
+        {
+            if (cfifo_get(fifo, &batch[0]) == CFIFO_SUCCESS)
+            {
+                item_verify(&batch[0], seq);
+                seq++;
+            }
+            else
+            {
+                sched_yield();
+            }
+            continue;
+        }
+
+        num = BATCH_SIZE;
+        assert(cfifo_read(fifo, batch, &num) == CFIFO_SUCCESS);
+        for (i = 0; i < num; i++)
+        {
+            item_verify(&batch[i], seq + (uint32_t) i);
+        }
+        seq += (uint32_t) num;
+        if (0 == num)
+        {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+static void run(cfifo_t fifo)
+{
+    pthread_t prod;
+    pthread_t cons;
+
+    assert(pthread_create(&cons, NULL, consumer, fifo) == 0);
+    assert(pthread_create(&prod, NULL, producer, fifo) == 0);
+    assert(pthread_join(prod, NULL) == 0);
+    assert(pthread_join(cons, NULL) == 0);
+
+    assert(cfifo_size(fifo) == 0);
+}
+
+int main(void)
+{
+    CFIFO_CREATE_STATIC(fifo, struct item, 64);
+    /* Not a power of 2, the positions wrap at 120. */
+    CFIFO_CREATE_STATIC(odd_fifo, struct item, 60);
+
+    run(fifo);
+    run(odd_fifo);
+
+    printf("cfifo spsc test passed!\r\n");
+
+    return 0;
+}
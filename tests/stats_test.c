@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include <assert.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "cfifo.h"
+
+#define NUM_ITEMS   200000
+
+static void api_test(void)
+{
+    CFIFO_CREATE(fifo, uint32_t, 8);
+    struct cfifo_stats_s stats;
+    uint32_t items[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+    uint32_t out[8];
+    size_t num;
+    size_t i;
+
+    assert(cfifo_stats_snapshot(NULL, &stats) == CFIFO_ERR_NULL);
+    assert(cfifo_stats_snapshot(fifo, NULL) == CFIFO_ERR_NULL);
+
+#if !defined(CFIFO_STATS)
+    stats.items_in = 1;
+    assert(cfifo_stats_snapshot(fifo, &stats) == CFIFO_ERR_INVALID_STATE);
+    assert(stats.items_in == 0);
+    (void) items;
+    (void) out;
+    (void) num;
+    (void) i;
+#else
+    assert(cfifo_stats_snapshot(fifo, &stats) == CFIFO_SUCCESS);
+    assert(stats.items_in == 0 && stats.items_out == 0);
+
+    /* One put, then a bulk write that fills the fifo. */
+    assert(cfifo_put(fifo, &items[0]) == CFIFO_SUCCESS);
+    assert(cfifo_write_bulk(fifo, &items[1], 7) == CFIFO_SUCCESS);
+    assert(cfifo_put(fifo, &items[0]) == CFIFO_ERR_FULL);
+    num = 1;
+    assert(cfifo_write(fifo, items, &num) == CFIFO_SUCCESS);
+    assert(num == 0);
+    assert(cfifo_write_bulk(fifo, items, 1) == CFIFO_ERR_FULL);
+
+    assert(cfifo_stats_snapshot(fifo, &stats) == CFIFO_SUCCESS);
+    assert(stats.items_in == 8);
+    assert(stats.full_rejects == 3);
+    assert(stats.high_watermark == 8);
+    /* Fill levels 1 and 8 after the two successful puts. */
+    assert(stats.occupancy[1] == 1);
+    assert(stats.occupancy[4] == 1);
+    for (i = 0, num = 0; i < CFIFO_STATS_BINS; i++)
+    {
+        num += stats.occupancy[i];
+    }
+    assert(num == 2);
+
+    /* Drain it, then fail every kind of get once. */
+    assert(cfifo_get(fifo, &out[0]) == CFIFO_SUCCESS);
+    num = 8;
+    assert(cfifo_read(fifo, out, &num) == CFIFO_SUCCESS);
+    assert(num == 7);
+    assert(cfifo_get(fifo, &out[0]) == CFIFO_ERR_EMPTY);
+    num = 1;
+    assert(cfifo_read(fifo, out, &num) == CFIFO_SUCCESS);
+    assert(num == 0);
+    assert(cfifo_read_bulk(fifo, out, 1) == CFIFO_ERR_EMPTY);
+
+    /* A zero sized read is not a reject. */
+    num = 0;
+    assert(cfifo_read(fifo, out, &num) == CFIFO_SUCCESS);
+
+    assert(cfifo_stats_snapshot(fifo, &stats) == CFIFO_SUCCESS);
+    assert(stats.items_out == 8);
+    assert(stats.empty_rejects == 3);
+    assert(stats.items_in == 8);
+
+    /* The watermark stays at its maximum. */
+    assert(cfifo_put(fifo, &items[0]) == CFIFO_SUCCESS);
+    assert(cfifo_stats_snapshot(fifo, &stats) == CFIFO_SUCCESS);
+    assert(stats.high_watermark == 8);
+    assert(stats.occupancy[1] == 2);
+#endif
+}
+
+#if defined(CFIFO_STATS)
+/* Many laps of one put and one get never show more than one item. */
+static void lap_test(int overwrite)
+{
+    CFIFO_CREATE(fifo, uint32_t, 16);
+    struct cfifo_stats_s stats;
+    uint32_t item;
+    uint32_t i;
+
+    if (overwrite)
+    {
+        assert(cfifo_enable_overwrite(fifo) == CFIFO_SUCCESS);
+    }
+    for (i = 0; i < 100; i++)
+    {
+        assert(cfifo_put(fifo, &i) == CFIFO_SUCCESS);
+        assert(cfifo_get(fifo, &item) == CFIFO_SUCCESS);
+        assert(item == i);
+    }
+
+    assert(cfifo_stats_snapshot(fifo, &stats) == CFIFO_SUCCESS);
+    assert(stats.items_in == 100 && stats.items_out == 100);
+    assert(stats.high_watermark == 1);
+    assert(stats.occupancy[1] == 100);
+}
+
+CFIFO_CREATE_STATIC(shared, uint32_t, 256);
+
+static int done;
+
+static void *producer(void *p_arg)
+{
+    uint32_t i;
+
+    (void) p_arg;
+    for (i = 0; i < NUM_ITEMS; i++)
+    {
+        while (cfifo_put(shared, &i) != CFIFO_SUCCESS)
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void *consumer(void *p_arg)
+{
+    uint32_t item;
+    uint32_t i;
+
+    (void) p_arg;
+    for (i = 0; i < NUM_ITEMS; i++)
+    {
+        while (cfifo_get(shared, &item) != CFIFO_SUCCESS)
+        {
+            sched_yield();
+        }
+        assert(item == i);
+    }
+    __atomic_store_n(&done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+/* Snapshots taken while both sides run must be consistent. */
+static void concurrent_test(void)
+{
+    pthread_t threads[2];
+    struct cfifo_stats_s stats;
+    size_t last_in = 0;
+    size_t last_out = 0;
+    size_t puts;
+    size_t i;
+
+    assert(pthread_create(&threads[0], NULL, consumer, NULL) == 0);
+    assert(pthread_create(&threads[1], NULL, producer, NULL) == 0);
+
+    while (!__atomic_load_n(&done, __ATOMIC_ACQUIRE))
+    {
+        assert(cfifo_stats_snapshot(shared, &stats) == CFIFO_SUCCESS);
+        assert(stats.items_out <= stats.items_in);
+        assert(stats.items_in >= last_in && stats.items_out >= last_out);
+        assert(stats.high_watermark <= 256);
+        for (i = 0, puts = 0; i < CFIFO_STATS_BINS; i++)
+        {
+            puts += stats.occupancy[i];
+        }
+        /* Each put is one item and one histogram entry. */
+        assert(puts == stats.items_in);
+        last_in = stats.items_in;
+        last_out = stats.items_out;
+        sched_yield();
+    }
+
+    assert(pthread_join(threads[0], NULL) == 0);
+    assert(pthread_join(threads[1], NULL) == 0);
+
+    assert(cfifo_stats_snapshot(shared, &stats) == CFIFO_SUCCESS);
+    assert(stats.items_in == NUM_ITEMS && stats.items_out == NUM_ITEMS);
+    assert(stats.occupancy[0] == 0);
+}
+#endif
+
+int main(void)
+{
+    api_test();
+#if defined(CFIFO_STATS)
+    lap_test(0);
+    lap_test(1);
+    concurrent_test();
+#endif
+    printf("stats_test passed\n");
+    return 0;
+}
@@ -0,0 +1,135 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <assert.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "cfifo_wait.h"
+
+#define NUM_ITEMS   100000
+
+CFIFO_CREATE_STATIC(shared, uint32_t, 16);
+
+static void deadline_in(struct timespec *p_ts, long ms)
+{
+    clock_gettime(CLOCK_MONOTONIC, p_ts);
+    p_ts->tv_sec += ms / 1000;
+    p_ts->tv_nsec += (ms % 1000) * 1000000L;
+    if (p_ts->tv_nsec >= 1000000000L)
+    {
+        p_ts->tv_sec++;
+        p_ts->tv_nsec -= 1000000000L;
+    }
+}
+
+static void *producer(void *arg)
+{
+    uint32_t i;
+
+    (void) arg;
+    for (i = 0; i < NUM_ITEMS; i++)
+    {
+        assert(cfifo_put_wait(shared, &i, NULL) == CFIFO_SUCCESS);
+    }
+    return NULL;
+}
+
+static void *late_producer(void *arg)
+{
+    struct timespec delay = { 0, 20000000L };
+    uint32_t a = 0xCAFE;
+
+    (void) arg;
+    /* Give the consumer time to go to sleep, then use the plain put. */
+    nanosleep(&delay, NULL);
+    assert(cfifo_put(shared, &a) == CFIFO_SUCCESS);
+    return NULL;
+}
+
+static void api_test(void)
+{
+    struct cfifo_s fifo;
+    uint32_t buf[4];
+    uint32_t a = 1;
+    struct timespec deadline;
+#if defined(CFIFO_STATS)
+    struct cfifo_stats_s stats;
+#endif
+
+    assert(cfifo_init(&fifo, (uint8_t *) buf, 4, sizeof(uint32_t), sizeof(buf)) == CFIFO_SUCCESS);
+
+    assert(cfifo_put_wait(&fifo, &a, NULL) == CFIFO_ERR_INVALID_STATE);
+    assert(cfifo_get_wait(&fifo, &a, NULL) == CFIFO_ERR_INVALID_STATE);
+    assert(cfifo_enable_wait(NULL) == CFIFO_ERR_NULL);
+    assert(cfifo_enable_wait(&fifo) == CFIFO_SUCCESS);
+    assert(cfifo_put_wait(NULL, &a, NULL) == CFIFO_ERR_NULL);
+    assert(cfifo_put_wait(&fifo, NULL, NULL) == CFIFO_ERR_NULL);
+    assert(cfifo_get_wait(NULL, &a, NULL) == CFIFO_ERR_NULL);
+    assert(cfifo_get_wait(&fifo, NULL, NULL) == CFIFO_ERR_NULL);
+
+    /* Nothing to wait for, the deadline does not matter. */
+    deadline_in(&deadline, 0);
+    assert(cfifo_put_wait(&fifo, &a, &deadline) == CFIFO_SUCCESS);
+    assert(cfifo_get_wait(&fifo, &a, &deadline) == CFIFO_SUCCESS);
+    assert(a == 1);
+
+    deadline_in(&deadline, 10);
+    assert(cfifo_get_wait(&fifo, &a, &deadline) == CFIFO_ERR_TIMEOUT);
+
+    while (cfifo_put(&fifo, &a) == CFIFO_SUCCESS)
+    {
+    }
+    deadline_in(&deadline, 10);
+    assert(cfifo_put_wait(&fifo, &a, &deadline) == CFIFO_ERR_TIMEOUT);
+    assert(cfifo_size(&fifo) == 4);
+    assert(fifo.put_waiters == 0 && fifo.get_waiters == 0);
+
+#if defined(CFIFO_STATS)
+    /* A call that waited and timed out is one reject, however long it spun. */
+    assert(cfifo_stats_snapshot(&fifo, &stats) == CFIFO_SUCCESS);
+    assert(stats.full_rejects == 2);
+    assert(stats.empty_rejects == 1);
+#endif
+}
+
+static void wake_test(void)
+{
+    pthread_t thread;
+    uint32_t a = 0;
+
+    /* A consumer sleeping in cfifo_get_wait() is woken by cfifo_put(). */
+    pthread_create(&thread, NULL, late_producer, NULL);
+    assert(cfifo_get_wait(shared, &a, NULL) == CFIFO_SUCCESS);
+    assert(a == 0xCAFE);
+    pthread_join(thread, NULL);
+}
+
+static void stress_test(void)
+{
+    pthread_t thread;
+    uint32_t a;
+    uint32_t i;
+
+    pthread_create(&thread, NULL, producer, NULL);
+    for (i = 0; i < NUM_ITEMS; i++)
+    {
+        assert(cfifo_get_wait(shared, &a, NULL) == CFIFO_SUCCESS);
+        assert(a == i);
+    }
+    pthread_join(thread, NULL);
+    assert(cfifo_size(shared) == 0);
+}
+
+int main(void)
+{
+    assert(cfifo_enable_wait(shared) == CFIFO_SUCCESS);
+
+    api_test();
+    wake_test();
+    stress_test();
+
+    printf("Tests passed!\n");
+
+    return 0;
+}